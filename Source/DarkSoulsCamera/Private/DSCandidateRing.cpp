@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSCandidateRing.h"
+#include "Algo/BinarySearch.h"
+#include "DSLineOfSightCache.h"
+#include "DSLockOnScoring.h"
+#include "Components/SceneComponent.h"
+
+static float GetYaw(const FVector& Origin, float X, float Y)
+{
+	return FMath::RadiansToDegrees(FMath::Atan2(Y - Origin.Y, X - Origin.X));
+}
+
+void FDSCandidateRing::Update(const FDSCandidateSet& Candidates, const FVector& Origin, float ResortTolerance)
+{
+	for (FEntry& Entry : Entries)
+		Entry.bSeen = false;
+
+	const int32 NumPrevious = Entries.Num();
+	bool bNeedsSort = false;
+
+	for (int32 i = 0; i < Candidates.Num(); i++)
+	{
+		USceneComponent* Target = Candidates.Targets[i];
+		const float Yaw = GetYaw(Origin, Candidates.X[i], Candidates.Y[i]);
+
+		const int32 Index = Find(Target);
+		if (Index == INDEX_NONE)
+		{
+			Entries.Add({ Target, Yaw, true });
+			bNeedsSort = true;
+			continue;
+		}
+
+		FEntry& Entry = Entries[Index];
+		Entry.bSeen = true;
+
+		// Small movements don't reorder the ring, so targets at similar angles don't swap places on every update
+		if (FMath::Abs(FMath::FindDeltaAngleDegrees(Entry.Yaw, Yaw)) > ResortTolerance)
+		{
+			Entry.Yaw = Yaw;
+			bNeedsSort = true;
+		}
+	}
+
+	// Keeps the order of the remaining entries
+	const int32 NumRemoved = Entries.RemoveAll([](const FEntry& Entry) { return !Entry.bSeen; });
+
+	if (bNeedsSort)
+	{
+		// Insertion sort, as only new and moved entries are out of place
+		for (int32 i = 1; i < Entries.Num(); i++)
+		{
+			for (int32 j = i; j > 0 && Entries[j - 1].Yaw > Entries[j].Yaw; j--)
+				Entries.Swap(j - 1, j);
+		}
+	}
+
+	// Indices only go stale when entries were added, removed or reordered
+	if (bNeedsSort || NumRemoved > 0 || Entries.Num() != NumPrevious)
+		RebuildIndices();
+}
+
+int32 FDSCandidateRing::Find(const USceneComponent* Target) const
+{
+	const int32* Index = EntryIndices.Find(Target);
+
+	// A pointer can outlive its target and be reused by a new one, so the entry's weak pointer has the final say
+	return Index && Entries[*Index].Target.Get() == Target ? *Index : INDEX_NONE;
+}
+
+void FDSCandidateRing::RebuildIndices()
+{
+	EntryIndices.Reset();
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		if (const USceneComponent* Target = Entries[i].Target.Get())
+			EntryIndices.Add(Target, i);
+	}
+}
+
+USceneComponent* FDSCandidateRing::FindNeighbor(const USceneComponent* CurrentTarget, const FVector& Origin, bool bRight, bool bWrap, const FDSLineOfSightCache* LineOfSight) const
+{
+	const int32 NumEntries = Entries.Num();
+	if (NumEntries == 0 || CurrentTarget == nullptr)
+		return nullptr;
+
+	const int32 Step = bRight ? 1 : -1;
+
+	float CurrentYaw;
+	int32 Start = Find(CurrentTarget);
+	if (Start != INDEX_NONE)
+	{
+		CurrentYaw = Entries[Start].Yaw;
+	}
+	else
+	{
+		// Position the search so the first step lands on the nearest entry in the requested direction
+		const FVector Location = CurrentTarget->GetComponentLocation();
+		CurrentYaw = GetYaw(Origin, Location.X, Location.Y);
+		const int32 Insert = Algo::LowerBoundBy(Entries, CurrentYaw, [](const FEntry& Entry) { return Entry.Yaw; });
+		Start = bRight ? Insert - 1 : Insert;
+	}
+
+	for (int32 n = 1; n <= NumEntries; n++)
+	{
+		const int32 Index = ((Start + Step * n) % NumEntries + NumEntries) % NumEntries;
+
+		// Entries come in order of how far round they are, so the first one at or past directly behind ends the search
+		const float Delta = FMath::FindDeltaAngleDegrees(CurrentYaw, Entries[Index].Yaw) * Step;
+		if (!bWrap && (Delta < 0.f || Delta >= 180.f))
+			return nullptr;
+
+		USceneComponent* Target = Entries[Index].Target.Get();
+		if (Target == nullptr || Target == CurrentTarget)
+			continue;
+
+		if (LineOfSight && LineOfSight->IsOccluded(Target))
+			continue;
+
+		return Target;
+	}
+	return nullptr;
+}
@@ -12,6 +12,13 @@
 #include "Kismet/KismetSystemLibrary.h"
 #include "DSTargetComponent.h"
 #include "DSLockArmComponent.h"
+#include "DSLockOnManager.h"
+#include "DSLockOnStats.h"
+#include "DSLockOnInputProcessor.h"
+#include "DSLockOnRecording.h"
+#include "Engine/LocalPlayer.h"
+#include "Framework/Application/SlateApplication.h"
+#include "GameFramework/PlayerController.h"
 
 //////////////////////////////////////////////////////////////////////////
 // ADSCharacter
@@ -24,6 +31,14 @@ ADSCharacter::ADSCharacter()
 	TargetSwitchMinDelaySeconds = .5f;
 	BreakLockMouseDelta = 10.f;
 	BrokeLockAimingCooldown = .5f;
+	bUseRawLockInput = true;
+	RawMouseTurnScale = .07f;
+	TargetSwitchSettleValue = .25f;
+	RawMouseWindowSeconds = 1.f / 60.f;
+	RawInputReadIndex = 0;
+	GestureState.LastSwitchTime = 0.0;
+	GestureState.MouseWindowStart = 0.0;
+	GestureState.bStickSettled = true;
 
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -81,6 +96,59 @@ void ADSCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputC
 	// Action inputs
 	PlayerInputComponent->BindAction("ToggleCameraLock", IE_Pressed, CameraLockArm, &UDSLockArmComponent::ToggleCameraLock);
 	PlayerInputComponent->BindAction("ToggleSoftLock", IE_Pressed, CameraLockArm, &UDSLockArmComponent::ToggleSoftLock);
+
+	RegisterRawInput();
+}
+
+void ADSCharacter::RegisterRawInput()
+{
+	UnregisterRawInput();
+
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	if (!bUseRawLockInput || LocalPlayer == nullptr || !FSlateApplication::IsInitialized())
+		return;
+
+	RawInputProcessor = MakeShared<FDSLockOnInputProcessor>(LocalPlayer->GetControllerId());
+	RawInputReadIndex = 0;
+	FSlateApplication::Get().RegisterInputPreProcessor(RawInputProcessor);
+}
+
+void ADSCharacter::UnregisterRawInput()
+{
+	if (!RawInputProcessor.IsValid())
+		return;
+
+	if (FSlateApplication::IsInitialized())
+		FSlateApplication::Get().UnregisterInputPreProcessor(RawInputProcessor);
+
+	RawInputProcessor.Reset();
+}
+
+void ADSCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Gestures applied in TickActor must land before the manager next updates the lock arms and steers the control rotation
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->AddTickPrerequisiteActor(this);
+}
+
+void ADSCharacter::UnPossessed()
+{
+	UnregisterRawInput();
+
+	Super::UnPossessed();
+}
+
+void ADSCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterRawInput();
+
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Find(GetWorld()))
+		Manager->RemoveTickPrerequisiteActor(this);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ADSCharacter::MoveForward(float Val)
@@ -88,8 +156,14 @@ void ADSCharacter::MoveForward(float Val)
 	if ((Controller != NULL) && (Val != 0.0f))
 	{
 		// find out which way is forward
-		const FRotator Rotation = CameraLockArm->CameraTarget == nullptr ? Controller->GetControlRotation() : (CameraLockArm->CameraTarget->GetOwner()->GetActorLocation() - GetActorLocation()).GetSafeNormal().Rotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
+		const FDSLockFrame& LockFrame = CameraLockArm->GetLockFrame();
+		if (LockFrame.bValid)
+		{
+			AddMovementInput(LockFrame.YawForward, Val);
+			return;
+		}
+
+		const FRotator YawRotation(0, Controller->GetControlRotation().Yaw, 0);
 
 		// get forward vector
 		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
@@ -102,8 +176,14 @@ void ADSCharacter::MoveRight(float Val)
 	if ((Controller != NULL) && (Val != 0.0f))
 	{
 		// find out which way is right
-		const FRotator Rotation = CameraLockArm->CameraTarget == nullptr ? Controller->GetControlRotation() : (CameraLockArm->CameraTarget->GetOwner()->GetActorLocation() - GetActorLocation()).GetSafeNormal().Rotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
+		const FDSLockFrame& LockFrame = CameraLockArm->GetLockFrame();
+		if (LockFrame.bValid)
+		{
+			AddMovementInput(LockFrame.YawRight, Val);
+			return;
+		}
+
+		const FRotator YawRotation(0, Controller->GetControlRotation().Yaw, 0);
 
 		// get right vector 
 		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
@@ -113,16 +193,24 @@ void ADSCharacter::MoveRight(float Val)
 
 void ADSCharacter::Turn(float Val)
 {
-	float TimeSinceLastTargetSwitch = GetWorld()->GetRealTimeSeconds() - LastTargetSwitchTime;
+	DS_LOCKON_RECORD_INPUT(CameraLockArm, Turn, Val);
+
+	const float Now = GetWorld()->GetRealTimeSeconds();
+	float TimeSinceLastTargetSwitch = Now - LastTargetSwitchTime;
 
 	if (CameraLockArm->IsCameraLockedToTarget())
 	{
+		// Raw input handles switching and breaking lock on event time
+		if (RawInputProcessor.IsValid())
+			return;
+
 		// Should break soft-lock?
 		if (CameraLockArm->bUseSoftLock && FMath::Abs(Val) > BreakLockMouseDelta)
 		{
-			CameraLockArm->BreakTargetLock();
-			BrokeLockTime = GetWorld()->GetRealTimeSeconds();
+			// Set first, so the break the arm publishes carries it
 			CameraLockArm->bSoftlockRequiresReset = true;
+			CameraLockArm->BreakTargetLock();
+			BrokeLockTime = Now;
 		}
 		// Should try switch target?
 		else if(FMath::Abs(Val) > TargetSwitchMouseDelta 
@@ -133,13 +221,13 @@ void ADSCharacter::Turn(float Val)
 			else
 				CameraLockArm->SwitchTarget(EDirection::Right);
 
-			LastTargetSwitchTime = GetWorld()->GetRealTimeSeconds();
+			LastTargetSwitchTime = Now;
 		}
 	}
 	else
 	{
 		// If camera lock was recently broken by a large mouse delta, allow a cooldown time to prevent erratic camera movement
-		bool bRecentlyBrokeLock = (GetWorld()->GetRealTimeSeconds() - BrokeLockTime) < BrokeLockAimingCooldown;	
+		bool bRecentlyBrokeLock = (Now - BrokeLockTime) < BrokeLockAimingCooldown;	
 		if(!bRecentlyBrokeLock)
 			AddControllerYawInput(Val);	
 	}	
@@ -147,17 +235,22 @@ void ADSCharacter::Turn(float Val)
 
 void ADSCharacter::LookUp(float Val)
 {
+	DS_LOCKON_RECORD_INPUT(CameraLockArm, LookUp, Val);
+
 	if (!CameraLockArm->IsCameraLockedToTarget())
 		AddControllerPitchInput(Val);
 }
 
 void ADSCharacter::TurnAtRate(float Val)
 {	
+	DS_LOCKON_RECORD_INPUT(CameraLockArm, TurnAtRate, Val);
+
 	// Ensure the analog stick returned to neutral since last target switch attempt
 	if (FMath::Abs(Val) < .1f)
 		bAnalogSettledSinceLastTargetSwitch = true;
 
-	if (CameraLockArm->IsCameraLockedToTarget() && (FMath::Abs(Val) > TargetSwitchAnalogValue) && bAnalogSettledSinceLastTargetSwitch)
+	// Raw input handles switching on event time, for the turn keys as well as the stick
+	if (!RawInputProcessor.IsValid() && CameraLockArm->IsCameraLockedToTarget() && (FMath::Abs(Val) > TargetSwitchAnalogValue) && bAnalogSettledSinceLastTargetSwitch)
 	{
 		if (Val < 0)
 			CameraLockArm->SwitchTarget(EDirection::Left);
@@ -175,6 +268,8 @@ void ADSCharacter::TurnAtRate(float Val)
 
 void ADSCharacter::LookUpAtRate(float Val)
 {
+	DS_LOCKON_RECORD_INPUT(CameraLockArm, LookUpAtRate, Val);
+
 	// calculate delta for this frame from the rate information
 	if (!CameraLockArm->IsCameraLockedToTarget())
 		AddControllerPitchInput(Val * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
@@ -185,15 +280,70 @@ void ADSCharacter::TickActor(float DeltaTime, enum ELevelTick TickType, FActorTi
 {
 	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
 
-	if (CameraLockArm->IsCameraLockedToTarget())
+	DS_LOCKON_SCOPE(CharacterTick);
+
+	// Decisions from input received since the last tick land before the lock-on manager ticks, see BeginPlay
+	ProcessRawLockInput();
+}
+
+void ADSCharacter::ProcessRawLockInput()
+{
+	if (!RawInputProcessor.IsValid())
+		return;
+
+	DSLockOnCore::FGestureConfig Config;
+	Config.SwitchMouseDelta = TargetSwitchMouseDelta;
+	Config.BreakMouseDelta = BreakLockMouseDelta;
+	Config.SwitchStickValue = TargetSwitchAnalogValue;
+	Config.SettleStickValue = TargetSwitchSettleValue;
+	Config.MouseWindowSeconds = RawMouseWindowSeconds;
+	Config.SwitchMinDelaySeconds = TargetSwitchMinDelaySeconds;
+	Config.MouseTurnScale = RawMouseTurnScale;
+
+	// If more arrived than the ring holds, the oldest events are gone
+	const uint32 NumRecorded = RawInputProcessor->GetNumRecorded();
+	RawInputReadIndex = FMath::Max(RawInputReadIndex, NumRecorded > FDSLockOnInputProcessor::Capacity ? NumRecorded - FDSLockOnInputProcessor::Capacity : 0u);
+
+	for (; RawInputReadIndex < NumRecorded; RawInputReadIndex++)
+	{
+		const FDSRawTurnEvent* Event = RawInputProcessor->GetEvent(RawInputReadIndex);
+		const bool bLocked = CameraLockArm->IsCameraLockedToTarget();
+
+		DSLockOnCore::ELockGesture Gesture;
+		if (Event->bStick)
+		{
+			Gesture = DSLockOnCore::DetectStickGesture(GestureState, Config, Event->Time, Event->Value, bLocked);
+		}
+		else
+		{
+			const float WindowDelta = RawInputProcessor->SumMouseSince(RawInputReadIndex, DSLockOnCore::GetMouseWindowStart(GestureState, Config, Event->Time));
+			Gesture = DSLockOnCore::DetectMouseGesture(GestureState, Config, Event->Time, WindowDelta, bLocked, CameraLockArm->bUseSoftLock);
+		}
+
+		// Applied straight away, so later events in the batch see the new lock state
+		ApplyLockGesture(Gesture);
+	}
+}
+
+void ADSCharacter::ApplyLockGesture(DSLockOnCore::ELockGesture Gesture)
+{
+	switch (Gesture)
 	{
-		// Vector from player to target
-		FVector TargetVect = CameraLockArm->CameraTarget->GetComponentLocation() - CameraLockArm->GetComponentLocation();
-		FRotator TargetRot = TargetVect.GetSafeNormal().Rotation();
-		FRotator CurrentRot = GetControlRotation();
-		FRotator NewRot = FMath::RInterpTo(CurrentRot, TargetRot, DeltaTime, LockonControlRotationRate);
-
-		// Update control rotation to face target
-		GetController()->SetControlRotation(NewRot);
+	case DSLockOnCore::ELockGesture::SwitchLeft:
+		CameraLockArm->SwitchTarget(EDirection::Left);
+		LastTargetSwitchTime = GetWorld()->GetRealTimeSeconds();
+		break;
+	case DSLockOnCore::ELockGesture::SwitchRight:
+		CameraLockArm->SwitchTarget(EDirection::Right);
+		LastTargetSwitchTime = GetWorld()->GetRealTimeSeconds();
+		break;
+	case DSLockOnCore::ELockGesture::BreakLock:
+		// Set first, so the break the arm publishes carries it
+		CameraLockArm->bSoftlockRequiresReset = true;
+		CameraLockArm->BreakTargetLock();
+		BrokeLockTime = GetWorld()->GetRealTimeSeconds();
+		break;
+	default:
+		break;
 	}
 }
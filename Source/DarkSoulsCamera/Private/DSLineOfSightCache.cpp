@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLineOfSightCache.h"
+#include "DSLockOnScoring.h"
+
+int32 FDSLineOfSightCache::Find(const USceneComponent* Target) const
+{
+	const int32* Index = EntryIndices.Find(Target);
+	return Index ? *Index : INDEX_NONE;
+}
+
+int32 FDSLineOfSightCache::FindPending(const FTraceHandle& Handle, int32 HintIndex) const
+{
+	// Pruning can move entries after a trace was issued, so the index stored with the trace is only a hint
+	if (Entries.IsValidIndex(HintIndex) && Entries[HintIndex].PendingTrace == Handle)
+		return HintIndex;
+
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		if (Entries[i].PendingTrace == Handle)
+			return i;
+	}
+	return INDEX_NONE;
+}
+
+int32 FDSLineOfSightCache::FindOrAdd(const USceneComponent* Target)
+{
+	const int32 Index = Find(Target);
+	if (Index != INDEX_NONE)
+		return Index;
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Target = Target;
+	Entry.IssueTime = 0.f;
+	Entry.ResultTime = 0.f;
+	Entry.bHasResult = false;
+	Entry.bVisible = true;
+	EntryIndices.Add(Target, Entries.Num() - 1);
+	return Entries.Num() - 1;
+}
+
+bool FDSLineOfSightCache::IsOccluded(const USceneComponent* Target) const
+{
+	const int32 Index = Find(Target);
+	return Index != INDEX_NONE && Entries[Index].bHasResult && !Entries[Index].bVisible;
+}
+
+bool FDSLineOfSightCache::IsVisible(const USceneComponent* Target) const
+{
+	const int32 Index = Find(Target);
+	return Index != INDEX_NONE && Entries[Index].bHasResult && Entries[Index].bVisible;
+}
+
+bool FDSLineOfSightCache::NeedsTrace(int32 Index, float Now, float TTL) const
+{
+	const FEntry& Entry = Entries[Index];
+	if (Entry.PendingTrace.IsValid())
+		return Now - Entry.IssueTime > 1.f;
+
+	return !Entry.bHasResult || Now - Entry.ResultTime >= TTL;
+}
+
+void FDSLineOfSightCache::RemoveOccluded(FDSCandidateSet& Candidates) const
+{
+	for (int32 i = Candidates.Num() - 1; i >= 0; i--)
+	{
+		if (IsOccluded(Candidates.Targets[i]))
+			Candidates.RemoveAtSwap(i);
+	}
+}
+
+int32 FDSLineOfSightCache::ExcludeOccluded(FDSCandidateSet& Candidates) const
+{
+	int32 NumExcluded = 0;
+	for (int32 i = 0; i < Candidates.Num(); i++)
+	{
+		if (IsOccluded(Candidates.Targets[i]))
+		{
+			Candidates.Exclude(i);
+			NumExcluded++;
+		}
+	}
+	return NumExcluded;
+}
+
+void FDSLineOfSightCache::Prune(float Now, float MaxAge)
+{
+	for (int32 i = Entries.Num() - 1; i >= 0; i--)
+	{
+		const FEntry& Entry = Entries[i];
+		if (Entry.PendingTrace.IsValid() || Now - Entry.ResultTime <= MaxAge)
+			continue;
+
+		EntryIndices.Remove(Entry.Target);
+		Entries.RemoveAtSwap(i, 1, false);
+
+		// The last entry moved into the gap
+		if (i < Entries.Num())
+			EntryIndices[Entries[i].Target] = i;
+	}
+}
@@ -1,17 +1,80 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DSLockArmComponent.h"
-#include "DrawDebugHelpers.h"
-#include "Kismet/KismetSystemLibrary.h"
-#include "DSTargetComponent.h"
+#include "Engine/World.h"
+#include "DSLockOnManager.h"
+#include "DSLockOnScoring.h"
+#include "DSLockOnCore.h"
+#include "DSLockOnStats.h"
+#include "DSLockOnRecording.h"
 #include "GameFramework/Pawn.h"
+#include "Camera/CameraComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Curves/CurveFloat.h"
+#include "Net/UnrealNetwork.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/CoreNet.h"
+#include "DSTargetComponent.h"
+#include "DSTargetPointComponent.h"
+#include "DSCharacter.h"
 
 #define print(text) if (GEngine) GEngine->AddOnScreenDebugMessage(-1, 4.f, FColor::Green, text)
 
 UDSLockArmComponent::UDSLockArmComponent()
 {
 	MaxTargetLockDistance = 750.f;
+	RangeBreakHysteresis = 0.f;
+	SoftLockFallbackRate = 0.f;
+	SoftLockShellTolerance = 10.f;
+	SoftLockShellAngle = 5.f;
+	LockLogicRate = 30.f;
+	IdleLockLogicRate = 10.f;
+	FarTargetLockLogicRate = 15.f;
+	FarTargetDistanceRatio = .75f;
+	Team = 0;
+	bScreenSpaceSelection = false;
+	ScreenMargin = .05f;
+	bUseScoringCurves = false;
+	AngleScoreCurve = nullptr;
+	AngleScoreWeight = 1.f;
+	DistanceScoreCurve = nullptr;
+	DistanceScoreWeight = 1.f;
+	ThreatScoreCurve = nullptr;
+	ThreatScoreWeight = 1.f;
+	RecencyScoreCurve = nullptr;
+	RecencyScoreWeight = 1.f;
+	LockLogicAccumulator = 0.f;
+	SoftLockShell.bOccludedCandidates = false;
+	SoftLockShell.bValid = false;
+	bCheckLineOfSight = true;
+	LineOfSightChannel = ECC_Visibility;
+	LineOfSightTTL = .2f;
+	OcclusionBreakDelay = .5f;
+	TargetOccludedTime = -1.f;
+	DeferredLock = EDeferredLock::None;
+	SwitchOrderTolerance = 2.f;
+	bWrapTargetSwitching = false;
+	LockFrameNumber = MAX_uint64;
+	bPredictiveTracking = false;
+	TrackingLeadSeconds = 0.f;
+	TrackingAlpha = .5f;
+	TrackingBeta = .2f;
+	TrackingGamma = .02f;
+	TrackingMaxLeadDistance = 150.f;
+	TrackingOvershootTolerance = 30.f;
+	bTrackerValid = false;
+	bCoherentArmProbe = true;
+	ArmProbeReuseDistance = 5.f;
+	ArmProbeReuseAngle = 2.f;
+	ArmProbeRefreshFrames = 10;
+	ArmProbeRefreshFraction = .5f;
+	ArmProbe.bValid = false;
+	ArmProbe.FrameNumber = 0;
 	bDrawDebug = true;
+	NetTargetSlack = 100.f;
+	PredictionSequence = 0;
+	bSuppressLockRequests = false;
+	SetIsReplicated(true);
 
 	TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
 	bUsePawnControlRotation = true; // Rotate the arm based on the controller
@@ -22,70 +85,177 @@ UDSLockArmComponent::UDSLockArmComponent()
 	CameraLagMaxDistance = 100.f;
 }
 
-void UDSLockArmComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+#if DS_LOCKON_STATS
+/* Bits written so far if Ar is a network bit writer, which every saving net archive is, or INDEX_NONE */
+static int64 GetNetBitsWritten(FArchive& Ar)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	return Ar.IsSaving() && Ar.IsNetArchive() ? static_cast<FBitWriter&>(Ar).GetNumBits() : INDEX_NONE;
+}
+#endif
 
-	if (IsCameraLockedToTarget())
-	{		
-		DrawDebugSphere(GetWorld(), CameraTarget->GetComponentLocation(), 20.f, 16, FColor::Red); //Draw target point
+bool FDSLockOnRepState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+#if DS_LOCKON_STATS
+	const int64 StartBits = GetNetBitsWritten(Ar);
+#endif
 
-		// Break lock if player is too far from target
-		if ((CameraTarget->GetComponentLocation() - GetComponentLocation()).Size() > MaxTargetLockDistance + CameraTarget->GetScaledSphereRadius())
-		{
-			if (bUseSoftLock)
-			{
-				// Try switch to a new target in range
-				if (UDSTargetComponent* NewCameraTarget = GetLockTarget())
-					LockToTarget(NewCameraTarget);
-				else
-					BreakTargetLock();
-			}
-			else 
-			{ 
-				BreakTargetLock(); 
-			}
-		}
+	uint8 Header = (bUseSoftLock ? 1 : 0) | (Target ? 2 : 0) | (bSoftlockRequiresReset ? 4 : 0) | ((Sequence & SequenceMask) << 3);
+	Ar.SerializeBits(&Header, 7);
+
+	if (Ar.IsLoading())
+	{
+		bUseSoftLock = (Header & 1) != 0;
+		bSoftlockRequiresReset = (Header & 4) != 0;
+		Sequence = (Header >> 3) & SequenceMask;
+		Target = nullptr;
 	}
-	else
-	{		
-		if (bUseSoftLock) // Attempt to auto target nearby enemy
-		{
-			if (UDSTargetComponent* NewCameraTarget = GetLockTarget())
-			{
-				if (!bSoftlockRequiresReset) // Soft-lock is reset?
-					LockToTarget(NewCameraTarget);
-			}
-			else // If player forcibly broke soft-lock, reset it when no target is within range
-			{
-				bSoftlockRequiresReset = false;
-			}
-		}
+
+	bOutSuccess = true;
+	if (Header & 2)
+	{
+		UObject* Object = Target;
+		bOutSuccess = Map->SerializeObject(Ar, USceneComponent::StaticClass(), Object);
+		Target = Cast<USceneComponent>(Object);
 	}
 
-	// Draw debug
-	if (bDrawDebug)
+#if DS_LOCKON_STATS
+	if (StartBits != INDEX_NONE)
 	{
-		for (UDSTargetComponent* Target : GetTargetComponents())
-		{
-			DrawDebugLine(GetWorld(), GetOwner()->GetActorLocation(), Target->GetComponentLocation(), FColor::Green);
-		}
+		DS_LOCKON_COUNT(NetStateBits, int32(GetNetBitsWritten(Ar) - StartBits));
+	}
+#endif
 
-		// Draw target inclusion sphere
-		DrawDebugSphere(GetWorld(), GetOwner()->GetActorLocation(), MaxTargetLockDistance, 32, FColor::Cyan);
+	return true;
+}
 
-		UKismetSystemLibrary::DrawDebugString(this, FVector::ZeroVector, bUseSoftLock ? "Soft-lock Enabled" : "Soft-lock Disabled", GetOwner(), FLinearColor::Green);
-		
-		if (bSoftlockRequiresReset)
-			UKismetSystemLibrary::DrawDebugString(this, FVector(0.f, 0.f, -10.f), "Soft-lock Requires Reset", GetOwner(), FLinearColor::Green);
+void UDSLockArmComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UDSLockArmComponent, ReplicatedLockState);
+}
+
+void UDSLockArmComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LineOfSightDelegate.BindUObject(this, &UDSLockArmComponent::OnLineOfSightTrace);
+	ArmProbeDelegate.BindUObject(this, &UDSLockArmComponent::OnArmProbeSweep);
+
+	BakeScoringTables();
+#if WITH_EDITOR
+	CurveChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddUObject(this, &UDSLockArmComponent::OnObjectPropertyChanged);
+#endif
+
+	// Acquisition, range-break and soft-lock updates run in the lock-on manager's batched update
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->RegisterLockArm(this);
+}
+
+void UDSLockArmComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Find(GetWorld()))
+		Manager->UnregisterLockArm(this);
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(CurveChangedHandle);
+#endif
+
+	// Results of traces still in flight find no entry or pending handle and are ignored
+	LineOfSight.Reset();
+	ArmProbe.PendingSweep.Invalidate();
+	ArmProbe.bValid = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDSLockArmComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	DS_LOCKON_SCOPE(TickComponent);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void UDSLockArmComponent::ApplyLockAction(DSLockOnCore::ELockAction Action, USceneComponent* NewCameraTarget)
+{
+	// The server runs the same update for this arm, so its results are never sent as requests
+	TGuardValue<bool> SuppressRequests(bSuppressLockRequests, true);
+
+	switch (Action)
+	{
+	case DSLockOnCore::ELockAction::LockToCandidate:
+		LockToTarget(NewCameraTarget);
+		break;
+	case DSLockOnCore::ELockAction::Break:
+		BreakTargetLock();
+		break;
+	case DSLockOnCore::ELockAction::ClearSoftlockReset:
+		bSoftlockRequiresReset = false;
+		OnLockStateChanged();
+		break;
+	default:
+		break;
 	}
 }
 
+void UDSLockArmComponent::BakeScoringTables()
+{
+	// An unset curve leaves its term out rather than adding a constant to every candidate
+	auto BakeTerm = [](DSLockOnCore::FScoreTable& Table, float& OutWeight, const UCurveFloat* Curve, float Weight, float Min, float Max, bool bAngle)
+	{
+		DSLockOnScoring::BakeScoreTable(Table, Curve, Min, Max, bAngle);
+		OutWeight = Curve ? Weight : 0.f;
+	};
+
+	// Threat and recency are sampled over their curves' own key range
+	auto GetTimeRange = [](const UCurveFloat* Curve, float& OutMin, float& OutMax)
+	{
+		OutMin = 0.f;
+		OutMax = 1.f;
+		if (Curve)
+			Curve->GetTimeRange(OutMin, OutMax);
+		if (OutMax <= OutMin)
+			OutMax = OutMin + 1.f;
+	};
+
+	float ThreatMin, ThreatMax, RecencyMin, RecencyMax;
+	GetTimeRange(ThreatScoreCurve, ThreatMin, ThreatMax);
+	GetTimeRange(RecencyScoreCurve, RecencyMin, RecencyMax);
+
+	BakeTerm(ScoringTables.Angle, ScoringTables.AngleWeight, AngleScoreCurve, AngleScoreWeight, 0.f, 1.f, true);
+	BakeTerm(ScoringTables.Distance, ScoringTables.DistanceWeight, DistanceScoreCurve, DistanceScoreWeight, 0.f, 1.f, false);
+	BakeTerm(ScoringTables.Threat, ScoringTables.ThreatWeight, ThreatScoreCurve, ThreatScoreWeight, ThreatMin, ThreatMax, false);
+	BakeTerm(ScoringTables.Recency, ScoringTables.RecencyWeight, RecencyScoreCurve, RecencyScoreWeight, 0.f, RecencyMax, false);
+}
+
+#if WITH_EDITOR
+void UDSLockArmComponent::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event)
+{
+	if (Object && (Object == AngleScoreCurve || Object == DistanceScoreCurve || Object == ThreatScoreCurve || Object == RecencyScoreCurve))
+		BakeScoringTables();
+}
+#endif
+
+float UDSLockArmComponent::GetLockLogicRate()
+{
+	const FDSLockFrame& Frame = GetLockFrame();
+	if (!Frame.bValid)
+		return IdleLockLogicRate;
+
+	return Frame.Distance > MaxTargetLockDistance * FarTargetDistanceRatio ? FarTargetLockLogicRate : LockLogicRate;
+}
+
 void UDSLockArmComponent::ToggleCameraLock()
 {
+	DS_LOCKON_RECORD_INPUT(this, ToggleCameraLock, 1.f);
+
 	if (bUseSoftLock)   // Soft-lock supersedes player input
 	{
-		bSoftlockRequiresReset = false;
+		if (bSoftlockRequiresReset)
+		{
+			bSoftlockRequiresReset = false;
+			OnLockStateChanged();
+		}
 		return;
 	}
 
@@ -96,7 +266,14 @@ void UDSLockArmComponent::ToggleCameraLock()
 		return;
 	}
 
-	UDSTargetComponent* NewCameraTarget = GetLockTarget();
+	// A second press takes back a lock still waiting on its trace
+	if (DeferredLock == EDeferredLock::Lock)
+	{
+		DeferredLock = EDeferredLock::None;
+		return;
+	}
+
+	USceneComponent* NewCameraTarget = GetLockTarget();
 
 	if(NewCameraTarget != nullptr)
 	{
@@ -107,7 +284,11 @@ void UDSLockArmComponent::ToggleCameraLock()
 
 void UDSLockArmComponent::ToggleSoftLock()
 {
+	DS_LOCKON_RECORD_INPUT(this, ToggleSoftLock, 1.f);
+
+	const bool bWasLocked = IsCameraLockedToTarget();
 	bUseSoftLock = !bUseSoftLock;
+	SoftLockShell.bValid = false;
 
 	if (bUseSoftLock)
 	{
@@ -119,108 +300,521 @@ void UDSLockArmComponent::ToggleSoftLock()
 		BreakTargetLock();
 		print(TEXT("Soft-lock disabled"));
 	}
+
+	// Breaking the lock already published the change
+	if (bUseSoftLock || !bWasLocked)
+		OnLockStateChanged();
 }
 
-void UDSLockArmComponent::LockToTarget(UDSTargetComponent* NewTargetComponent)
+void UDSLockArmComponent::LockToTarget(USceneComponent* NewTargetComponent)
 {
+	if (CameraTarget == nullptr)
+	{
+		DS_LOCKON_COUNT(Acquisitions, 1);
+	}
+	else if (CameraTarget != NewTargetComponent)
+	{
+		DS_LOCKON_COUNT(Switches, 1);
+	}
+
 	CameraTarget = NewTargetComponent;
+	RecentTargets.Add(NewTargetComponent, GetWorld()->GetTimeSeconds());
+	SoftLockShell.bValid = false;
+	TargetOccludedTime = -1.f;
+	LockFrameNumber = MAX_uint64;
+	bTrackerValid = false;
 	bEnableCameraRotationLag = true;
 	//GetCharacterMovement()->bOrientRotationToMovement = false;
+
+	OnLockStateChanged();
 }
 
 void UDSLockArmComponent::BreakTargetLock()
 {
 	if (IsCameraLockedToTarget())
 	{
+		DS_LOCKON_COUNT(Breaks, 1);
+
 		CameraTarget = nullptr;
+		SoftLockShell.bValid = false;
+		TargetOccludedTime = -1.f;
+		LockFrameNumber = MAX_uint64;
+		bTrackerValid = false;
 		//GetController()->SetControlRotation(FollowCamera->GetForwardVector().Rotation());
 		bEnableCameraRotationLag = false;
 		//GetCharacterMovement()->bOrientRotationToMovement = true;
+
+		OnLockStateChanged();
+	}
+}
+
+void UDSLockArmComponent::OnLockStateChanged()
+{
+	const AActor* Owner = GetOwner();
+	if (Owner == nullptr)
+		return;
+
+	if (Owner->Role == ROLE_Authority)
+	{
+		// Only sent to clients when it differs from what they last received
+		ReplicatedLockState.Target = CameraTarget;
+		ReplicatedLockState.bUseSoftLock = bUseSoftLock;
+		ReplicatedLockState.bSoftlockRequiresReset = bSoftlockRequiresReset;
+	}
+	else if (Owner->Role == ROLE_AutonomousProxy && !bSuppressLockRequests)
+	{
+		PredictionSequence = (PredictionSequence + 1) & FDSLockOnRepState::SequenceMask;
+		DS_LOCKON_COUNT(NetRequests, 1);
+		ServerSetLockState(CameraTarget, bUseSoftLock, bSoftlockRequiresReset, PredictionSequence);
+	}
+}
+
+bool UDSLockArmComponent::ServerSetLockState_Validate(USceneComponent* NewTarget, bool bNewUseSoftLock, bool bNewSoftlockRequiresReset, uint8 Sequence)
+{
+	return true;
+}
+
+void UDSLockArmComponent::ServerSetLockState_Implementation(USceneComponent* NewTarget, bool bNewUseSoftLock, bool bNewSoftlockRequiresReset, uint8 Sequence)
+{
+	// The client picked the target from its own view of the world, so check it against the server's with some slack for
+	// latency. The server traces the same candidates, so a target it has seen behind a wall is refused, but one it hasn't
+	// traced yet is given the benefit of the doubt
+	const bool bValidTarget = NewTarget == nullptr
+		|| ((Cast<UDSTargetComponent>(NewTarget) || Cast<UDSTargetPointComponent>(NewTarget))
+			&& !NewTarget->IsPendingKill()
+			&& NewTarget->GetOwner() != GetOwner()
+			&& (Team == 0 || ADSLockOnManager::GetTargetTeam(NewTarget) != Team)
+			&& !(bCheckLineOfSight && LineOfSight.IsOccluded(NewTarget))
+			&& !DSLockOnCore::IsOutOfRange(FVector::Dist(GetComponentLocation(), NewTarget->GetComponentLocation()),
+				ADSLockOnManager::GetTargetRadius(NewTarget), MaxTargetLockDistance, RangeBreakHysteresis + NetTargetSlack));
+
+	if (bUseSoftLock != bNewUseSoftLock)
+	{
+		bUseSoftLock = bNewUseSoftLock;
+		bSoftlockRequiresReset = false;
+		SoftLockShell.bValid = false;
+	}
+
+	// A soft-lock break holds here until this server's own update clears it, so the next batch doesn't re-acquire.
+	// The client only sends it cleared after clearing it on purpose, e.g. by pressing lock
+	if (bSoftlockRequiresReset != bNewSoftlockRequiresReset)
+	{
+		bSoftlockRequiresReset = bNewUseSoftLock && bNewSoftlockRequiresReset;
+		SoftLockShell.bValid = false;
+	}
+
+	if (bValidTarget && NewTarget == nullptr)
+		BreakTargetLock();
+	else if (bValidTarget && NewTarget != CameraTarget)
+		LockToTarget(NewTarget);
+
+	// Acknowledging the sequence replicates the state even if the request was rejected, which corrects the client
+	ReplicatedLockState.Sequence = Sequence;
+	OnLockStateChanged();
+}
+
+void UDSLockArmComponent::OnRep_LockState()
+{
+	DS_LOCKON_COUNT(NetStateUpdates, 1);
+
+	// The owning client ignores state acknowledging an older prediction. The reply to its latest is still on the way
+	const AActor* Owner = GetOwner();
+	const bool bPredicting = Owner && Owner->Role == ROLE_AutonomousProxy;
+	if (bPredicting && ReplicatedLockState.Sequence != PredictionSequence)
+		return;
+
+	if (CameraTarget == ReplicatedLockState.Target && bUseSoftLock == ReplicatedLockState.bUseSoftLock
+		&& bSoftlockRequiresReset == ReplicatedLockState.bSoftlockRequiresReset)
+		return;
+
+	if (bPredicting)
+	{
+		DS_LOCKON_COUNT(NetCorrections, 1);
+	}
+
+	TGuardValue<bool> SuppressRequests(bSuppressLockRequests, true);
+
+	if (bUseSoftLock != ReplicatedLockState.bUseSoftLock)
+	{
+		bUseSoftLock = ReplicatedLockState.bUseSoftLock;
+		SoftLockShell.bValid = false;
+	}
+
+	if (bSoftlockRequiresReset != ReplicatedLockState.bSoftlockRequiresReset)
+	{
+		bSoftlockRequiresReset = ReplicatedLockState.bSoftlockRequiresReset;
+		SoftLockShell.bValid = false;
 	}
+
+	if (ReplicatedLockState.Target)
+		LockToTarget(ReplicatedLockState.Target);
+	else
+		BreakTargetLock();
+}
+
+bool UDSLockArmComponent::RunsLockLogic() const
+{
+	const AActor* Owner = GetOwner();
+	return Owner == nullptr || Owner->Role != ROLE_SimulatedProxy;
 }
 
-UDSTargetComponent* UDSLockArmComponent::GetLockTarget()
+USceneComponent* UDSLockArmComponent::GetLockTarget()
 {
-	TArray<UDSTargetComponent*> AvailableTargets = GetTargetComponents();
-	if (AvailableTargets.Num() == 0)
+	DS_LOCKON_SCOPE(GetLockTarget);
+
+	FDSCandidateSet& Candidates = CandidateScratch;
+	GatherCandidates(Candidates);
+	DS_LOCKON_COUNT(Candidates, Candidates.Num());
+
+	// Seed the switching order so a switch straight after locking doesn't wait for the next logic update
+	CandidateRing.Update(Candidates, GetComponentLocation(), SwitchOrderTolerance);
+
+	if (bCheckLineOfSight)
+		LineOfSight.RemoveOccluded(Candidates);
+
+	if (Candidates.Num() == 0)
 		return nullptr;
 
-	// Get the target with the smallest angle difference from the camera forward vector
-	float ClosestDotToCenter = 0.f;
-	UDSTargetComponent* TargetComponent = nullptr;
+	// Get the target closest to the center of the screen, or with the smallest angle difference from the camera forward vector
+	FMatrix ViewProjection;
+	if (bScreenSpaceSelection && GetCameraViewProjection(ViewProjection))
+		DSLockOnScoring::ScoreCandidatesOnScreen(Candidates, ViewProjection, ScreenMargin);
+	DSLockOnScoring::ScoreCandidates(Candidates, GetComponentLocation(), GetForwardVector());
 
-	for (int32 i = 0; i < AvailableTargets.Num(); i++)
+	int32 BestIdx;
+	if (const DSLockOnCore::FScoringTables* Tables = GetScoringTables())
 	{
-		float Dot = FVector::DotProduct(GetForwardVector(), (AvailableTargets[i]->GetComponentLocation() - GetComponentLocation()).GetSafeNormal());
-		if (Dot > ClosestDotToCenter)
-		{
-			ClosestDotToCenter = Dot;
-			TargetComponent = AvailableTargets[i];
-		}
+		DSLockOnScoring::ScoreWithTables(Candidates, *Tables, MaxTargetLockDistance, RecentTargets, GetWorld()->GetTimeSeconds());
+		BestIdx = DSLockOnScoring::SelectLockTargetByScore(Candidates);
+	}
+	else
+	{
+		BestIdx = DSLockOnScoring::SelectLockTarget(Candidates);
+	}
+
+	if (BestIdx == INDEX_NONE)
+		return nullptr;
+
+	// A target that only just entered range hasn't been traced, and may be behind a wall
+	if (bCheckLineOfSight && !LineOfSight.IsVisible(Candidates.Targets[BestIdx]))
+	{
+		QueueLineOfSightTraces(Candidates);
+		DeferredLock = EDeferredLock::Lock;
+		return nullptr;
 	}
-	return TargetComponent;
+
+	return Candidates.Targets[BestIdx];
 }
 
 void UDSLockArmComponent::SwitchTarget(EDirection SwitchDirection)
 {
+	DS_LOCKON_SCOPE(SwitchTarget);
+
+	// A newer switch replaces one still waiting on its trace
+	DeferredLock = EDeferredLock::None;
+
 	if (!IsCameraLockedToTarget()) return;
 
-	TArray<UDSTargetComponent*> AvailableTargets = GetTargetComponents();	// Get targets within lock-on range	
-	if (AvailableTargets.Num() < 2) return;	// Must have an existing camera target and 1 additional target
+	// Step to the neighbouring target in the bearing-sorted ring kept by the lock update, rather than querying and scanning every target in range
+	USceneComponent* NewTarget = CandidateRing.FindNeighbor(CameraTarget, GetComponentLocation(), SwitchDirection == EDirection::Right, bWrapTargetSwitching,
+		bCheckLineOfSight ? &LineOfSight : nullptr);
+	if (NewTarget == nullptr) return;
+
+	if (bCheckLineOfSight && !LineOfSight.IsVisible(NewTarget))
+	{
+		QueueLineOfSightTrace(NewTarget, GetWorld()->GetTimeSeconds());
+		DeferredLock = SwitchDirection == EDirection::Right ? EDeferredLock::SwitchRight : EDeferredLock::SwitchLeft;
+		return;
+	}
+
+	LockToTarget(NewTarget);
+}
+
+void UDSLockArmComponent::RetryDeferredLock()
+{
+	const EDeferredLock Request = DeferredLock;
+	DeferredLock = EDeferredLock::None;
+
+	switch (Request)
+	{
+	case EDeferredLock::Lock:
+		// Soft-lock, or a lock made in the meantime, supersedes the request
+		if (!bUseSoftLock && !IsCameraLockedToTarget())
+		{
+			if (USceneComponent* NewCameraTarget = GetLockTarget())
+				LockToTarget(NewCameraTarget);
+		}
+		break;
+	case EDeferredLock::SwitchLeft:
+		SwitchTarget(EDirection::Left);
+		break;
+	case EDeferredLock::SwitchRight:
+		SwitchTarget(EDirection::Right);
+		break;
+	default:
+		break;
+	}
+}
+
+TArray<USceneComponent*> UDSLockArmComponent::GetTargetComponents()
+{
+	DS_LOCKON_SCOPE(GetTargetComponents);
+
+	TArray<USceneComponent*> TargetComps;
+
+	// Read candidates from the lock-on manager's cached positions rather than running a physics overlap
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->GetTargetsInRadius(GetComponentLocation(), MaxTargetLockDistance, GetOwner(), TargetComps, Team);
+
+	return TargetComps;
+}
+
+void UDSLockArmComponent::GatherCandidates(FDSCandidateSet& OutCandidates)
+{
+	OutCandidates.Reset();
+
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->GatherCandidates(GetComponentLocation(), MaxTargetLockDistance, GetOwner(), OutCandidates, Team);
+}
+
+void UDSLockArmComponent::QueueLineOfSightTraces(const FDSCandidateSet& Candidates)
+{
+	if (!bCheckLineOfSight)
+		return;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	LineOfSight.Prune(Now, 10.f * LineOfSightTTL);
+
+	for (const USceneComponent* Target : Candidates.Targets)
+		QueueLineOfSightTrace(Target, Now);
+
+	// The locked target may be beyond lock distance but still within range-break hysteresis
+	if (CameraTarget)
+		QueueLineOfSightTrace(CameraTarget, Now);
+}
+
+void UDSLockArmComponent::QueueLineOfSightTrace(const USceneComponent* Target, float Now)
+{
+	const int32 Index = LineOfSight.FindOrAdd(Target);
+	if (!LineOfSight.NeedsTrace(Index, Now, LineOfSightTTL))
+		return;
 
-	FVector CurrentTargetDir = (CameraTarget->GetComponentLocation() - GetComponentLocation()).GetSafeNormal();
+	// Neither the viewer nor the target's own body should block the trace
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(DSLockOnLineOfSight), false, GetOwner());
+	Params.AddIgnoredActor(Target->GetOwner());
 
-	TArray<UDSTargetComponent*> ViableTargets;
+	FDSLineOfSightCache::FEntry& Entry = LineOfSight.Entries[Index];
+	Entry.IssueTime = Now;
+	Entry.PendingTrace = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, GetComponentLocation(), Target->GetComponentLocation(), LineOfSightChannel,
+		Params, FCollisionResponseParams::DefaultResponseParam, &LineOfSightDelegate, Index);
+}
 
-	for (UDSTargetComponent* Target : AvailableTargets)
+void UDSLockArmComponent::OnLineOfSightTrace(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	const int32 Index = LineOfSight.FindPending(Handle, Datum.UserData);
+	if (Index == INDEX_NONE)
+		return;
+
+	FDSLineOfSightCache::FEntry& Entry = LineOfSight.Entries[Index];
+	const bool bVisible = Datum.OutHits.Num() == 0 || !Datum.OutHits[0].bBlockingHit;
+	const bool bChanged = !Entry.bHasResult || Entry.bVisible != bVisible;
+
+	Entry.PendingTrace.Invalidate();
+	Entry.ResultTime = GetWorld()->GetTimeSeconds();
+	Entry.bHasResult = true;
+	Entry.bVisible = bVisible;
+
+	// Lock breaks on sustained occlusion only, so a pillar passing through the view doesn't drop the target
+	if (Entry.Target == CameraTarget)
 	{
-		//  Don't consider current target as a switch target
-		if (Target == CameraTarget) continue;
+		if (bVisible)
+			TargetOccludedTime = -1.f;
+		else if (TargetOccludedTime < 0.f)
+			TargetOccludedTime = Entry.ResultTime;
+	}
 
-		FVector TargetDir = (Target->GetComponentLocation() - GetComponentLocation()).GetSafeNormal();
-		FVector Cross = FVector::CrossProduct(CurrentTargetDir, TargetDir);
+	// A target coming into or out of view can change what an idle soft-lock would pick
+	if (bChanged)
+		SoftLockShell.bValid = false;
+}
 
-		if ((SwitchDirection == EDirection::Left && Cross.Z < 0.f)	// Negative Z indicates left
-			|| (SwitchDirection == EDirection::Right && Cross.Z > 0.f))	// Positive Z indicates right
+bool UDSLockArmComponent::GetCameraViewProjection(FMatrix& OutViewProjection)
+{
+	for (USceneComponent* Child : GetAttachChildren())
+	{
+		if (UCameraComponent* Camera = Cast<UCameraComponent>(Child))
 		{
-			ViableTargets.AddUnique(Target);
+			FMinimalViewInfo ViewInfo;
+			Camera->GetCameraView(0.f, ViewInfo);
+
+			FMatrix ViewMatrix;
+			FMatrix ProjectionMatrix;
+			UGameplayStatics::GetViewProjectionMatrix(ViewInfo, ViewMatrix, ProjectionMatrix, OutViewProjection);
+			return true;
 		}
 	}
+	return false;
+}
+
+bool UDSLockArmComponent::HasLostSightOfTarget() const
+{
+	if (!bCheckLineOfSight || CameraTarget == nullptr || TargetOccludedTime < 0.f)
+		return false;
+
+	return DSLockOnCore::HasLostSight(GetWorld()->GetTimeSeconds() - TargetOccludedTime, OcclusionBreakDelay);
+}
+
+void UDSLockArmComponent::UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime)
+{
+	// Free look moves the arm too far between frames for a cached probe to hold, so it keeps the stock per-tick sweep
+	if (!bCoherentArmProbe || !bDoTrace || TargetArmLength == 0.f || !IsCameraLockedToTarget())
+	{
+		ArmProbe.bValid = false;
+		ArmProbe.PendingSweep.Invalidate();
+		Super::UpdateDesiredArmLocation(bDoTrace, bDoLocationLag, bDoRotationLag, DeltaTime);
+		return;
+	}
+
+	DS_LOCKON_SCOPE(ArmProbe);
 
-	if (ViableTargets.Num() == 0) return;
+	// Let the spring arm apply lag and place the socket as if unobstructed, then pull it in by the probe
+	Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
 
-	/*
-	Select the target with the smallest angle difference to the current target
-	*/
-	int32 BestDotIdx = 0;
-	for (int32 i = 1; i < ViableTargets.Num(); i++)
+	const FVector ArmOrigin = GetComponentLocation() + TargetOffset;
+	const FVector DesiredLoc = UnfixedCameraPosition;
+	const FQuat DesiredRot = PreviousDesiredRot.Quaternion();
+
+	const float MovedDistSquared = ArmProbe.bValid ? FVector::DistSquared(ArmProbe.Origin, ArmOrigin) : 0.f;
+	const float MovedAngle = ArmProbe.bValid ? FMath::RadiansToDegrees(ArmProbe.Rotation.AngularDistance(DesiredRot)) : 0.f;
+
+	const bool bReuse = ArmProbe.bValid
+		&& ArmProbe.ArmLength == TargetArmLength
+		&& MovedDistSquared <= FMath::Square(ArmProbeReuseDistance)
+		&& MovedAngle <= ArmProbeReuseAngle;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SpringArm), false, GetOwner());
+
+	if (bReuse)
 	{
-		float BestDot = FVector::DotProduct(CurrentTargetDir, (ViableTargets[BestDotIdx]->GetComponentLocation() - GetComponentLocation()).GetSafeNormal());
-		float TestDot = FVector::DotProduct(CurrentTargetDir, (ViableTargets[i]->GetComponentLocation() - GetComponentLocation()).GetSafeNormal());
+		DS_LOCKON_COUNT(ArmProbeReuses, 1);
 
-		// Higher dot product indicates this target vector has a smaller angle than the previous best
-		if (TestDot > BestDot)
-			BestDotIdx = i;
+		// Refresh the probe once it has aged or the arm has moved part of the way to a full sweep. The result lands next
+		// frame, as async sweeps from every arm are batched and run off the game thread
+		const bool bNeedsRefresh = GFrameCounter - ArmProbe.FrameNumber >= (uint64)FMath::Max(ArmProbeRefreshFrames, 1)
+			|| MovedDistSquared > FMath::Square(ArmProbeReuseDistance * ArmProbeRefreshFraction)
+			|| MovedAngle > ArmProbeReuseAngle * ArmProbeRefreshFraction;
+
+		if (bNeedsRefresh && !ArmProbe.PendingSweep.IsValid())
+		{
+			ArmProbe.PendingRotation = DesiredRot;
+			ArmProbe.PendingArmLength = TargetArmLength;
+			ArmProbe.PendingFrameNumber = GFrameCounter;
+			ArmProbe.PendingSweep = GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, ArmOrigin, DesiredLoc, FQuat::Identity, ProbeChannel,
+				FCollisionShape::MakeSphere(ProbeSize), QueryParams, FCollisionResponseParams::DefaultResponseParam, &ArmProbeDelegate);
+		}
 	}
+	else
+	{
+		DS_LOCKON_COUNT(ArmProbeSweeps, 1);
+
+		FHitResult Hit;
+		GetWorld()->SweepSingleByChannel(Hit, ArmOrigin, DesiredLoc, FQuat::Identity, ProbeChannel, FCollisionShape::MakeSphere(ProbeSize), QueryParams);
+
+		ArmProbe.Origin = ArmOrigin;
+		ArmProbe.Rotation = DesiredRot;
+		ArmProbe.ArmLength = TargetArmLength;
+		ArmProbe.Fraction = Hit.bBlockingHit ? Hit.Time : 1.f;
+		ArmProbe.bValid = true;
+		ArmProbe.FrameNumber = GFrameCounter;
+
+		// A refresh still in flight was issued for a pose this sweep supersedes
+		ArmProbe.PendingSweep.Invalidate();
+	}
+
+	// The fraction rather than the hit location is reused, so the camera stays on the arm as it orbits
+	const FVector ResultLoc = BlendLocations(DesiredLoc, FMath::Lerp(ArmOrigin, DesiredLoc, ArmProbe.Fraction), ArmProbe.Fraction < 1.f, DeltaTime);
+	bIsCameraFixed = ResultLoc != DesiredLoc;
+	if (!bIsCameraFixed)
+		return;
 
-	LockToTarget(ViableTargets[BestDotIdx]);
+	const FTransform RelCamTM = FTransform(DesiredRot, ResultLoc).GetRelativeTransform(GetComponentTransform());
+	RelativeSocketLocation = RelCamTM.GetLocation();
+	RelativeSocketRotation = RelCamTM.GetRotation();
+
+	UpdateChildTransforms();
 }
 
-TArray<UDSTargetComponent*> UDSLockArmComponent::GetTargetComponents()
+void UDSLockArmComponent::OnArmProbeSweep(const FTraceHandle& Handle, FTraceDatum& Datum)
 {
-	TArray<UPrimitiveComponent*> TargetPrims;
-	TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes = { EObjectTypeQuery::ObjectTypeQuery2 }; // World dynamic object type
+	if (!(ArmProbe.PendingSweep == Handle))
+		return;
+
+	ArmProbe.PendingSweep.Invalidate();
+	ArmProbe.Origin = Datum.Start;
+	ArmProbe.Rotation = ArmProbe.PendingRotation;
+	ArmProbe.ArmLength = ArmProbe.PendingArmLength;
+	ArmProbe.Fraction = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit ? Datum.OutHits[0].Time : 1.f;
+	ArmProbe.bValid = true;
+	ArmProbe.FrameNumber = ArmProbe.PendingFrameNumber;
+}
+
+const FDSLockFrame& UDSLockArmComponent::GetLockFrame()
+{
+	if (LockFrameNumber == GFrameCounter)
+		return LockFrame;
+
+	LockFrameNumber = GFrameCounter;
+	LockFrame.bValid = CameraTarget != nullptr;
+	if (!LockFrame.bValid)
+		return LockFrame;
 
-	// Overlap check for targetable component
-	UKismetSystemLibrary::SphereOverlapComponents(GetOwner(),GetComponentLocation(),MaxTargetLockDistance, ObjectTypes,UDSTargetComponent::StaticClass(),TArray<AActor*>{GetOwner()},TargetPrims);
+	// Everything is measured from the arm pivot, which is also where the camera orbits
+	LockFrame.Origin = GetComponentLocation();
+	LockFrame.TargetLocation = CameraTarget->GetComponentLocation();
 
-	TArray<UDSTargetComponent*> TargetComps;
-	for (UPrimitiveComponent* Comp : TargetPrims)
+	const FVector ToTarget = LockFrame.TargetLocation - LockFrame.Origin;
+	LockFrame.Distance = ToTarget.Size();
+	LockFrame.Direction = LockFrame.Distance > SMALL_NUMBER ? ToTarget / LockFrame.Distance : FVector::ZeroVector;
+	LockFrame.Rotation = LockFrame.Direction.Rotation();
+
+	// Same basis as FRotationMatrix(FRotator(0, Yaw, 0)), without the trig
+	const FVector Flat(ToTarget.X, ToTarget.Y, 0.f);
+	LockFrame.YawForward = Flat.SizeSquared() > SMALL_NUMBER ? Flat.GetUnsafeNormal() : FVector::ForwardVector;
+	LockFrame.YawRight = FVector(-LockFrame.YawForward.Y, LockFrame.YawForward.X, 0.f);
+
+	LockFrame.AimLocation = LockFrame.TargetLocation;
+	LockFrame.AimRotation = LockFrame.Rotation;
+
+	if (bPredictiveTracking)
 	{
-		TargetComps.Add(Cast<UDSTargetComponent>(Comp));
+		DSLockOnCore::FTrackerConfig Config;
+		Config.Alpha = TrackingAlpha;
+		Config.Beta = TrackingBeta;
+		Config.Gamma = TrackingGamma;
+		Config.MaxLeadDistance = TrackingMaxLeadDistance;
+		Config.OvershootTolerance = TrackingOvershootTolerance;
+
+		const DSLockOnCore::FVec3 Measured = { LockFrame.TargetLocation.X, LockFrame.TargetLocation.Y, LockFrame.TargetLocation.Z };
+		if (bTrackerValid)
+			DSLockOnCore::UpdateTracker(TargetTracker, Config, Measured, GetWorld()->GetDeltaSeconds());
+		else
+			DSLockOnCore::ResetTracker(TargetTracker, Measured);
+		bTrackerValid = true;
+
+		// Lead by the lag of the pawn's steering spring unless set
+		float LeadSeconds = TrackingLeadSeconds;
+		if (LeadSeconds <= 0.f)
+		{
+			const ADSCharacter* Character = Cast<ADSCharacter>(GetOwner());
+			LeadSeconds = Character ? DSLockOnCore::GetSpringLagSeconds(Character->LockonControlRotationRate) : 0.f;
+		}
+
+		const DSLockOnCore::FVec3 Aim = DSLockOnCore::PredictTarget(TargetTracker, Config, Measured, LeadSeconds);
+		LockFrame.AimLocation = FVector(Aim.X, Aim.Y, Aim.Z);
+		LockFrame.AimRotation = (LockFrame.AimLocation - LockFrame.Origin).Rotation();
 	}
 
-	return TargetComps;
+	return LockFrame;
 }
 
 bool UDSLockArmComponent::IsCameraLockedToTarget()
@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "DSTargetComponent.h"
+#include "DSLockOnManager.h"
+#include "DSLockOnScoring.h"
+#include "Curves/CurveFloat.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnBenchmark, Log, All);
+
+/**
+* Console benchmarks for the lock-on system, e.g. "ds.LockOn.Bench.Query 2000 64".
+* Query benchmarks spawn temporary target actors in the current game world and destroy them again.
+*/
+namespace DSLockOnBenchmark
+{
+	/* Spawns NumTargets actors with a target component, scattered through a cube of the given half-extent */
+	static void SpawnTargets(UWorld* World, int32 NumTargets, float HalfExtent, FRandomStream& Random, TArray<AActor*>& OutActors)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 i = 0; i < NumTargets; i++)
+		{
+			const FVector Location(Random.FRandRange(-HalfExtent, HalfExtent), Random.FRandRange(-HalfExtent, HalfExtent), Random.FRandRange(0.f, 400.f));
+
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location), SpawnParams);
+			UDSTargetComponent* Target = NewObject<UDSTargetComponent>(Actor, TEXT("BenchTarget"));
+			Actor->SetRootComponent(Target);
+			Target->SetWorldLocation(Location);
+			Target->RegisterComponent();
+			OutActors.Add(Actor);
+		}
+	}
+
+	static void DestroyActors(TArray<AActor*>& Actors)
+	{
+		for (AActor* Actor : Actors)
+			Actor->Destroy();
+		Actors.Reset();
+	}
+
+	static void BenchQuery(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || !World->IsGameWorld())
+		{
+			UE_LOG(LogDSLockOnBenchmark, Warning, TEXT("ds.LockOn.Bench.Query must be run from a game world"));
+			return;
+		}
+
+		const int32 NumTargets = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2000;
+		const int32 NumArms = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64;
+		const float Radius = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 750.f;
+		const float HalfExtent = 10000.f;
+
+		FRandomStream Random(0x5EED);
+		TArray<AActor*> Actors;
+		SpawnTargets(World, NumTargets, HalfExtent, Random, Actors);
+
+		// Both paths need every target registered, with its physics state created
+		if (ADSLockOnManager* Manager = ADSLockOnManager::Get(World))
+			Manager->ProcessRegistrationQueue(0.f);
+
+		TArray<FVector> ArmOrigins;
+		for (int32 i = 0; i < NumArms; i++)
+			ArmOrigins.Add(FVector(Random.FRandRange(-HalfExtent, HalfExtent), Random.FRandRange(-HalfExtent, HalfExtent), 100.f));
+
+		// Physics overlap path, as used before targets were registered with the lock-on manager
+		int32 OverlapFound = 0;
+		const double OverlapStart = FPlatformTime::Seconds();
+		{
+			TArray<UPrimitiveComponent*> TargetPrims;
+			TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypes = { EObjectTypeQuery::ObjectTypeQuery2 };
+			TArray<AActor*> IgnoreActors;
+			for (const FVector& Origin : ArmOrigins)
+			{
+				UKismetSystemLibrary::SphereOverlapComponents(World, Origin, Radius, ObjectTypes, UDSTargetComponent::StaticClass(), IgnoreActors, TargetPrims);
+				OverlapFound += TargetPrims.Num();
+			}
+		}
+		const double OverlapMs = (FPlatformTime::Seconds() - OverlapStart) * 1000.0;
+
+		// Grid path
+		int32 GridFound = 0;
+		const double GridStart = FPlatformTime::Seconds();
+		if (ADSLockOnManager* Manager = ADSLockOnManager::Get(World))
+		{
+			TArray<USceneComponent*> Targets;
+			for (const FVector& Origin : ArmOrigins)
+			{
+				Targets.Reset();
+				Manager->GetTargetsInRadius(Origin, Radius, nullptr, Targets);
+				GridFound += Targets.Num();
+			}
+		}
+		const double GridMs = (FPlatformTime::Seconds() - GridStart) * 1000.0;
+
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("Query %d targets x %d arms, radius %.0f"), NumTargets, NumArms, Radius);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Overlap: %8.3f ms (%d found)"), OverlapMs, OverlapFound);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Grid:    %8.3f ms (%d found)"), GridMs, GridFound);
+
+		DestroyActors(Actors);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchQueryCommand(
+		TEXT("ds.LockOn.Bench.Query"),
+		TEXT("Compares the physics overlap and grid candidate queries. Args: [NumTargets=2000] [NumArms=64] [Radius=750]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchQuery));
+
+	static void BenchRegistration(const TArray<FString>& Args, UWorld* World)
+	{
+		ADSLockOnManager* Manager = World && World->IsGameWorld() ? ADSLockOnManager::Get(World) : nullptr;
+		IConsoleVariable* BudgetVar = IConsoleManager::Get().FindConsoleVariable(TEXT("ds.LockOn.RegistrationBudgetMs"));
+		if (Manager == nullptr || BudgetVar == nullptr)
+		{
+			UE_LOG(LogDSLockOnBenchmark, Warning, TEXT("ds.LockOn.Bench.Registration must be run from a game world"));
+			return;
+		}
+
+		const int32 NumTargets = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 500;
+		const float BudgetMs = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1.f;
+		const float HalfExtent = 10000.f;
+		const float PreviousBudgetMs = BudgetVar->GetFloat();
+
+		// Every target added and its physics state created on the frame it spawns
+		FRandomStream Random(0x5EED);
+		TArray<AActor*> Actors;
+		BudgetVar->Set(0.f);
+		double Start = FPlatformTime::Seconds();
+		SpawnTargets(World, NumTargets, HalfExtent, Random, Actors);
+		const double ImmediateMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+		DestroyActors(Actors);
+
+		// The same targets queued, then added in budgeted passes as the manager would over the following frames
+		Random.Reset();
+		BudgetVar->Set(FMath::Max(BudgetMs, KINDA_SMALL_NUMBER));
+		Start = FPlatformTime::Seconds();
+		SpawnTargets(World, NumTargets, HalfExtent, Random, Actors);
+		const double QueuedMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		int32 NumPasses = 0;
+		double TotalPassMs = 0.0;
+		double MaxPassMs = 0.0;
+		while (Manager->GetNumPendingTargets() > 0)
+		{
+			const double PassStart = FPlatformTime::Seconds();
+			Manager->ProcessRegistrationQueue(BudgetMs);
+			const double PassMs = (FPlatformTime::Seconds() - PassStart) * 1000.0;
+
+			NumPasses++;
+			TotalPassMs += PassMs;
+			MaxPassMs = FMath::Max(MaxPassMs, PassMs);
+		}
+
+		DestroyActors(Actors);
+		BudgetVar->Set(PreviousBudgetMs);
+
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("Register %d targets, %.2f ms budget"), NumTargets, BudgetMs);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Immediate: %8.3f ms on the spawning frame"), ImmediateMs);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Queued:    %8.3f ms on the spawning frame, then %d passes totalling %.3f ms, longest %.3f ms"),
+			QueuedMs, NumPasses, TotalPassMs, MaxPassMs);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchRegistrationCommand(
+		TEXT("ds.LockOn.Bench.Registration"),
+		TEXT("Compares the spawning frame cost of adding targets straight away with queuing them and adding them in budgeted passes. Args: [NumTargets=500] [BudgetMs=1]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchRegistration));
+
+	static void BenchScore(const TArray<FString>& Args)
+	{
+		const int32 NumCandidates = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256;
+		const int32 NumIterations = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10000;
+
+		FRandomStream Random(0x5EED);
+		FDSCandidateSet Candidates;
+		for (int32 i = 0; i < NumCandidates; i++)
+			Candidates.Add(nullptr, Random.FRandRange(-750.f, 750.f), Random.FRandRange(-750.f, 750.f), Random.FRandRange(-100.f, 100.f));
+
+		const FVector Origin(10.f, -20.f, 50.f);
+		const FVector Reference = FVector(1.f, 0.3f, -0.1f).GetSafeNormal();
+
+		TArray<float> ScalarDot, ScalarSide, ScalarDistance;
+		ScalarDot.SetNumUninitialized(NumCandidates);
+		ScalarSide.SetNumUninitialized(NumCandidates);
+		ScalarDistance.SetNumUninitialized(NumCandidates);
+
+		// Per-candidate FVector math, as the selection functions used to score
+		float Sink = 0.f;
+		double Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			for (int32 i = 0; i < NumCandidates; i++)
+			{
+				const FVector Dir = (FVector(Candidates.X[i], Candidates.Y[i], Candidates.Z[i]) - Origin).GetSafeNormal();
+				Sink += FVector::DotProduct(Reference, Dir) + FVector::CrossProduct(Reference, Dir).Z;
+			}
+		}
+		const double LegacyMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			DSLockOnScoring::ScoreCandidatesScalar(Candidates.X.GetData(), Candidates.Y.GetData(), Candidates.Z.GetData(), NumCandidates, Origin, Reference,
+				ScalarDot.GetData(), ScalarSide.GetData(), ScalarDistance.GetData());
+		}
+		const double ScalarMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			DSLockOnScoring::ScoreCandidates(Candidates, Origin, Reference);
+		}
+		const double VectorMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		// Equivalence between the vector and scalar kernels
+		float MaxDotError = 0.f;
+		float MaxSideError = 0.f;
+		float MaxDistanceError = 0.f;
+		for (int32 i = 0; i < NumCandidates; i++)
+		{
+			MaxDotError = FMath::Max(MaxDotError, FMath::Abs(ScalarDot[i] - Candidates.Dot[i]));
+			MaxSideError = FMath::Max(MaxSideError, FMath::Abs(ScalarSide[i] - Candidates.Side[i]));
+			MaxDistanceError = FMath::Max(MaxDistanceError, FMath::Abs(ScalarDistance[i] - Candidates.Distance[i]) / FMath::Max(ScalarDistance[i], 1.f));
+		}
+
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("Score %d candidates x %d iterations"), NumCandidates, NumIterations);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Per-candidate: %8.3f ms (%f)"), LegacyMs, Sink);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Scalar kernel: %8.3f ms"), ScalarMs);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Vector kernel: %8.3f ms"), VectorMs);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Max error: dot %g, side %g, relative distance %g"), MaxDotError, MaxSideError, MaxDistanceError);
+
+		const bool bEquivalent = MaxDotError <= KINDA_SMALL_NUMBER && MaxSideError <= KINDA_SMALL_NUMBER && MaxDistanceError <= KINDA_SMALL_NUMBER;
+		UE_CLOG(!bEquivalent, LogDSLockOnBenchmark, Error, TEXT("Vector scoring kernel diverges from the scalar reference"));
+	}
+
+	static FAutoConsoleCommand BenchScoreCommand(
+		TEXT("ds.LockOn.Bench.Score"),
+		TEXT("Times the candidate scoring kernels and checks the vector kernel against the scalar one. Args: [NumCandidates=256] [NumIterations=10000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchScore));
+
+	static void BenchCurves(const TArray<FString>& Args)
+	{
+		const int32 NumCandidates = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256;
+		const int32 NumIterations = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+
+		// One curve with a handful of cubic keys standing in for all four terms
+		UCurveFloat* Curve = NewObject<UCurveFloat>(GetTransientPackage());
+		Curve->FloatCurve.AddKey(0.f, 1.f);
+		Curve->FloatCurve.AddKey(.3f, .8f);
+		Curve->FloatCurve.AddKey(.6f, .35f);
+		Curve->FloatCurve.AddKey(1.f, 0.f);
+		Curve->FloatCurve.AutoSetTangents();
+
+		DSLockOnCore::FScoringTables Tables;
+		DSLockOnScoring::BakeScoreTable(Tables.Angle, Curve, 0.f, 1.f);
+		DSLockOnScoring::BakeScoreTable(Tables.Distance, Curve, 0.f, 1.f);
+		DSLockOnScoring::BakeScoreTable(Tables.Threat, Curve, 0.f, 1.f);
+		DSLockOnScoring::BakeScoreTable(Tables.Recency, Curve, 0.f, 1.f);
+		Tables.AngleWeight = Tables.DistanceWeight = Tables.ThreatWeight = Tables.RecencyWeight = 1.f;
+
+		FRandomStream Random(0x5EED);
+		FDSCandidateSet Candidates;
+		for (int32 i = 0; i < NumCandidates; i++)
+			Candidates.Add(nullptr, 0.f, 0.f, 0.f, 0.f, Random.FRand());
+
+		Candidates.Dot.SetNumUninitialized(NumCandidates);
+		Candidates.Distance.SetNumUninitialized(NumCandidates);
+		Candidates.SinceTargeted.SetNumUninitialized(NumCandidates);
+		Candidates.Score.SetNumUninitialized(NumCandidates);
+		for (int32 i = 0; i < NumCandidates; i++)
+		{
+			Candidates.Dot[i] = Random.FRandRange(-1.f, 1.f);
+			Candidates.Distance[i] = Random.FRandRange(0.f, 750.f);
+			Candidates.SinceTargeted[i] = Random.FRand();
+		}
+
+		// Every term evaluated from the curve asset per candidate, as scoring without tables would
+		float Sink = 0.f;
+		double Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			for (int32 i = 0; i < NumCandidates; i++)
+			{
+				Sink += Curve->GetFloatValue(FMath::Sqrt(FMath::Max((1.f - Candidates.Dot[i]) * .5f, 0.f)))
+					+ Curve->GetFloatValue(Candidates.Distance[i] / 750.f)
+					+ Curve->GetFloatValue(Candidates.Threat[i])
+					+ Curve->GetFloatValue(Candidates.SinceTargeted[i]);
+			}
+		}
+		const double CurveMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			DSLockOnCore::ScoreWithTables(Tables, Candidates.Dot.GetData(), Candidates.Distance.GetData(), Candidates.Threat.GetData(), Candidates.SinceTargeted.GetData(),
+				Candidates.Priority.GetData(), NumCandidates, 750.f, Candidates.Score.GetData());
+		}
+		const double TableMs = (FPlatformTime::Seconds() - Start) * 1000.0;
+
+		// Table error against the curve it was baked from
+		float MaxError = 0.f;
+		for (int32 i = 0; i < 1000; i++)
+		{
+			const float Value = i / 999.f;
+			MaxError = FMath::Max(MaxError, FMath::Abs(DSLockOnCore::LookupScore(Tables.Threat, Value) - Curve->GetFloatValue(Value)));
+		}
+
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("Score %d candidates x 4 curves x %d iterations"), NumCandidates, NumIterations);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Curve assets: %8.3f ms (%f)"), CurveMs, Sink);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Baked tables: %8.3f ms"), TableMs);
+		UE_LOG(LogDSLockOnBenchmark, Display, TEXT("  Max table error: %g"), MaxError);
+	}
+
+	static FAutoConsoleCommand BenchCurvesCommand(
+		TEXT("ds.LockOn.Bench.Curves"),
+		TEXT("Compares evaluating scoring curve assets per candidate with the baked lookup tables. Args: [NumCandidates=256] [NumIterations=1000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchCurves));
+}
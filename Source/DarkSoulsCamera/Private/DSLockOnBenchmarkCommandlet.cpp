@@ -0,0 +1,717 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnBenchmarkCommandlet.h"
+#include "AIController.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "DSCharacter.h"
+#include "DSLockArmComponent.h"
+#include "DSLockOnManager.h"
+#include "DSLockOnSteering.h"
+#include "DSLockOnHeadlessWorld.h"
+#include "DSLockOnStats.h"
+#include "DSTargetComponent.h"
+#include "DSTargetPointComponent.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnBenchmarkCommandlet, Log, All);
+
+namespace DSLockOnBenchmarkCommandlet
+{
+	struct FSettings
+	{
+		FString MapName;
+		int32 NumCharacters = 8;
+		int32 NumFrames = 600;
+		int32 NumWarmupFrames = 60;
+		float DeltaSeconds = 1.f / 60.f;
+		float Spacing = 300.f;
+		float PathRadius = 150.f;
+
+		/* 0 spawns one DSTargetComponent per target actor, otherwise this many DSTargetPointComponents */
+		int32 PointsPerTarget = 0;
+
+		/* Half extent of the square characters are spawned in, around the origin. 0 spreads them over the whole grid */
+		float CharacterSpread = 0.f;
+
+		/* Number of pawns stepped per frame in the spring benchmark */
+		int32 NumPawns = 1000;
+	};
+
+	struct FResult
+	{
+		int32 NumTargets = 0;
+		double MeanMs = 0.0;
+		double P50Ms = 0.0;
+		double P95Ms = 0.0;
+		double P99Ms = 0.0;
+		double MaxMs = 0.0;
+		int32 QueryCacheHits = 0;
+		int32 QueryCacheMisses = 0;
+	};
+
+	/* Nearest-rank percentile of sorted samples */
+	static double Percentile(const TArray<double>& SortedSamples, double Percent)
+	{
+		if (SortedSamples.Num() == 0)
+			return 0.0;
+
+		const int32 Rank = FMath::CeilToInt(Percent / 100.0 * SortedSamples.Num());
+		return SortedSamples[FMath::Clamp(Rank - 1, 0, SortedSamples.Num() - 1)];
+	}
+
+	/* Where target Index sits on its circular path at Time. Paths are phase-shifted so the grid never moves in lockstep */
+	static FVector GetPathLocation(const FVector& Center, int32 Index, float Radius, float Time)
+	{
+		const float Phase = Index * 0.618f * 2.f * PI;
+		const float Speed = 0.5f + (Index % 7) * 0.15f;
+		return Center + FVector(FMath::Cos(Time * Speed + Phase) * Radius, FMath::Sin(Time * Speed + Phase) * Radius, 0.f);
+	}
+
+#if DS_LOCKON_STATS
+	/* Runs one scenario in its own world. Returns false if the world can't be set up */
+	static bool RunScenario(const FSettings& Settings, int32 NumTargets, FResult& OutResult)
+	{
+		FDSLockOnHeadlessWorld HeadlessWorld;
+		if (!HeadlessWorld.Initialize(Settings.MapName))
+		{
+			UE_LOG(LogDSLockOnBenchmarkCommandlet, Error, TEXT("Failed to load map '%s'"), *Settings.MapName);
+			return false;
+		}
+
+		UWorld* World = HeadlessWorld.GetWorld();
+		FRandomStream Random(0x5EED + NumTargets);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// Square grid of targets centred on the origin
+		const int32 GridSide = FMath::CeilToInt(FMath::Sqrt((float)NumTargets));
+		const float HalfExtent = (GridSide - 1) * Settings.Spacing * 0.5f;
+
+		TArray<AActor*> TargetActors;
+		TArray<FVector> PathCenters;
+		TargetActors.Reserve(NumTargets);
+		PathCenters.Reserve(NumTargets);
+		for (int32 i = 0; i < NumTargets; i++)
+		{
+			const FVector Center((i % GridSide) * Settings.Spacing - HalfExtent, (i / GridSide) * Settings.Spacing - HalfExtent, 100.f);
+			const FVector Location = GetPathLocation(Center, i, Settings.PathRadius, 0.f);
+
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location), SpawnParams);
+			if (Settings.PointsPerTarget > 0)
+			{
+				// A stack of lock points, like the head, torso and legs of one enemy
+				for (int32 Point = 0; Point < Settings.PointsPerTarget; Point++)
+				{
+					UDSTargetPointComponent* Target = NewObject<UDSTargetPointComponent>(Actor);
+					if (Point == 0)
+						Actor->SetRootComponent(Target);
+					else
+						Target->SetupAttachment(Actor->GetRootComponent());
+
+					Target->SetRelativeLocation(FVector(0.f, 0.f, Point * 50.f));
+					Target->RegisterComponent();
+				}
+				Actor->SetActorLocation(Location);
+			}
+			else
+			{
+				UDSTargetComponent* Target = NewObject<UDSTargetComponent>(Actor, TEXT("BenchTarget"));
+				Actor->SetRootComponent(Target);
+				Target->SetWorldLocation(Location);
+				Target->RegisterComponent();
+			}
+
+			TargetActors.Add(Actor);
+			PathCenters.Add(Center);
+		}
+
+		// Measure lock-on with every target in place, not the registration queue draining
+		if (ADSLockOnManager* Manager = ADSLockOnManager::Find(World))
+			Manager->ProcessRegistrationQueue(0.f);
+
+		// Characters spread through the grid, flying so they hold position without a floor
+		TArray<ADSCharacter*> Characters;
+		const float CharacterExtent = Settings.CharacterSpread > 0.f ? Settings.CharacterSpread : HalfExtent;
+		for (int32 i = 0; i < Settings.NumCharacters; i++)
+		{
+			const FVector Location(Random.FRandRange(-CharacterExtent, CharacterExtent), Random.FRandRange(-CharacterExtent, CharacterExtent), 100.f);
+			const FRotator Rotation(0.f, Random.FRandRange(-180.f, 180.f), 0.f);
+
+			ADSCharacter* Character = World->SpawnActor<ADSCharacter>(ADSCharacter::StaticClass(), FTransform(Rotation, Location), SpawnParams);
+			AAIController* Controller = World->SpawnActor<AAIController>(AAIController::StaticClass(), FTransform(Rotation, Location), SpawnParams);
+			Controller->Possess(Character);
+			Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+			Characters.Add(Character);
+		}
+
+		TArray<double> FrameMs;
+		FrameMs.Reserve(Settings.NumFrames);
+
+		const int32 TotalFrames = Settings.NumWarmupFrames + Settings.NumFrames;
+		for (int32 Frame = 0; Frame < TotalFrames; Frame++)
+		{
+			const float Time = Frame * Settings.DeltaSeconds;
+			for (int32 i = 0; i < TargetActors.Num(); i++)
+				TargetActors[i]->SetActorLocation(GetPathLocation(PathCenters[i], i, Settings.PathRadius, Time));
+
+			if (Frame == Settings.NumWarmupFrames)
+				FDSLockOnCounters::Reset();
+
+			const double StartMs = FDSLockOnCounters::GetTotalMs();
+
+			for (int32 i = 0; i < Characters.Num(); i++)
+				UDSLockOnBenchmarkCommandlet::DriveCharacter(Characters[i], i, Frame, Settings.DeltaSeconds);
+
+			HeadlessWorld.Tick(Settings.DeltaSeconds);
+
+			if (Frame >= Settings.NumWarmupFrames)
+				FrameMs.Add(FDSLockOnCounters::GetTotalMs() - StartMs);
+		}
+
+		FrameMs.Sort();
+
+		double TotalMs = 0.0;
+		for (double Sample : FrameMs)
+			TotalMs += Sample;
+
+		OutResult.NumTargets = NumTargets;
+		OutResult.MeanMs = FrameMs.Num() > 0 ? TotalMs / FrameMs.Num() : 0.0;
+		OutResult.P50Ms = Percentile(FrameMs, 50.0);
+		OutResult.P95Ms = Percentile(FrameMs, 95.0);
+		OutResult.P99Ms = Percentile(FrameMs, 99.0);
+		OutResult.MaxMs = FrameMs.Num() > 0 ? FrameMs.Last() : 0.0;
+		OutResult.QueryCacheHits = FDSLockOnCounters::QueryCacheHits;
+		OutResult.QueryCacheMisses = FDSLockOnCounters::QueryCacheMisses;
+
+		UE_LOG(LogDSLockOnBenchmarkCommandlet, Display, TEXT("%6d targets, %d characters: mean %.4f ms, p50 %.4f ms, p95 %.4f ms, p99 %.4f ms, max %.4f ms"),
+			NumTargets, Characters.Num(), OutResult.MeanMs, OutResult.P50Ms, OutResult.P95Ms, OutResult.P99Ms, OutResult.MaxMs);
+		FDSLockOnCounters::LogSummary(Settings.NumFrames);
+		return true;
+	}
+#endif
+
+	static const TCHAR* TrajectoryNames[] = { TEXT("orbit"), TEXT("strafe"), TEXT("zigzag") };
+
+	/* Scripted target paths for tracking runs, around a character at the origin */
+	static FVector GetTrajectoryLocation(int32 Trajectory, float Time)
+	{
+		switch (Trajectory)
+		{
+		case 0:
+			// Circling the character at 90 degrees per second
+			return FVector(FMath::Cos(Time * HALF_PI) * 500.f, FMath::Sin(Time * HALF_PI) * 500.f, 100.f);
+		case 1:
+			// Smooth side to side strafe
+			return FVector(500.f, FMath::Sin(Time * PI) * 400.f, 100.f);
+		default:
+		{
+			// Side to side at a constant 600 cm/s, reversing instantly every half second
+			const float Phase = FMath::Fmod(Time, 1.f);
+			return FVector(500.f, ((Phase < .5f ? Phase : 1.f - Phase) - .25f) * 1200.f, 100.f);
+		}
+		}
+	}
+
+	struct FTrackingResult
+	{
+		double MeanDegrees = 0.0;
+		double P95Degrees = 0.0;
+		double MaxDegrees = 0.0;
+	};
+
+	/* Locks a character onto a target following Trajectory and measures the angle between the control rotation and the true target direction each frame */
+	static bool RunTrackingScenario(const FSettings& Settings, int32 Trajectory, bool bPredictive, FTrackingResult& OutResult)
+	{
+		FDSLockOnHeadlessWorld HeadlessWorld;
+		if (!HeadlessWorld.Initialize(FString()))
+			return false;
+
+		UWorld* World = HeadlessWorld.GetWorld();
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		const FVector StartLocation = GetTrajectoryLocation(Trajectory, 0.f);
+		AActor* TargetActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(StartLocation), SpawnParams);
+		UDSTargetComponent* Target = NewObject<UDSTargetComponent>(TargetActor, TEXT("BenchTarget"));
+		TargetActor->SetRootComponent(Target);
+		Target->SetWorldLocation(StartLocation);
+		Target->RegisterComponent();
+
+		ADSCharacter* Character = World->SpawnActor<ADSCharacter>(ADSCharacter::StaticClass(), FTransform(FVector(0.f, 0.f, 100.f)), SpawnParams);
+		AAIController* Controller = World->SpawnActor<AAIController>(AAIController::StaticClass(), FTransform::Identity, SpawnParams);
+		Controller->Possess(Character);
+		Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+
+		UDSLockArmComponent* Arm = Character->GetCameraBoom();
+		Arm->bPredictiveTracking = bPredictive;
+		Arm->LockToTarget(Target);
+
+		TArray<double> ErrorDegrees;
+		ErrorDegrees.Reserve(Settings.NumFrames);
+
+		const int32 TotalFrames = Settings.NumWarmupFrames + Settings.NumFrames;
+		for (int32 Frame = 0; Frame < TotalFrames; Frame++)
+		{
+			TargetActor->SetActorLocation(GetTrajectoryLocation(Trajectory, (Frame + 1) * Settings.DeltaSeconds));
+			HeadlessWorld.Tick(Settings.DeltaSeconds);
+
+			if (Frame < Settings.NumWarmupFrames)
+				continue;
+
+			const FVector Aim = Controller->GetControlRotation().Vector();
+			const FVector Actual = (Target->GetComponentLocation() - Arm->GetComponentLocation()).GetSafeNormal();
+			ErrorDegrees.Add(FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(Aim, Actual), -1.f, 1.f))));
+		}
+
+		ErrorDegrees.Sort();
+
+		double Total = 0.0;
+		for (double Error : ErrorDegrees)
+			Total += Error;
+
+		OutResult.MeanDegrees = ErrorDegrees.Num() > 0 ? Total / ErrorDegrees.Num() : 0.0;
+		OutResult.P95Degrees = Percentile(ErrorDegrees, 95.0);
+		OutResult.MaxDegrees = ErrorDegrees.Num() > 0 ? ErrorDegrees.Last() : 0.0;
+
+		UE_LOG(LogDSLockOnBenchmarkCommandlet, Display, TEXT("%-7s %-10s: mean %.3f deg, p95 %.3f deg, max %.3f deg"),
+			TrajectoryNames[Trajectory], bPredictive ? TEXT("predictive") : TEXT("direct"), OutResult.MeanDegrees, OutResult.P95Degrees, OutResult.MaxDegrees);
+		return true;
+	}
+}
+
+namespace DSLockOnBenchmarkCommandlet
+{
+	/* Frame rates the spring trajectories are compared at. Every one lands on a frame each sixth of a second */
+	static const int32 SpringFrameRates[] = { 30, 60, 144, 240 };
+	static const int32 SpringSamplesPerSecond = 6;
+
+	/* Springs are scripted for two seconds and switch target after one, as on a target switch */
+	static const int32 SpringSeconds = 2;
+	static const int32 NumConsistencySprings = 8;
+
+	/* Packed springs with storage */
+	struct FSpringSet
+	{
+		TArray<float> QX, QY, QZ, QW, VX, VY, VZ, TX, TY, TZ, TW, Frequency;
+
+		void Init(int32 Num)
+		{
+			for (TArray<float>* Array : { &QX, &QY, &QZ, &QW, &VX, &VY, &VZ, &TX, &TY, &TZ, &TW, &Frequency })
+				Array->SetNumZeroed(Num);
+		}
+
+		void SetRotation(int32 i, const FQuat& Q) { QX[i] = Q.X; QY[i] = Q.Y; QZ[i] = Q.Z; QW[i] = Q.W; }
+		void SetTarget(int32 i, const FQuat& Q) { TX[i] = Q.X; TY[i] = Q.Y; TZ[i] = Q.Z; TW[i] = Q.W; }
+		FQuat GetRotation(int32 i) const { return FQuat(QX[i], QY[i], QZ[i], QW[i]); }
+
+		DSLockOnCore::FRotationSprings Get()
+		{
+			return { QX.GetData(), QY.GetData(), QZ.GetData(), QW.GetData(), VX.GetData(), VY.GetData(), VZ.GetData(),
+				TX.GetData(), TY.GetData(), TZ.GetData(), TW.GetData(), Frequency.GetData(), QX.Num() };
+		}
+	};
+
+	/* Angle between two rotations in degrees. FQuat::AngularDistance goes through acos, which is too coarse near zero for these checks */
+	static double GetDegreesBetween(const FQuat& A, const FQuat& B)
+	{
+		const FQuat Delta = A * B.Inverse();
+		return FMath::RadiansToDegrees(2.0 * FMath::Atan2(FVector(Delta.X, Delta.Y, Delta.Z).Size(), FMath::Abs(Delta.W)));
+	}
+
+	static FRotator GetSpringStart(int32 Spring)
+	{
+		return FRotator(0.f, Spring * 10.f, 0.f);
+	}
+
+	static float GetSpringFrequency(int32 Spring)
+	{
+		return 4.f + Spring * 2.f;
+	}
+
+	/* Target of Spring over the frame starting at Time */
+	static FRotator GetSpringTarget(int32 Spring, float Time)
+	{
+		return Time < 1.f ? FRotator(-20.f + Spring, 120.f - Spring * 15.f, 0.f) : FRotator(10.f, -60.f + Spring * 20.f, 0.f);
+	}
+
+	static void InitConsistencySprings(FSpringSet& Set)
+	{
+		Set.Init(NumConsistencySprings);
+		for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+		{
+			Set.SetRotation(Spring, GetSpringStart(Spring).Quaternion());
+			Set.Frequency[Spring] = GetSpringFrequency(Spring);
+		}
+	}
+
+	struct FSpringConsistencyResult
+	{
+		double SpringDegrees = 0.0;
+		double InterpDegrees = 0.0;
+	};
+
+	/**
+	* Steps the scripted springs at every frame rate, sampling each sixth of a second. Spring samples are compared with
+	* the closed form taken in one step from the start of the current target, and RInterpTo steering over the same
+	* script is compared with its own 240 fps trajectory for contrast.
+	*/
+	static void RunSpringConsistency(TArray<FSpringConsistencyResult>& OutResults)
+	{
+		const int32 NumSamples = SpringSeconds * SpringSamplesPerSecond;
+
+		// Closed form: one step to the target switch, then one step to each sample from there
+		TArray<FQuat> Reference;
+		{
+			FSpringSet AtSwitch;
+			InitConsistencySprings(AtSwitch);
+			for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+				AtSwitch.SetTarget(Spring, GetSpringTarget(Spring, 0.f).Quaternion());
+			DSLockOnSteering::StepRotationSprings(AtSwitch.Get(), 1.f);
+
+			for (int32 Sample = 1; Sample <= NumSamples; Sample++)
+			{
+				const float Time = (float)Sample / SpringSamplesPerSecond;
+				const float SegmentStart = Time <= 1.f ? 0.f : 1.f;
+
+				FSpringSet Set;
+				InitConsistencySprings(Set);
+				if (SegmentStart > 0.f)
+					Set = AtSwitch;
+
+				for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+					Set.SetTarget(Spring, GetSpringTarget(Spring, SegmentStart).Quaternion());
+				DSLockOnSteering::StepRotationSprings(Set.Get(), Time - SegmentStart);
+
+				for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+					Reference.Add(Set.GetRotation(Spring));
+			}
+		}
+
+		TArray<TArray<FRotator>> InterpSamples;
+		for (const int32 FrameRate : SpringFrameRates)
+		{
+			const float DeltaSeconds = 1.f / FrameRate;
+			const int32 FramesPerSample = FrameRate / SpringSamplesPerSecond;
+
+			FSpringSet Set;
+			InitConsistencySprings(Set);
+
+			TArray<FRotator> Interp;
+			for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+				Interp.Add(GetSpringStart(Spring));
+
+			FSpringConsistencyResult Result;
+			InterpSamples.AddDefaulted();
+			TArray<FRotator>& InterpRates = InterpSamples.Last();
+
+			for (int32 Frame = 0; Frame < SpringSeconds * FrameRate; Frame++)
+			{
+				// Frame times are counted in whole frames so the target switch lands on the same instant at every rate
+				const float Time = (float)Frame / FrameRate;
+				for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+				{
+					Set.SetTarget(Spring, GetSpringTarget(Spring, Time).Quaternion());
+					Interp[Spring] = FMath::RInterpTo(Interp[Spring], GetSpringTarget(Spring, Time), DeltaSeconds, GetSpringFrequency(Spring));
+				}
+				DSLockOnSteering::StepRotationSprings(Set.Get(), DeltaSeconds);
+
+				if ((Frame + 1) % FramesPerSample != 0)
+					continue;
+
+				const int32 Sample = (Frame + 1) / FramesPerSample - 1;
+				for (int32 Spring = 0; Spring < NumConsistencySprings; Spring++)
+				{
+					const double Error = GetDegreesBetween(Set.GetRotation(Spring), Reference[Sample * NumConsistencySprings + Spring]);
+					Result.SpringDegrees = FMath::Max(Result.SpringDegrees, Error);
+					InterpRates.Add(Interp[Spring]);
+				}
+			}
+
+			OutResults.Add(Result);
+		}
+
+		// RInterpTo has no closed form, so its spread is measured against the highest frame rate
+		const TArray<FRotator>& InterpReference = InterpSamples.Last();
+		for (int32 Rate = 0; Rate < InterpSamples.Num(); Rate++)
+		{
+			for (int32 n = 0; n < InterpReference.Num(); n++)
+			{
+				const double Error = GetDegreesBetween(InterpSamples[Rate][n].Quaternion(), InterpReference[n].Quaternion());
+				OutResults[Rate].InterpDegrees = FMath::Max(OutResults[Rate].InterpDegrees, Error);
+			}
+
+			UE_LOG(LogDSLockOnBenchmarkCommandlet, Display, TEXT("%3d fps: spring %.5f deg from closed form, RInterpTo %.3f deg from 240 fps"),
+				SpringFrameRates[Rate], OutResults[Rate].SpringDegrees, OutResults[Rate].InterpDegrees);
+		}
+	}
+
+	struct FSpringBenchmarkResult
+	{
+		double InterpMs = 0.0;
+		double ScalarMs = 0.0;
+		double VectorMs = 0.0;
+		double MaxVectorDegrees = 0.0;
+	};
+
+	/* Times one frame of lock-on steering for NumPawns pawns chasing moving targets: per-pawn RInterpTo, and the packed springs with each kernel */
+	static void RunSpringBenchmark(const FSettings& Settings, FSpringBenchmarkResult& OutResult)
+	{
+		const int32 NumPawns = Settings.NumPawns;
+		FRandomStream Random(0x5EED);
+
+		FSpringSet Scalar;
+		Scalar.Init(NumPawns);
+		TArray<FRotator> Interp;
+		TArray<FRotator> Targets;
+		TArray<float> TargetPhases;
+
+		for (int32 i = 0; i < NumPawns; i++)
+		{
+			const FRotator Start(Random.FRandRange(-30.f, 30.f), Random.FRandRange(-180.f, 180.f), 0.f);
+			Scalar.SetRotation(i, Start.Quaternion());
+			Scalar.Frequency[i] = Random.FRandRange(5.f, 15.f);
+			Interp.Add(Start);
+			Targets.Add(Start);
+			TargetPhases.Add(Random.FRandRange(0.f, 2.f * PI));
+		}
+		FSpringSet Vector = Scalar;
+
+		uint64 InterpCycles = 0;
+		uint64 ScalarCycles = 0;
+		uint64 VectorCycles = 0;
+
+		for (int32 Frame = 0; Frame < Settings.NumFrames; Frame++)
+		{
+			// Targets circling each pawn, as a strafing enemy would
+			const float Time = Frame * Settings.DeltaSeconds;
+			for (int32 i = 0; i < NumPawns; i++)
+			{
+				Targets[i] = FRotator(-10.f, FMath::RadiansToDegrees(Time + TargetPhases[i]), 0.f);
+				Scalar.SetTarget(i, Targets[i].Quaternion());
+				Vector.SetTarget(i, Targets[i].Quaternion());
+			}
+
+			uint64 Start = FPlatformTime::Cycles64();
+			for (int32 i = 0; i < NumPawns; i++)
+				Interp[i] = FMath::RInterpTo(Interp[i], Targets[i], Settings.DeltaSeconds, Scalar.Frequency[i]);
+			InterpCycles += FPlatformTime::Cycles64() - Start;
+
+			Start = FPlatformTime::Cycles64();
+			DSLockOnSteering::StepRotationSpringsScalar(Scalar.Get(), Settings.DeltaSeconds);
+			ScalarCycles += FPlatformTime::Cycles64() - Start;
+
+			Start = FPlatformTime::Cycles64();
+			DSLockOnSteering::StepRotationSprings(Vector.Get(), Settings.DeltaSeconds);
+			VectorCycles += FPlatformTime::Cycles64() - Start;
+		}
+
+		for (int32 i = 0; i < NumPawns; i++)
+			OutResult.MaxVectorDegrees = FMath::Max(OutResult.MaxVectorDegrees, GetDegreesBetween(Vector.GetRotation(i), Scalar.GetRotation(i)));
+
+		const double Frames = FMath::Max(Settings.NumFrames, 1);
+		OutResult.InterpMs = FPlatformTime::ToMilliseconds64(InterpCycles) / Frames;
+		OutResult.ScalarMs = FPlatformTime::ToMilliseconds64(ScalarCycles) / Frames;
+		OutResult.VectorMs = FPlatformTime::ToMilliseconds64(VectorCycles) / Frames;
+
+		UE_LOG(LogDSLockOnBenchmarkCommandlet, Display, TEXT("%d pawns, per frame: RInterpTo %.4f ms, scalar springs %.4f ms, vector springs %.4f ms (max difference %.5f deg)"),
+			NumPawns, OutResult.InterpMs, OutResult.ScalarMs, OutResult.VectorMs, OutResult.MaxVectorDegrees);
+	}
+}
+
+UDSLockOnBenchmarkCommandlet::UDSLockOnBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+void UDSLockOnBenchmarkCommandlet::DriveCharacter(ADSCharacter* Character, int32 CharacterIndex, int32 Frame, float DeltaSeconds)
+{
+	// Offset each character's script so their toggles and flicks don't all land on the same frame
+	const int32 LocalFrame = Frame + CharacterIndex * 37;
+	const float Time = LocalFrame * DeltaSeconds;
+
+	if (LocalFrame % 600 == 300)
+		Character->CameraLockArm->ToggleSoftLock();
+
+	if (LocalFrame % 240 == 0)
+		Character->CameraLockArm->ToggleCameraLock();
+
+	// Slow mouse drift with a periodic flick large enough to switch targets or break soft-lock
+	float MouseDelta = 2.f * FMath::Sin(Time * 1.3f);
+	if (LocalFrame % 90 == 45)
+		MouseDelta = (LocalFrame / 90) % 2 == 0 ? 12.f : -4.f;
+	Character->Turn(MouseDelta);
+
+	// Analog stick sweeping through centre and out past the switch threshold
+	Character->TurnAtRate(FMath::Sin(Time * 0.7f + CharacterIndex));
+}
+
+int32 UDSLockOnBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace DSLockOnBenchmarkCommandlet;
+
+	FSettings Settings;
+	FParse::Value(*Params, TEXT("Map="), Settings.MapName);
+	FParse::Value(*Params, TEXT("Characters="), Settings.NumCharacters);
+	FParse::Value(*Params, TEXT("Frames="), Settings.NumFrames);
+	FParse::Value(*Params, TEXT("WarmupFrames="), Settings.NumWarmupFrames);
+	FParse::Value(*Params, TEXT("DeltaSeconds="), Settings.DeltaSeconds);
+	FParse::Value(*Params, TEXT("Spacing="), Settings.Spacing);
+	FParse::Value(*Params, TEXT("PathRadius="), Settings.PathRadius);
+	FParse::Value(*Params, TEXT("PointsPerTarget="), Settings.PointsPerTarget);
+	FParse::Value(*Params, TEXT("CharacterSpread="), Settings.CharacterSpread);
+	FParse::Value(*Params, TEXT("Pawns="), Settings.NumPawns);
+
+	// Overrides the console variable for the whole run, to compare cell sizes between runs
+	float QueryCacheCellSize = -1.f;
+	if (FParse::Value(*Params, TEXT("QueryCacheCellSize="), QueryCacheCellSize))
+	{
+		if (IConsoleVariable* CellSizeVar = IConsoleManager::Get().FindConsoleVariable(TEXT("ds.LockOn.QueryCacheCellSize")))
+			CellSizeVar->Set(QueryCacheCellSize);
+	}
+
+	FString Mode = TEXT("Perf");
+	FParse::Value(*Params, TEXT("Mode="), Mode);
+	const bool bTracking = Mode == TEXT("Tracking");
+	const bool bSpring = Mode == TEXT("Spring");
+
+	FString TargetsParam = TEXT("100,1000,10000");
+	FParse::Value(*Params, TEXT("Targets="), TargetsParam, false);
+
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / (bTracking ? TEXT("DSLockOnTracking.json") : bSpring ? TEXT("DSLockOnSpring.json") : TEXT("DSLockOnBenchmark.json"));
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	float BudgetP95Ms = 0.f;
+	FParse::Value(*Params, TEXT("BudgetP95Ms="), BudgetP95Ms);
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("mode"), bTracking ? TEXT("tracking") : bSpring ? TEXT("spring") : TEXT("perf"));
+	Report->SetNumberField(TEXT("frames"), Settings.NumFrames);
+	Report->SetNumberField(TEXT("warmupFrames"), Settings.NumWarmupFrames);
+	Report->SetNumberField(TEXT("deltaSeconds"), Settings.DeltaSeconds);
+
+	TArray<TSharedPtr<FJsonValue>> ScenarioValues;
+	bool bOverBudget = false;
+	bool bSpringDiverged = false;
+
+	if (bSpring)
+	{
+		// Trajectories must match across frame rates to within float rounding
+		const double MaxSpringDegrees = 0.01;
+
+		TArray<FSpringConsistencyResult> Results;
+		RunSpringConsistency(Results);
+
+		for (int32 Rate = 0; Rate < Results.Num(); Rate++)
+		{
+			TSharedRef<FJsonObject> Scenario = MakeShared<FJsonObject>();
+			Scenario->SetNumberField(TEXT("fps"), SpringFrameRates[Rate]);
+			Scenario->SetNumberField(TEXT("springDegrees"), Results[Rate].SpringDegrees);
+			Scenario->SetNumberField(TEXT("interpDegrees"), Results[Rate].InterpDegrees);
+			ScenarioValues.Add(MakeShared<FJsonValueObject>(Scenario));
+
+			bSpringDiverged |= Results[Rate].SpringDegrees > MaxSpringDegrees;
+		}
+
+		FSpringBenchmarkResult BenchmarkResult;
+		RunSpringBenchmark(Settings, BenchmarkResult);
+
+		TSharedRef<FJsonObject> Benchmark = MakeShared<FJsonObject>();
+		Benchmark->SetNumberField(TEXT("pawns"), Settings.NumPawns);
+		Benchmark->SetNumberField(TEXT("interpMs"), BenchmarkResult.InterpMs);
+		Benchmark->SetNumberField(TEXT("scalarMs"), BenchmarkResult.ScalarMs);
+		Benchmark->SetNumberField(TEXT("vectorMs"), BenchmarkResult.VectorMs);
+		Benchmark->SetNumberField(TEXT("maxVectorDegrees"), BenchmarkResult.MaxVectorDegrees);
+		Report->SetObjectField(TEXT("benchmark"), Benchmark);
+
+		bSpringDiverged |= BenchmarkResult.MaxVectorDegrees > MaxSpringDegrees;
+		UE_CLOG(bSpringDiverged, LogDSLockOnBenchmarkCommandlet, Error, TEXT("Spring trajectories differ by more than %.3f deg"), MaxSpringDegrees);
+	}
+	else if (bTracking)
+	{
+		// Angular tracking error, with and without prediction, against each scripted trajectory
+		for (int32 Trajectory = 0; Trajectory < ARRAY_COUNT(TrajectoryNames); Trajectory++)
+		{
+			for (const bool bPredictive : { false, true })
+			{
+				FTrackingResult Result;
+				if (!RunTrackingScenario(Settings, Trajectory, bPredictive, Result))
+					return 1;
+
+				TSharedRef<FJsonObject> Scenario = MakeShared<FJsonObject>();
+				Scenario->SetStringField(TEXT("trajectory"), TrajectoryNames[Trajectory]);
+				Scenario->SetBoolField(TEXT("predictive"), bPredictive);
+				Scenario->SetNumberField(TEXT("meanDegrees"), Result.MeanDegrees);
+				Scenario->SetNumberField(TEXT("p95Degrees"), Result.P95Degrees);
+				Scenario->SetNumberField(TEXT("maxDegrees"), Result.MaxDegrees);
+				ScenarioValues.Add(MakeShared<FJsonValueObject>(Scenario));
+			}
+		}
+	}
+	else
+	{
+#if DS_LOCKON_STATS
+		Report->SetStringField(TEXT("map"), Settings.MapName);
+		Report->SetNumberField(TEXT("characters"), Settings.NumCharacters);
+		Report->SetNumberField(TEXT("pointsPerTarget"), Settings.PointsPerTarget);
+		Report->SetNumberField(TEXT("characterSpread"), Settings.CharacterSpread);
+
+		if (IConsoleVariable* CellSizeVar = IConsoleManager::Get().FindConsoleVariable(TEXT("ds.LockOn.QueryCacheCellSize")))
+			Report->SetNumberField(TEXT("queryCacheCellSize"), CellSizeVar->GetFloat());
+
+		TArray<FString> TargetCounts;
+		TargetsParam.ParseIntoArray(TargetCounts, TEXT(","));
+
+		for (const FString& TargetCount : TargetCounts)
+		{
+			FResult Result;
+			if (!RunScenario(Settings, FCString::Atoi(*TargetCount), Result))
+				return 1;
+
+			TSharedRef<FJsonObject> Scenario = MakeShared<FJsonObject>();
+			Scenario->SetNumberField(TEXT("targets"), Result.NumTargets);
+			Scenario->SetNumberField(TEXT("meanMs"), Result.MeanMs);
+			Scenario->SetNumberField(TEXT("p50Ms"), Result.P50Ms);
+			Scenario->SetNumberField(TEXT("p95Ms"), Result.P95Ms);
+			Scenario->SetNumberField(TEXT("p99Ms"), Result.P99Ms);
+			Scenario->SetNumberField(TEXT("maxMs"), Result.MaxMs);
+			Scenario->SetNumberField(TEXT("queryCacheHits"), Result.QueryCacheHits);
+			Scenario->SetNumberField(TEXT("queryCacheMisses"), Result.QueryCacheMisses);
+			ScenarioValues.Add(MakeShared<FJsonValueObject>(Scenario));
+
+			bOverBudget |= BudgetP95Ms > 0.f && Result.P95Ms > BudgetP95Ms;
+		}
+#else
+		UE_LOG(LogDSLockOnBenchmarkCommandlet, Error, TEXT("Lock-on stats are compiled out of this build configuration"));
+		return 1;
+#endif
+	}
+
+	Report->SetArrayField(TEXT("scenarios"), ScenarioValues);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogDSLockOnBenchmarkCommandlet, Error, TEXT("Failed to write '%s'"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogDSLockOnBenchmarkCommandlet, Display, TEXT("Wrote %s"), *OutputPath);
+
+	UE_CLOG(bOverBudget, LogDSLockOnBenchmarkCommandlet, Error, TEXT("p95 lock-on time exceeds the %.4f ms budget"), BudgetP95Ms);
+	return bOverBudget || bSpringDiverged ? 2 : 0;
+}
@@ -0,0 +1,459 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <cmath>
+#include <limits>
+
+#if DS_LOCKON_SSE
+#include <emmintrin.h>
+#endif
+
+namespace DSLockOnCore
+{
+	/* Matches the engine's SMALL_NUMBER threshold used by FVector::GetSafeNormal */
+	static const float SafeNormalTolerance = 1.e-8f;
+
+	int FilterInRange(const float* X, const float* Y, const float* Z, const float* Radius, const int* Indices, int NumIndices, const FVec3& Origin, float QueryRadius, int* OutIndices)
+	{
+		int NumFound = 0;
+		for (int n = 0; n < NumIndices; n++)
+		{
+			const int i = Indices[n];
+			const float DX = X[i] - Origin.X;
+			const float DY = Y[i] - Origin.Y;
+			const float DZ = Z[i] - Origin.Z;
+			const float Reach = QueryRadius + Radius[i];
+
+			// Matches a sphere overlap: the target sphere only has to touch the query sphere
+			if (DX * DX + DY * DY + DZ * DZ <= Reach * Reach)
+				OutIndices[NumFound++] = i;
+		}
+		return NumFound;
+	}
+
+	void ScoreCandidates(const float* X, const float* Y, const float* Z, int Num, const FVec3& Origin, const FVec3& Reference, float* OutDot, float* OutSide, float* OutDistance)
+	{
+		for (int i = 0; i < Num; i++)
+		{
+			const float DX = X[i] - Origin.X;
+			const float DY = Y[i] - Origin.Y;
+			const float DZ = Z[i] - Origin.Z;
+			const float LengthSq = DX * DX + DY * DY + DZ * DZ;
+
+			// Degenerate directions normalize to zero, unit directions are left untouched
+			const float Scale = LengthSq == 1.f ? 1.f : (LengthSq < SafeNormalTolerance ? 0.f : 1.f / std::sqrt(LengthSq));
+			const float NX = DX * Scale;
+			const float NY = DY * Scale;
+			const float NZ = DZ * Scale;
+
+			OutDot[i] = Reference.X * NX + Reference.Y * NY + Reference.Z * NZ;
+			OutSide[i] = Reference.X * NY - Reference.Y * NX;
+			OutDistance[i] = std::sqrt(LengthSq);
+		}
+	}
+
+	void ProjectCandidates(const float* X, const float* Y, const float* Z, int Num, const float* ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW)
+	{
+		const float* M = ViewProjection;
+		for (int i = 0; i < Num; i++)
+		{
+			const float ClipX = X[i] * M[0] + Y[i] * M[4] + Z[i] * M[8] + M[12];
+			const float ClipY = X[i] * M[1] + Y[i] * M[5] + Z[i] * M[9] + M[13];
+			const float ClipW = X[i] * M[3] + Y[i] * M[7] + Z[i] * M[11] + M[15];
+
+			// Behind the camera the coordinates are meaningless, but W already marks the point for culling
+			const float InvW = ClipW > 0.f ? 1.f / ClipW : 0.f;
+			OutNDCX[i] = ClipX * InvW;
+			OutNDCY[i] = ClipY * InvW;
+			OutW[i] = ClipW;
+		}
+	}
+
+#if DS_LOCKON_SSE
+	/* Lanes of A where Mask is set, of B elsewhere */
+	static inline __m128 SelectLanes(__m128 Mask, __m128 A, __m128 B)
+	{
+		return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B));
+	}
+
+	/* Hardware estimate refined by two Newton-Raphson steps, as the engine's VectorReciprocalSqrtAccurate */
+	static inline __m128 ReciprocalSqrtAccurate(__m128 Value)
+	{
+		const __m128 OneHalf = _mm_set1_ps(.5f);
+		const __m128 HalfValue = _mm_mul_ps(Value, OneHalf);
+
+		__m128 Estimate = _mm_rsqrt_ps(Value);
+		for (int Step = 0; Step < 2; Step++)
+			Estimate = _mm_add_ps(Estimate, _mm_mul_ps(Estimate, _mm_sub_ps(OneHalf, _mm_mul_ps(HalfValue, _mm_mul_ps(Estimate, Estimate)))));
+		return Estimate;
+	}
+
+	int ScoreCandidates4(const float* X, const float* Y, const float* Z, int Num, const FVec3& Origin, const FVec3& Reference, float* OutDot, float* OutSide, float* OutDistance)
+	{
+		const __m128 OriginX = _mm_set1_ps(Origin.X);
+		const __m128 OriginY = _mm_set1_ps(Origin.Y);
+		const __m128 OriginZ = _mm_set1_ps(Origin.Z);
+		const __m128 RefX = _mm_set1_ps(Reference.X);
+		const __m128 RefY = _mm_set1_ps(Reference.Y);
+		const __m128 RefZ = _mm_set1_ps(Reference.Z);
+		const __m128 Tolerance = _mm_set1_ps(SafeNormalTolerance);
+		const __m128 One = _mm_set1_ps(1.f);
+		const __m128 Smallest = _mm_set1_ps(std::numeric_limits<float>::min());
+
+		int i = 0;
+		for (; i + 4 <= Num; i += 4)
+		{
+			const __m128 DX = _mm_sub_ps(_mm_loadu_ps(X + i), OriginX);
+			const __m128 DY = _mm_sub_ps(_mm_loadu_ps(Y + i), OriginY);
+			const __m128 DZ = _mm_sub_ps(_mm_loadu_ps(Z + i), OriginZ);
+
+			// Summed in the scalar kernel's order, so both make the same call on directions at the tolerance
+			const __m128 LengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(DX, DX), _mm_mul_ps(DY, DY)), _mm_mul_ps(DZ, DZ));
+
+			// Clamped so a candidate on the origin gets a distance of zero rather than zero times infinity
+			const __m128 InvLength = ReciprocalSqrtAccurate(_mm_max_ps(LengthSq, Smallest));
+
+			// Degenerate directions normalize to zero, unit directions are left untouched
+			const __m128 Scale = SelectLanes(_mm_cmpeq_ps(LengthSq, One), One, _mm_and_ps(_mm_cmpge_ps(LengthSq, Tolerance), InvLength));
+			const __m128 NX = _mm_mul_ps(DX, Scale);
+			const __m128 NY = _mm_mul_ps(DY, Scale);
+			const __m128 NZ = _mm_mul_ps(DZ, Scale);
+
+			_mm_storeu_ps(OutDot + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(RefX, NX), _mm_mul_ps(RefY, NY)), _mm_mul_ps(RefZ, NZ)));
+			_mm_storeu_ps(OutSide + i, _mm_sub_ps(_mm_mul_ps(RefX, NY), _mm_mul_ps(RefY, NX)));
+			_mm_storeu_ps(OutDistance + i, _mm_mul_ps(LengthSq, InvLength));
+		}
+		return i;
+	}
+
+	int ProjectCandidates4(const float* X, const float* Y, const float* Z, int Num, const float* ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW)
+	{
+		const float* M = ViewProjection;
+		const __m128 M0 = _mm_set1_ps(M[0]), M4 = _mm_set1_ps(M[4]), M8 = _mm_set1_ps(M[8]), M12 = _mm_set1_ps(M[12]);
+		const __m128 M1 = _mm_set1_ps(M[1]), M5 = _mm_set1_ps(M[5]), M9 = _mm_set1_ps(M[9]), M13 = _mm_set1_ps(M[13]);
+		const __m128 M3 = _mm_set1_ps(M[3]), M7 = _mm_set1_ps(M[7]), M11 = _mm_set1_ps(M[11]), M15 = _mm_set1_ps(M[15]);
+		const __m128 One = _mm_set1_ps(1.f);
+
+		int i = 0;
+		for (; i + 4 <= Num; i += 4)
+		{
+			const __m128 PX = _mm_loadu_ps(X + i);
+			const __m128 PY = _mm_loadu_ps(Y + i);
+			const __m128 PZ = _mm_loadu_ps(Z + i);
+
+			// Terms summed in the scalar kernel's order
+			const __m128 ClipX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, M0), _mm_mul_ps(PY, M4)), _mm_mul_ps(PZ, M8)), M12);
+			const __m128 ClipY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, M1), _mm_mul_ps(PY, M5)), _mm_mul_ps(PZ, M9)), M13);
+			const __m128 ClipW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(PX, M3), _mm_mul_ps(PY, M7)), _mm_mul_ps(PZ, M11)), M15);
+
+			// Points behind the camera project to the origin, as in the scalar kernel. W marks them for culling
+			const __m128 InvW = _mm_and_ps(_mm_cmpgt_ps(ClipW, _mm_setzero_ps()), _mm_div_ps(One, ClipW));
+
+			_mm_storeu_ps(OutNDCX + i, _mm_mul_ps(ClipX, InvW));
+			_mm_storeu_ps(OutNDCY + i, _mm_mul_ps(ClipY, InvW));
+			_mm_storeu_ps(OutW + i, ClipW);
+		}
+		return i;
+	}
+#endif
+
+	float ScoreScreenPosition(float NDCX, float NDCY, float W, float Margin)
+	{
+		const float Limit = 1.f - Margin;
+		if (W <= 0.f || std::fabs(NDCX) > Limit || std::fabs(NDCY) > Limit)
+			return -1.f;
+
+		return 1.f - std::sqrt((NDCX * NDCX + NDCY * NDCY) * .5f);
+	}
+
+	int SelectLockTarget(const float* Dot, int Num)
+	{
+		// Get the candidate with the smallest angle difference from the reference vector
+		float ClosestDotToCenter = 0.f;
+		int BestIdx = -1;
+
+		for (int i = 0; i < Num; i++)
+		{
+			if (Dot[i] > ClosestDotToCenter)
+			{
+				ClosestDotToCenter = Dot[i];
+				BestIdx = i;
+			}
+		}
+		return BestIdx;
+	}
+
+	int SelectLockTarget(const float* Dot, const float* Priority, int Num)
+	{
+		float BestScore = 0.f;
+		int BestIdx = -1;
+
+		for (int i = 0; i < Num; i++)
+		{
+			// Priority can't bring a candidate behind the reference into play
+			if (Dot[i] <= 0.f)
+				continue;
+
+			const float Score = Dot[i] + Priority[i];
+			if (BestIdx < 0 || Score > BestScore)
+			{
+				BestScore = Score;
+				BestIdx = i;
+			}
+		}
+		return BestIdx;
+	}
+
+	void ScoreWithTables(const FScoringTables& Tables, const float* Dot, const float* Distance, const float* Threat, const float* SinceTargeted,
+		const float* Priority, int Num, float MaxDistance, float* OutScore)
+	{
+		const float InvMaxDistance = MaxDistance > 0.f ? 1.f / MaxDistance : 0.f;
+
+		// One pass per term, so each table stays in cache while it's read and disabled terms cost nothing
+		for (int i = 0; i < Num; i++)
+			OutScore[i] = Priority[i];
+
+		if (Tables.AngleWeight != 0.f)
+		{
+			for (int i = 0; i < Num; i++)
+			{
+				// sin(Angle / 2) from the dot product, without an acos
+				const float HalfChord = (1.f - Dot[i]) * .5f;
+				OutScore[i] += Tables.AngleWeight * LookupScore(Tables.Angle, std::sqrt(HalfChord > 0.f ? HalfChord : 0.f));
+			}
+		}
+
+		if (Tables.DistanceWeight != 0.f)
+		{
+			for (int i = 0; i < Num; i++)
+				OutScore[i] += Tables.DistanceWeight * LookupScore(Tables.Distance, Distance[i] * InvMaxDistance);
+		}
+
+		if (Tables.ThreatWeight != 0.f)
+		{
+			for (int i = 0; i < Num; i++)
+				OutScore[i] += Tables.ThreatWeight * LookupScore(Tables.Threat, Threat[i]);
+		}
+
+		if (Tables.RecencyWeight != 0.f)
+		{
+			for (int i = 0; i < Num; i++)
+				OutScore[i] += Tables.RecencyWeight * LookupScore(Tables.Recency, SinceTargeted[i]);
+		}
+	}
+
+	int SelectByScore(const float* Dot, const float* Score, int Num)
+	{
+		int BestIdx = -1;
+
+		for (int i = 0; i < Num; i++)
+		{
+			// Candidates behind the reference, occluded or culled from the screen stay out of play
+			if (Dot[i] > 0.f && (BestIdx < 0 || Score[i] > Score[BestIdx]))
+				BestIdx = i;
+		}
+		return BestIdx;
+	}
+
+	int SelectSwitchTarget(const float* Dot, const float* Side, int Num, int ExcludeIndex, bool bRight)
+	{
+		int BestIdx = -1;
+
+		for (int i = 0; i < Num; i++)
+		{
+			//  Don't consider current target as a switch target
+			if (i == ExcludeIndex) continue;
+
+			// Negative Z indicates left, positive Z indicates right
+			const bool bOnRequestedSide = bRight ? Side[i] > 0.f : Side[i] < 0.f;
+
+			// Higher dot product indicates this target vector has a smaller angle than the previous best
+			if (bOnRequestedSide && (BestIdx < 0 || Dot[i] > Dot[BestIdx]))
+				BestIdx = i;
+		}
+		return BestIdx;
+	}
+
+	bool NeedsLockCandidate(const FLockState& State)
+	{
+		if (State.bLocked)
+			return (State.bOutOfRange || State.bLostSight) && State.bUseSoftLock;
+
+		return State.bUseSoftLock;
+	}
+
+	ELockAction UpdateLockState(const FLockState& State, bool bHasCandidate)
+	{
+		if (State.bLocked)
+		{
+			if (!State.bOutOfRange && !State.bLostSight)
+				return ELockAction::None;
+
+			// Soft-lock tries to switch to a new visible target in range before giving up
+			if (State.bUseSoftLock && bHasCandidate)
+				return ELockAction::LockToCandidate;
+
+			return ELockAction::Break;
+		}
+
+		if (!State.bUseSoftLock)
+			return ELockAction::None;
+
+		// Attempt to auto target nearby enemy, unless the player forcibly broke soft-lock
+		if (bHasCandidate)
+			return State.bSoftlockRequiresReset ? ELockAction::None : ELockAction::LockToCandidate;
+
+		// If player forcibly broke soft-lock, reset it when no target is within range
+		return ELockAction::ClearSoftlockReset;
+	}
+
+	void ResetTracker(FTargetTracker& Tracker, const FVec3& Position)
+	{
+		Tracker.Position = Position;
+		Tracker.Velocity = { 0.f, 0.f, 0.f };
+		Tracker.Acceleration = { 0.f, 0.f, 0.f };
+		Tracker.Residual = 0.f;
+	}
+
+	/* One axis of the alpha-beta-gamma update. Returns the residual */
+	static float UpdateTrackerAxis(float& Position, float& Velocity, float& Acceleration, float Measured, const FTrackerConfig& Config, float DeltaSeconds)
+	{
+		// Predict forward, then correct each term by its share of the residual
+		const float PredictedPosition = Position + Velocity * DeltaSeconds + Acceleration * 0.5f * DeltaSeconds * DeltaSeconds;
+		const float PredictedVelocity = Velocity + Acceleration * DeltaSeconds;
+		const float Residual = Measured - PredictedPosition;
+
+		Position = PredictedPosition + Config.Alpha * Residual;
+		Velocity = PredictedVelocity + Config.Beta / DeltaSeconds * Residual;
+		Acceleration += 2.f * Config.Gamma / (DeltaSeconds * DeltaSeconds) * Residual;
+		return Residual;
+	}
+
+	void UpdateTracker(FTargetTracker& Tracker, const FTrackerConfig& Config, const FVec3& Measured, float DeltaSeconds)
+	{
+		if (DeltaSeconds <= 0.f)
+			return;
+
+		const float RX = UpdateTrackerAxis(Tracker.Position.X, Tracker.Velocity.X, Tracker.Acceleration.X, Measured.X, Config, DeltaSeconds);
+		const float RY = UpdateTrackerAxis(Tracker.Position.Y, Tracker.Velocity.Y, Tracker.Acceleration.Y, Measured.Y, Config, DeltaSeconds);
+		const float RZ = UpdateTrackerAxis(Tracker.Position.Z, Tracker.Velocity.Z, Tracker.Acceleration.Z, Measured.Z, Config, DeltaSeconds);
+		Tracker.Residual = std::sqrt(RX * RX + RY * RY + RZ * RZ);
+	}
+
+	FVec3 PredictTarget(const FTargetTracker& Tracker, const FTrackerConfig& Config, const FVec3& Measured, float LeadSeconds)
+	{
+		const float HalfLeadSq = 0.5f * LeadSeconds * LeadSeconds;
+		FVec3 Lead = {
+			Tracker.Velocity.X * LeadSeconds + Tracker.Acceleration.X * HalfLeadSq,
+			Tracker.Velocity.Y * LeadSeconds + Tracker.Acceleration.Y * HalfLeadSq,
+			Tracker.Velocity.Z * LeadSeconds + Tracker.Acceleration.Z * HalfLeadSq };
+
+		// Trust the lead less the worse the last prediction was, and never lead further than the limit
+		float Scale = Config.OvershootTolerance > 0.f ? 1.f - Tracker.Residual / Config.OvershootTolerance : 1.f;
+		Scale = Scale < 0.f ? 0.f : Scale;
+
+		const float LeadLength = std::sqrt(Lead.X * Lead.X + Lead.Y * Lead.Y + Lead.Z * Lead.Z);
+		if (LeadLength * Scale > Config.MaxLeadDistance)
+			Scale = Config.MaxLeadDistance / LeadLength;
+
+		return { Measured.X + Lead.X * Scale, Measured.Y + Lead.Y * Scale, Measured.Z + Lead.Z * Scale };
+	}
+
+	void StepRotationSprings(const FRotationSprings& S, float DeltaSeconds)
+	{
+		for (int i = 0; i < S.Num; i++)
+		{
+			const float QX = S.QX[i], QY = S.QY[i], QZ = S.QZ[i], QW = S.QW[i];
+			const float TX = S.TX[i], TY = S.TY[i], TZ = S.TZ[i], TW = S.TW[i];
+
+			// Error rotation D = Q * conjugate(T), taking the short way round
+			float DX = TW * QX - QW * TX - (QY * TZ - QZ * TY);
+			float DY = TW * QY - QW * TY - (QZ * TX - QX * TZ);
+			float DZ = TW * QZ - QW * TZ - (QX * TY - QY * TX);
+			float DW = QW * TW + QX * TX + QY * TY + QZ * TZ;
+			if (DW < 0.f)
+			{
+				DX = -DX; DY = -DY; DZ = -DZ; DW = -DW;
+			}
+
+			// Logarithm of the error: its axis scaled by its angle
+			const float SinHalf = std::sqrt(DX * DX + DY * DY + DZ * DZ);
+			const float LogScale = SinHalf > SpringSmallAngle ? 2.f * std::atan2(SinHalf, DW) / SinHalf : 2.f;
+			const float X0X = DX * LogScale, X0Y = DY * LogScale, X0Z = DZ * LogScale;
+
+			// x(t) = (x0 + (v0 + w x0) t) e^-wt
+			const float W = S.Frequency[i];
+			const float Decay = std::exp(-W * DeltaSeconds);
+			const float JX = S.VX[i] + W * X0X, JY = S.VY[i] + W * X0Y, JZ = S.VZ[i] + W * X0Z;
+			const float X1X = (X0X + JX * DeltaSeconds) * Decay;
+			const float X1Y = (X0Y + JY * DeltaSeconds) * Decay;
+			const float X1Z = (X0Z + JZ * DeltaSeconds) * Decay;
+
+			// v(t) = (v0 - w (v0 + w x0) t) e^-wt
+			const float WDt = W * DeltaSeconds;
+			S.VX[i] = (S.VX[i] - WDt * JX) * Decay;
+			S.VY[i] = (S.VY[i] - WDt * JY) * Decay;
+			S.VZ[i] = (S.VZ[i] - WDt * JZ) * Decay;
+
+			// Back to a rotation, applied on top of the target
+			const float Angle = std::sqrt(X1X * X1X + X1Y * X1Y + X1Z * X1Z);
+			const float ExpScale = Angle > SpringSmallAngle ? std::sin(Angle * 0.5f) / Angle : 0.5f;
+			const float EX = X1X * ExpScale, EY = X1Y * ExpScale, EZ = X1Z * ExpScale;
+			const float EW = std::cos(Angle * 0.5f);
+
+			float NX = EW * TX + TW * EX + (EY * TZ - EZ * TY);
+			float NY = EW * TY + TW * EY + (EZ * TX - EX * TZ);
+			float NZ = EW * TZ + TW * EZ + (EX * TY - EY * TX);
+			float NW = EW * TW - (EX * TX + EY * TY + EZ * TZ);
+
+			const float InvLength = 1.f / std::sqrt(NX * NX + NY * NY + NZ * NZ + NW * NW);
+			S.QX[i] = NX * InvLength;
+			S.QY[i] = NY * InvLength;
+			S.QZ[i] = NZ * InvLength;
+			S.QW[i] = NW * InvLength;
+		}
+	}
+
+	ELockGesture DetectMouseGesture(FGestureState& State, const FGestureConfig& Config, double Time, float WindowDelta, bool bLocked, bool bSoftLock)
+	{
+		if (!bLocked)
+			return ELockGesture::None;
+
+		const float Delta = WindowDelta * Config.MouseTurnScale;
+		const float Magnitude = Delta < 0.f ? -Delta : Delta;
+
+		// Should break soft-lock?
+		if (bSoftLock && Magnitude > Config.BreakMouseDelta)
+		{
+			State.MouseWindowStart = Time;
+			return ELockGesture::BreakLock;
+		}
+
+		// Should try switch target? The cooldown prevents switching multiple times using a single movement
+		if (Magnitude > Config.SwitchMouseDelta && Time - State.LastSwitchTime > Config.SwitchMinDelaySeconds)
+		{
+			State.LastSwitchTime = Time;
+			State.MouseWindowStart = Time;
+			return Delta < 0.f ? ELockGesture::SwitchLeft : ELockGesture::SwitchRight;
+		}
+
+		return ELockGesture::None;
+	}
+
+	ELockGesture DetectStickGesture(FGestureState& State, const FGestureConfig& Config, double Time, float Value, bool bLocked)
+	{
+		const float Magnitude = Value < 0.f ? -Value : Value;
+
+		// Ensure the stick returned to neutral since the last target switch
+		if (Magnitude < Config.SettleStickValue)
+			State.bStickSettled = true;
+
+		if (!bLocked || Magnitude <= Config.SwitchStickValue || !State.bStickSettled)
+			return ELockGesture::None;
+
+		// Stick switches start the mouse cooldown too, so a flick made with both at once only switches once
+		State.bStickSettled = false;
+		State.LastSwitchTime = Time;
+		return Value < 0.f ? ELockGesture::SwitchLeft : ELockGesture::SwitchRight;
+	}
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnHeadlessWorld.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+FDSLockOnHeadlessWorld::FDSLockOnHeadlessWorld()
+	: World(nullptr)
+{
+}
+
+FDSLockOnHeadlessWorld::~FDSLockOnHeadlessWorld()
+{
+	Shutdown();
+}
+
+bool FDSLockOnHeadlessWorld::Initialize(const FString& MapName)
+{
+	check(World == nullptr && GEngine);
+
+	if (MapName.IsEmpty())
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+	}
+	else
+	{
+		UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+		World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (World == nullptr)
+			return false;
+
+		World->AddToRoot();
+		World->WorldType = EWorldType::Game;
+		if (!World->bIsWorldInitialized)
+			World->InitWorld();
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	return true;
+}
+
+void FDSLockOnHeadlessWorld::Tick(float DeltaSeconds)
+{
+	World->Tick(LEVELTICK_All, DeltaSeconds);
+
+	// Nothing else advances the frame counter outside the engine loop, and the lock-on manager caches per frame
+	GFrameCounter++;
+}
+
+void FDSLockOnHeadlessWorld::Shutdown()
+{
+	if (World == nullptr)
+		return;
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	World = nullptr;
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
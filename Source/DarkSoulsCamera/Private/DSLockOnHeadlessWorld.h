@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/**
+* Game world driven by hand, for lock-on commandlets running without a viewport (e.g. with -nullrhi).
+*/
+class FDSLockOnHeadlessWorld
+{
+public:
+	FDSLockOnHeadlessWorld();
+	~FDSLockOnHeadlessWorld();
+
+	/* Loads MapName, or creates an empty world if MapName is empty, and begins play. Returns false if the map can't be loaded */
+	bool Initialize(const FString& MapName);
+
+	/* Ticks the world by a fixed step and advances the frame counter */
+	void Tick(float DeltaSeconds);
+
+	/* Tears the world down. Called automatically on destruction */
+	void Shutdown();
+
+	UWorld* GetWorld() const { return World; }
+
+private:
+	UWorld* World;
+};
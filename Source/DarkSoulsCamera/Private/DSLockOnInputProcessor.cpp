@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnInputProcessor.h"
+#include "Input/Events.h"
+#include "InputCoreTypes.h"
+#include "GameFramework/InputSettings.h"
+
+FDSLockOnInputProcessor::FDSLockOnInputProcessor(int32 InUserIndex)
+	: NumRecorded(0)
+	, UserIndex(InUserIndex)
+{
+	// The analog stick is recorded from its own events. Keys only send down and up, so they're tracked here
+	TArray<FInputAxisKeyMapping> Mappings;
+	UInputSettings::GetInputSettings()->GetAxisMappingByName(TEXT("TurnRate"), Mappings);
+	for (const FInputAxisKeyMapping& Mapping : Mappings)
+	{
+		if (Mapping.Key.IsFloatAxis() || Mapping.Key.IsMouseButton())
+			continue;
+
+		TurnKeys.Add(Mapping.Key);
+		TurnKeySigns.Add(FMath::Sign(Mapping.Scale));
+		TurnKeysHeld.Add(false);
+	}
+}
+
+bool FDSLockOnInputProcessor::HandleMouseMoveEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent)
+{
+	if (MouseEvent.GetUserIndex() == UserIndex && MouseEvent.GetCursorDelta().X != 0.f)
+		Record(MouseEvent.GetCursorDelta().X, false);
+
+	return false;
+}
+
+bool FDSLockOnInputProcessor::HandleAnalogInputEvent(FSlateApplication& SlateApp, const FAnalogInputEvent& InAnalogInputEvent)
+{
+	if (InAnalogInputEvent.GetUserIndex() == UserIndex && InAnalogInputEvent.GetKey() == EKeys::Gamepad_RightX)
+		Record(InAnalogInputEvent.GetAnalogValue(), true);
+
+	return false;
+}
+
+bool FDSLockOnInputProcessor::HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent)
+{
+	if (InKeyEvent.GetUserIndex() == UserIndex && !InKeyEvent.IsRepeat())
+		RecordTurnKey(InKeyEvent.GetKey(), true);
+
+	return false;
+}
+
+bool FDSLockOnInputProcessor::HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent)
+{
+	if (InKeyEvent.GetUserIndex() == UserIndex)
+		RecordTurnKey(InKeyEvent.GetKey(), false);
+
+	return false;
+}
+
+const FDSRawTurnEvent* FDSLockOnInputProcessor::GetEvent(uint32 N) const
+{
+	if (N >= NumRecorded || NumRecorded - N > Capacity)
+		return nullptr;
+
+	return &Events[N % Capacity];
+}
+
+float FDSLockOnInputProcessor::SumMouseSince(uint32 N, double Since) const
+{
+	float Sum = 0.f;
+	for (const FDSRawTurnEvent* Event = GetEvent(N); Event && Event->Time >= Since; Event = N > 0 ? GetEvent(--N) : nullptr)
+	{
+		if (!Event->bStick)
+			Sum += Event->Value;
+	}
+	return Sum;
+}
+
+void FDSLockOnInputProcessor::RecordTurnKey(const FKey& Key, bool bDown)
+{
+	const int32 Index = TurnKeys.Find(Key);
+	if (Index == INDEX_NONE || TurnKeysHeld[Index] == bDown)
+		return;
+
+	TurnKeysHeld[Index] = bDown;
+
+	// Holding both directions cancels out, as it does on the axis
+	float Value = 0.f;
+	for (int32 i = 0; i < TurnKeys.Num(); i++)
+		Value += TurnKeysHeld[i] ? TurnKeySigns[i] : 0.f;
+
+	Record(FMath::Clamp(Value, -1.f, 1.f), true);
+}
+
+void FDSLockOnInputProcessor::Record(float Value, bool bStick)
+{
+	FDSRawTurnEvent& Event = Events[NumRecorded % Capacity];
+	Event.Time = FPlatformTime::Seconds();
+	Event.Value = Value;
+	Event.bStick = bStick;
+	NumRecorded++;
+}
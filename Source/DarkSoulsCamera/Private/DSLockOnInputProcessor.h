@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Framework/Application/IInputProcessor.h"
+#include "InputCoreTypes.h"
+
+/* One raw turn input sample, timestamped when Slate received it */
+struct FDSRawTurnEvent
+{
+	double Time;
+
+	/* Raw mouse delta in pixels, or stick deflection */
+	float Value;
+
+	bool bStick;
+};
+
+/**
+* Records a local player's raw turn input into a ring buffer, ahead of the per-frame axis aggregation, so lock
+* gestures can be detected on event time. Never consumes events. Slate delivers input on the game thread, which is
+* also where the buffer is read. Digital keys bound to the TurnRate axis, such as the arrow keys, are recorded as
+* stick samples: full deflection towards the sign of their axis scale while held, and 0 once released.
+*/
+class FDSLockOnInputProcessor : public IInputProcessor
+{
+public:
+	static const uint32 Capacity = 256;
+
+	FDSLockOnInputProcessor(int32 InUserIndex);
+
+	virtual void Tick(const float DeltaTime, FSlateApplication& SlateApp, TSharedRef<ICursor> Cursor) override {}
+	virtual bool HandleMouseMoveEvent(FSlateApplication& SlateApp, const FPointerEvent& MouseEvent) override;
+	virtual bool HandleAnalogInputEvent(FSlateApplication& SlateApp, const FAnalogInputEvent& InAnalogInputEvent) override;
+	virtual bool HandleKeyDownEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override;
+	virtual bool HandleKeyUpEvent(FSlateApplication& SlateApp, const FKeyEvent& InKeyEvent) override;
+
+	/* Total number of events ever recorded. Event N lives in the ring until Capacity newer events overwrite it */
+	uint32 GetNumRecorded() const { return NumRecorded; }
+
+	/* Event N, or null if it was overwritten or hasn't been recorded yet */
+	const FDSRawTurnEvent* GetEvent(uint32 N) const;
+
+	/* Sum of mouse event values from event N back to, and including, the oldest event at or after Since */
+	float SumMouseSince(uint32 N, double Since) const;
+
+private:
+	void Record(float Value, bool bStick);
+
+	/* Records a stick sample for the turn keys held after Key went down or up */
+	void RecordTurnKey(const FKey& Key, bool bDown);
+
+	FDSRawTurnEvent Events[Capacity];
+	uint32 NumRecorded;
+
+	int32 UserIndex;
+
+	/* Digital keys bound to TurnRate, with the sign of their axis scales and whether each is held */
+	TArray<FKey> TurnKeys;
+	TArray<float> TurnKeySigns;
+	TBitArray<> TurnKeysHeld;
+};
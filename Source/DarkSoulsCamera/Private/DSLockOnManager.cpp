@@ -0,0 +1,1108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "DSTargetComponent.h"
+#include "DSTargetPointComponent.h"
+#include "DSLockArmComponent.h"
+#include "DSLockOnStats.h"
+#include "DSLockOnRecording.h"
+#include "DSLockOnSteering.h"
+#include "DSCharacter.h"
+#include "GameFramework/Controller.h"
+
+TMap<TWeakObjectPtr<UWorld>, TWeakObjectPtr<ADSLockOnManager>> ADSLockOnManager::WorldManagers;
+
+static int32 GDSLockOnParallelMinArms = 4;
+static FAutoConsoleVariableRef CVarDSLockOnParallelMinArms(
+	TEXT("ds.LockOn.ParallelMinArms"),
+	GDSLockOnParallelMinArms,
+	TEXT("Minimum number of lock arms before the batched lock update is spread across worker threads. 0 always runs single threaded."));
+
+static float GDSLockOnRegistrationBudgetMs = 1.f;
+static FAutoConsoleVariableRef CVarDSLockOnRegistrationBudgetMs(
+	TEXT("ds.LockOn.RegistrationBudgetMs"),
+	GDSLockOnRegistrationBudgetMs,
+	TEXT("Milliseconds per frame the lock-on manager spends adding queued targets and creating their deferred physics states. At least one target is added each frame. 0 adds targets as soon as they register."));
+
+static float GDSLockOnQueryCacheCellSize = 100.f;
+static FAutoConsoleVariableRef CVarDSLockOnQueryCacheCellSize(
+	TEXT("ds.LockOn.QueryCacheCellSize"),
+	GDSLockOnQueryCacheCellSize,
+	TEXT("Edge length of the cells lock arms share candidate queries in. Arms in the same cell with the same range, rounded up to the cell size, run one broad phase between them. 0 disables sharing."));
+
+#if DS_LOCKON_DEBUG_DRAW
+static int32 GDSLockOnDrawDebug = 0;
+static FAutoConsoleVariableRef CVarDSLockOnDrawDebug(
+	TEXT("ds.LockOn.DrawDebug"),
+	GDSLockOnDrawDebug,
+	TEXT("Draws the range, candidates and locked target of every lock arm with bDrawDebug set. 0 off, 1 on."));
+#endif
+
+/* Only search for targets when the state machine needs a new one, or to keep line of sight and the switching order fresh */
+static bool NeedsTargetQuery(const FDSLockArmUpdate& Update)
+{
+	return DSLockOnCore::NeedsLockCandidate(Update.LockState) || Update.LineOfSight || Update.LockState.bLocked;
+}
+
+/* Springs between level views can pick up a little roll on the way, which the control rotation leaves out */
+static FRotator GetSteeringRotation(const FQuat& Rotation)
+{
+	FRotator Rotator = Rotation.Rotator();
+	Rotator.Roll = 0.f;
+	return Rotator;
+}
+
+ADSLockOnManager::ADSLockOnManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	bReplicates = false;
+
+	TargetGridCellSize = 500.f;
+	MaxGroupRadius = 0.f;
+	bAllCellsDirty = false;
+	LastUpdateFrame = MAX_uint64;
+	NumQueryCacheEntries = 0;
+}
+
+void ADSLockOnManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	TargetGrid.SetCellSize(TargetGridCellSize);
+}
+
+ADSLockOnManager* ADSLockOnManager::Get(UWorld* World)
+{
+	if (ADSLockOnManager* Manager = Find(World))
+		return Manager;
+
+	// Only game worlds take part in lock-on, and nothing should be spawned while a world is being torn down
+	if (World == nullptr || !World->IsGameWorld() || World->bIsTearingDown)
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ADSLockOnManager* Manager = World->SpawnActor<ADSLockOnManager>(SpawnParams);
+	WorldManagers.Add(World, Manager);
+	return Manager;
+}
+
+ADSLockOnManager* ADSLockOnManager::Find(UWorld* World)
+{
+	const TWeakObjectPtr<ADSLockOnManager>* Manager = WorldManagers.Find(World);
+	return Manager ? Manager->Get() : nullptr;
+}
+
+void ADSLockOnManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	DS_LOCKON_SCOPE(ManagerTick);
+
+	ProcessRegistrationQueue(GDSLockOnRegistrationBudgetMs);
+	UpdateTargetPositions();
+	UpdateLockArms(DeltaSeconds);
+	UpdateRotationSprings(DeltaSeconds);
+
+#if DS_LOCKON_DEBUG_DRAW
+	if (GDSLockOnDrawDebug != 0)
+		DrawDebug();
+#endif
+}
+
+void ADSLockOnManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+
+	for (USceneComponent* Target : Targets)
+	{
+		if (int32* LockOnIndex = GetLockOnIndex(Target))
+			*LockOnIndex = INDEX_NONE;
+	}
+
+	for (USceneComponent* Target : PendingTargets)
+	{
+		int32* LockOnIndex = GetLockOnIndex(Target);
+		if (LockOnIndex == nullptr || *LockOnIndex != PendingLockOnIndex)
+			continue;
+
+		*LockOnIndex = INDEX_NONE;
+
+		// A manager destroyed mid-play never gets to release the collision of targets it left queued
+		UDSTargetComponent* Sphere = Cast<UDSTargetComponent>(Target);
+		if (Sphere && EndPlayReason == EEndPlayReason::Destroyed)
+			Sphere->ReleasePhysicsState();
+	}
+
+	PendingTargets.Reset();
+	Targets.Reset();
+	TargetX.Reset();
+	TargetY.Reset();
+	TargetZ.Reset();
+	TargetRadius.Reset();
+	TargetTeam.Reset();
+	TargetPriority.Reset();
+	TargetThreat.Reset();
+	TargetGroup.Reset();
+	GroupOwners.Reset();
+	GroupTargets.Reset();
+	GroupIndices.Reset();
+	GroupX.Reset();
+	GroupY.Reset();
+	GroupZ.Reset();
+	GroupRadius.Reset();
+	TargetGrid.Reset();
+	LockArms.Reset();
+	SpringQX.Reset();
+	SpringQY.Reset();
+	SpringQZ.Reset();
+	SpringQW.Reset();
+	SpringVX.Reset();
+	SpringVY.Reset();
+	SpringVZ.Reset();
+	SpringsActive.Empty();
+
+	WorldManagers.Remove(GetWorld());
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADSLockOnManager::RegisterTarget(UDSTargetComponent* Target)
+{
+	if (Target)
+		QueueTarget(Target, Target->LockOnIndex);
+}
+
+void ADSLockOnManager::RegisterTarget(UDSTargetPointComponent* Target)
+{
+	if (Target)
+		QueueTarget(Target, Target->LockOnIndex);
+}
+
+void ADSLockOnManager::UnregisterTarget(UDSTargetComponent* Target)
+{
+	if (Target)
+		RemoveTarget(Target, Target->LockOnIndex);
+}
+
+void ADSLockOnManager::UnregisterTarget(UDSTargetPointComponent* Target)
+{
+	if (Target)
+		RemoveTarget(Target, Target->LockOnIndex);
+}
+
+float ADSLockOnManager::GetTargetRadius(const USceneComponent* Target)
+{
+	if (const UDSTargetPointComponent* Point = Cast<UDSTargetPointComponent>(Target))
+		return Point->GetScaledRadius();
+
+	if (const UDSTargetComponent* Sphere = Cast<UDSTargetComponent>(Target))
+		return Sphere->GetScaledSphereRadius();
+
+	return 0.f;
+}
+
+int32 ADSLockOnManager::GetTargetTeam(const USceneComponent* Target)
+{
+	if (const UDSTargetPointComponent* Point = Cast<UDSTargetPointComponent>(Target))
+		return Point->Team;
+
+	if (const UDSTargetComponent* Sphere = Cast<UDSTargetComponent>(Target))
+		return Sphere->Team;
+
+	return 0;
+}
+
+int32* ADSLockOnManager::GetLockOnIndex(USceneComponent* Target)
+{
+	if (UDSTargetPointComponent* Point = Cast<UDSTargetPointComponent>(Target))
+		return &Point->LockOnIndex;
+
+	if (UDSTargetComponent* Sphere = Cast<UDSTargetComponent>(Target))
+		return &Sphere->LockOnIndex;
+
+	return nullptr;
+}
+
+void ADSLockOnManager::QueueTarget(USceneComponent* Target, int32& LockOnIndex)
+{
+	if (LockOnIndex != INDEX_NONE)
+		return;
+
+	if (GDSLockOnRegistrationBudgetMs > 0.f)
+	{
+		LockOnIndex = PendingLockOnIndex;
+		PendingTargets.Add(Target);
+		SET_DWORD_STAT(STAT_DSLockOn_TargetsQueued, PendingTargets.Num());
+		return;
+	}
+
+	DS_LOCKON_SCOPE(Registration);
+
+	const int32 Group = InsertTarget(Target);
+	UpdateGroupBounds(Group);
+	MaxGroupRadius = FMath::Max(MaxGroupRadius, GroupRadius[Group]);
+
+	DS_LOCKON_COUNT(TargetsRegistered, 1);
+}
+
+int32 ADSLockOnManager::ProcessRegistrationQueue(float BudgetMs)
+{
+	if (PendingTargets.Num() == 0)
+		return 0;
+
+	DS_LOCKON_SCOPE(Registration);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const uint64 BudgetCycles = BudgetMs > 0.f ? uint64(BudgetMs / 1000.0 / FPlatformTime::GetSecondsPerCycle64()) : MAX_uint64;
+
+	RegisteredGroups.Reset();
+
+	int32 NumProcessed = 0;
+	int32 NumAdded = 0;
+	do
+	{
+		// Null if the component was garbage collected while queued
+		USceneComponent* Target = PendingTargets[NumProcessed++];
+		if (Target == nullptr)
+			continue;
+
+		// Unregistered while queued, or queued again after that and already added from its later entry
+		int32* LockOnIndex = GetLockOnIndex(Target);
+		if (*LockOnIndex != PendingLockOnIndex)
+			continue;
+
+		*LockOnIndex = INDEX_NONE;
+		NumAdded++;
+		const int32 Group = InsertTarget(Target);
+		if (Group != INDEX_NONE)
+			RegisteredGroups.Add(Group);
+	}
+	while (NumProcessed < PendingTargets.Num() && FPlatformTime::Cycles64() - StartCycles < BudgetCycles);
+
+	PendingTargets.RemoveAt(0, NumProcessed, false);
+
+	// Actors register all their targets together, so rebuild each group's bounds once rather than once per target
+	RegisteredGroups.Sort();
+	for (int32 n = 0; n < RegisteredGroups.Num(); n++)
+	{
+		const int32 Group = RegisteredGroups[n];
+		if (n > 0 && Group == RegisteredGroups[n - 1])
+			continue;
+
+		UpdateGroupBounds(Group);
+		MaxGroupRadius = FMath::Max(MaxGroupRadius, GroupRadius[Group]);
+	}
+
+	DS_LOCKON_COUNT(TargetsRegistered, NumAdded);
+	SET_DWORD_STAT(STAT_DSLockOn_TargetsQueued, PendingTargets.Num());
+
+#if DS_LOCKON_STATS
+	FDSLockOnCounters::MaxRegistrationCycles = FMath::Max(FDSLockOnCounters::MaxRegistrationCycles, FPlatformTime::Cycles64() - StartCycles);
+#endif
+
+	return NumProcessed;
+}
+
+int32 ADSLockOnManager::InsertTarget(USceneComponent* Target)
+{
+	if (UDSTargetPointComponent* Point = Cast<UDSTargetPointComponent>(Target))
+		return AddTarget(Point, Point->LockOnIndex, Point->GetScaledRadius(), Point->Team, Point->Priority, Point->Threat);
+
+	UDSTargetComponent* Sphere = CastChecked<UDSTargetComponent>(Target);
+
+	// The target takes part in lock-on from now, so its collision can too
+	Sphere->ReleasePhysicsState();
+
+	return AddTarget(Sphere, Sphere->LockOnIndex, Sphere->GetScaledSphereRadius(), Sphere->Team, Sphere->Priority, Sphere->Threat);
+}
+
+int32 ADSLockOnManager::AddTarget(USceneComponent* Target, int32& LockOnIndex, float Radius, int32 Team, float Priority, float Threat)
+{
+	if (LockOnIndex != INDEX_NONE)
+		return INDEX_NONE;
+
+	const FVector Location = Target->GetComponentLocation();
+	const AActor* Owner = Target->GetOwner();
+
+	int32 Group;
+	if (const int32* ExistingGroup = GroupIndices.Find(Owner))
+	{
+		Group = *ExistingGroup;
+	}
+	else
+	{
+		Group = GroupOwners.Add(Owner);
+		GroupTargets.AddDefaulted();
+		GroupX.Add(Location.X);
+		GroupY.Add(Location.Y);
+		GroupZ.Add(Location.Z);
+		GroupRadius.Add(0.f);
+		TargetGrid.Add(Group, Location);
+		GroupIndices.Add(Owner, Group);
+	}
+
+	LockOnIndex = Targets.Add(Target);
+	TargetX.Add(Location.X);
+	TargetY.Add(Location.Y);
+	TargetZ.Add(Location.Z);
+	TargetRadius.Add(Radius);
+	TargetTeam.Add(Team);
+	TargetPriority.Add(Priority);
+	TargetThreat.Add(Threat);
+	TargetGroup.Add(Group);
+	GroupTargets[Group].Add(LockOnIndex);
+
+	return Group;
+}
+
+void ADSLockOnManager::RemoveTarget(USceneComponent* Target, int32& LockOnIndex)
+{
+	// Left in the queue rather than searched for, so streaming out a level full of queued targets stays linear
+	if (LockOnIndex == PendingLockOnIndex)
+	{
+		LockOnIndex = INDEX_NONE;
+		return;
+	}
+
+	if (!Targets.IsValidIndex(LockOnIndex) || Targets[LockOnIndex] != Target)
+		return;
+
+	const int32 Index = LockOnIndex;
+	const int32 Group = TargetGroup[Index];
+	const int32 LastIndex = Targets.Num() - 1;
+
+	GroupTargets[Group].RemoveSingleSwap(Index, false);
+
+	// Swap the last entry into the freed slot to keep the arrays dense
+	if (Index != LastIndex)
+	{
+		TArray<int32>& LastGroupTargets = GroupTargets[TargetGroup[LastIndex]];
+		LastGroupTargets[LastGroupTargets.Find(LastIndex)] = Index;
+	}
+
+	Targets.RemoveAtSwap(Index, 1, false);
+	TargetX.RemoveAtSwap(Index, 1, false);
+	TargetY.RemoveAtSwap(Index, 1, false);
+	TargetZ.RemoveAtSwap(Index, 1, false);
+	TargetRadius.RemoveAtSwap(Index, 1, false);
+	TargetTeam.RemoveAtSwap(Index, 1, false);
+	TargetPriority.RemoveAtSwap(Index, 1, false);
+	TargetThreat.RemoveAtSwap(Index, 1, false);
+	TargetGroup.RemoveAtSwap(Index, 1, false);
+
+	if (Targets.IsValidIndex(Index))
+		*GetLockOnIndex(Targets[Index]) = Index;
+
+	LockOnIndex = INDEX_NONE;
+
+	if (GroupTargets[Group].Num() > 0)
+		UpdateGroupBounds(Group);
+	else
+		RemoveGroup(Group);
+}
+
+void ADSLockOnManager::UpdateGroupBounds(int32 Group)
+{
+	const TArray<int32>& Members = GroupTargets[Group];
+
+	FVector Min(MAX_flt);
+	FVector Max(-MAX_flt);
+	for (int32 i : Members)
+	{
+		const FVector Location(TargetX[i], TargetY[i], TargetZ[i]);
+		Min = Min.ComponentMin(Location);
+		Max = Max.ComponentMax(Location);
+	}
+
+	const FVector Center = (Min + Max) * .5f;
+	float Radius = 0.f;
+	for (int32 i : Members)
+		Radius = FMath::Max(Radius, FVector::Dist(Center, FVector(TargetX[i], TargetY[i], TargetZ[i])) + TargetRadius[i]);
+
+	// Moving within a cell can still cross an arm's range, so both the cell left and the cell entered are events
+	MarkCellDirty(TargetGrid.GetCell(FVector(GroupX[Group], GroupY[Group], GroupZ[Group])));
+	MarkCellDirty(TargetGrid.GetCell(Center));
+
+	GroupX[Group] = Center.X;
+	GroupY[Group] = Center.Y;
+	GroupZ[Group] = Center.Z;
+	GroupRadius[Group] = Radius;
+
+	TargetGrid.Move(Group, Center);
+}
+
+void ADSLockOnManager::RemoveGroup(int32 Group)
+{
+	MarkCellDirty(TargetGrid.GetCell(FVector(GroupX[Group], GroupY[Group], GroupZ[Group])));
+	GroupIndices.Remove(GroupOwners[Group]);
+
+	GroupOwners.RemoveAtSwap(Group, 1, false);
+	GroupTargets.RemoveAtSwap(Group, 1, false);
+	GroupX.RemoveAtSwap(Group, 1, false);
+	GroupY.RemoveAtSwap(Group, 1, false);
+	GroupZ.RemoveAtSwap(Group, 1, false);
+	GroupRadius.RemoveAtSwap(Group, 1, false);
+	TargetGrid.RemoveAtSwap(Group);
+
+	if (GroupOwners.IsValidIndex(Group))
+	{
+		GroupIndices[GroupOwners[Group]] = Group;
+		for (int32 i : GroupTargets[Group])
+			TargetGroup[i] = Group;
+	}
+}
+
+void ADSLockOnManager::RegisterLockArm(UDSLockArmComponent* LockArm)
+{
+	if (LockArm == nullptr || LockArms.Contains(LockArm))
+		return;
+
+	LockArms.Add(LockArm);
+
+	// Identity and at rest until the arm first steers its pawn
+	SpringQX.Add(0.f);
+	SpringQY.Add(0.f);
+	SpringQZ.Add(0.f);
+	SpringQW.Add(1.f);
+	SpringVX.Add(0.f);
+	SpringVY.Add(0.f);
+	SpringVZ.Add(0.f);
+	SpringsActive.Add(false);
+}
+
+void ADSLockOnManager::UnregisterLockArm(UDSLockArmComponent* LockArm)
+{
+	const int32 Index = LockArms.Find(LockArm);
+	if (Index == INDEX_NONE)
+		return;
+
+	LockArms.RemoveAtSwap(Index, 1, false);
+
+	// The arm moved into the freed slot finds another arm's candidates there, so its shell is evaluated afresh
+	if (LockArms.IsValidIndex(Index))
+		LockArms[Index]->SoftLockShell.bValid = false;
+
+	SpringQX.RemoveAtSwap(Index, 1, false);
+	SpringQY.RemoveAtSwap(Index, 1, false);
+	SpringQZ.RemoveAtSwap(Index, 1, false);
+	SpringQW.RemoveAtSwap(Index, 1, false);
+	SpringVX.RemoveAtSwap(Index, 1, false);
+	SpringVY.RemoveAtSwap(Index, 1, false);
+	SpringVZ.RemoveAtSwap(Index, 1, false);
+	SpringsActive.RemoveAtSwap(Index);
+}
+
+void ADSLockOnManager::GetTargetsInRadius(const FVector& Origin, float Radius, const AActor* IgnoreActor, TArray<USceneComponent*>& OutTargets, int32 IgnoreTeam)
+{
+	UpdateTargetPositions();
+	QueryTargets(Origin, Radius, IgnoreActor, IgnoreTeam, QueryIndices, QueryGroups);
+
+	for (int32 i : QueryIndices)
+	{
+		OutTargets.Add(Targets[i]);
+	}
+}
+
+void ADSLockOnManager::GatherCandidates(const FVector& Origin, float Radius, const AActor* IgnoreActor, FDSCandidateSet& OutCandidates, int32 IgnoreTeam)
+{
+	UpdateTargetPositions();
+	QueryTargets(Origin, Radius, IgnoreActor, IgnoreTeam, QueryIndices, QueryGroups);
+
+	for (int32 i : QueryIndices)
+	{
+		OutCandidates.Add(Targets[i], TargetX[i], TargetY[i], TargetZ[i], TargetPriority[i], TargetThreat[i]);
+	}
+}
+
+void ADSLockOnManager::QueryTargets(const FVector& Origin, float Radius, const AActor* IgnoreActor, int32 IgnoreTeam, TArray<int32>& OutIndices, TArray<int32>& OutGroups) const
+{
+	// Broad phase over actor groups. Pad the grid query so large groups centered outside the radius are still found
+	OutIndices.Reset();
+	TargetGrid.Query(Origin, Radius + MaxGroupRadius, OutIndices);
+
+	const int32 NumGroups = DSLockOnCore::FilterInRange(GroupX.GetData(), GroupY.GetData(), GroupZ.GetData(), GroupRadius.GetData(),
+		OutIndices.GetData(), OutIndices.Num(), { Origin.X, Origin.Y, Origin.Z }, Radius, OutIndices.GetData());
+
+	OutGroups.Reset();
+	OutGroups.Append(OutIndices.GetData(), NumGroups);
+	OutIndices.Reset();
+
+	auto AddGroupTargets = [&](int32 Group)
+	{
+		for (int32 i : GroupTargets[Group])
+		{
+			if (IgnoreTeam == 0 || TargetTeam[i] != IgnoreTeam)
+				OutIndices.Add(i);
+		}
+	};
+
+	// Every target of a group wholly inside the radius is in range. The rest are tested one by one after them
+	int32 NumPartial = 0;
+	for (int32 n = 0; n < OutGroups.Num(); n++)
+	{
+		const int32 Group = OutGroups[n];
+		if (IgnoreActor && GroupOwners[Group] == IgnoreActor)
+			continue;
+
+		const float Distance = FVector::Dist(Origin, FVector(GroupX[Group], GroupY[Group], GroupZ[Group]));
+		if (Distance + GroupRadius[Group] <= Radius)
+			AddGroupTargets(Group);
+		else
+			OutGroups[NumPartial++] = Group;
+	}
+
+	const int32 NumInside = OutIndices.Num();
+	for (int32 n = 0; n < NumPartial; n++)
+		AddGroupTargets(OutGroups[n]);
+
+	// Narrow phase, compacting the surviving indices in place
+	const int32 NumFound = NumInside + DSLockOnCore::FilterInRange(TargetX.GetData(), TargetY.GetData(), TargetZ.GetData(), TargetRadius.GetData(),
+		OutIndices.GetData() + NumInside, OutIndices.Num() - NumInside, { Origin.X, Origin.Y, Origin.Z }, Radius, OutIndices.GetData() + NumInside);
+
+	OutIndices.SetNum(NumFound, false);
+}
+
+void ADSLockOnManager::QueryGroupTargets(const FVector& Origin, float Radius, TArray<int32>& OutIndices, TArray<int32>& OutGroups) const
+{
+	OutIndices.Reset();
+	TargetGrid.Query(Origin, Radius + MaxGroupRadius, OutIndices);
+
+	const int32 NumGroups = DSLockOnCore::FilterInRange(GroupX.GetData(), GroupY.GetData(), GroupZ.GetData(), GroupRadius.GetData(),
+		OutIndices.GetData(), OutIndices.Num(), { Origin.X, Origin.Y, Origin.Z }, Radius, OutIndices.GetData());
+
+	OutGroups.Reset();
+	OutGroups.Append(OutIndices.GetData(), NumGroups);
+	OutIndices.Reset();
+
+	for (int32 Group : OutGroups)
+		OutIndices.Append(GroupTargets[Group]);
+}
+
+void ADSLockOnManager::FilterSharedQuery(const TArray<int32>& SharedIndices, const FVector& Origin, float Radius, const AActor* IgnoreActor, int32 IgnoreTeam, TArray<int32>& OutIndices) const
+{
+	OutIndices.Reset();
+	for (int32 i : SharedIndices)
+	{
+		if ((IgnoreTeam == 0 || TargetTeam[i] != IgnoreTeam) && (!IgnoreActor || GroupOwners[TargetGroup[i]] != IgnoreActor))
+			OutIndices.Add(i);
+	}
+
+	const int32 NumFound = DSLockOnCore::FilterInRange(TargetX.GetData(), TargetY.GetData(), TargetZ.GetData(), TargetRadius.GetData(),
+		OutIndices.GetData(), OutIndices.Num(), { Origin.X, Origin.Y, Origin.Z }, Radius, OutIndices.GetData());
+
+	OutIndices.SetNum(NumFound, false);
+}
+
+bool ADSLockOnManager::StartRecording(const FString& Filename)
+{
+#if DS_LOCKON_RECORDING
+	StopRecording();
+
+	TSharedPtr<FDSLockOnRecorder> NewRecorder = MakeShared<FDSLockOnRecorder>();
+	if (!NewRecorder->Open(Filename))
+		return false;
+
+	Recorder = NewRecorder;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ADSLockOnManager::StopRecording()
+{
+	Recorder.Reset();
+}
+
+void ADSLockOnManager::BuildQueryCache(int32 NumArms)
+{
+	// Rebuilt every lock update, as targets and arms move between frames
+	QueryCacheKeys.Reset();
+	NumQueryCacheEntries = 0;
+
+	const float CellSize = GDSLockOnQueryCacheCellSize;
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		FDSLockArmUpdate& Update = LockArmUpdates[i];
+		Update.QueryCacheEntry = INDEX_NONE;
+
+		if (Update.bSkip || !NeedsTargetQuery(Update))
+			continue;
+
+		if (CellSize <= 0.f)
+		{
+			DS_LOCKON_COUNT(QueryCacheMisses, 1);
+			continue;
+		}
+
+		const FQueryCacheKey Key = {
+			FIntVector(FMath::FloorToInt(Update.Origin.X / CellSize), FMath::FloorToInt(Update.Origin.Y / CellSize), FMath::FloorToInt(Update.Origin.Z / CellSize)),
+			FMath::CeilToInt(Update.MaxTargetLockDistance / CellSize) };
+
+		if (const int32* Existing = QueryCacheKeys.Find(Key))
+		{
+			Update.QueryCacheEntry = *Existing;
+			QueryCache[*Existing].NumArms++;
+			DS_LOCKON_COUNT(QueryCacheHits, 1);
+			continue;
+		}
+
+		if (NumQueryCacheEntries == QueryCache.Num())
+			QueryCache.AddDefaulted();
+
+		// Query from the cell center, padded by half the cell diagonal so the result covers the range of any arm in the cell
+		FQueryCacheEntry& Entry = QueryCache[NumQueryCacheEntries];
+		Entry.Center = (FVector(Key.Cell) + 0.5f) * CellSize;
+		Entry.Radius = Key.Range * CellSize + 0.5f * FMath::Sqrt(3.f) * CellSize;
+		Entry.NumArms = 1;
+
+		Update.QueryCacheEntry = NumQueryCacheEntries;
+		QueryCacheKeys.Add(Key, NumQueryCacheEntries++);
+		DS_LOCKON_COUNT(QueryCacheMisses, 1);
+	}
+
+	// An arm alone in its cell runs its own exact query, so sharing costs it nothing
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		FDSLockArmUpdate& Update = LockArmUpdates[i];
+		if (Update.QueryCacheEntry != INDEX_NONE && QueryCache[Update.QueryCacheEntry].NumArms == 1)
+			Update.QueryCacheEntry = INDEX_NONE;
+	}
+
+	// Shared broad phases, read by the arms on worker threads afterwards
+	ParallelFor(NumQueryCacheEntries, [this](int32 i)
+	{
+		FQueryCacheEntry& Entry = QueryCache[i];
+		if (Entry.NumArms > 1)
+			QueryGroupTargets(Entry.Center, Entry.Radius, Entry.Indices, Entry.Groups);
+	}, GDSLockOnParallelMinArms <= 0 || NumQueryCacheEntries < GDSLockOnParallelMinArms);
+}
+
+void ADSLockOnManager::UpdateLockArms(float DeltaSeconds)
+{
+	const uint64 UpdateStartCycles = FPlatformTime::Cycles64();
+
+	const int32 NumArms = LockArms.Num();
+	LockArmUpdates.SetNum(NumArms, false);
+	LockArmIndices.SetNum(NumArms, false);
+	LockArmGroups.SetNum(NumArms, false);
+	LockArmCandidates.SetNum(NumArms, false);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+
+	// Gather inputs on the game thread
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		UDSLockArmComponent* Arm = LockArms[i];
+		FDSLockArmUpdate& Update = LockArmUpdates[i];
+		Update.bRefreshLineOfSight = false;
+
+		// Simulated proxies take their lock state from replication
+		if (!Arm->RunsLockLogic())
+		{
+			Update.bSkip = true;
+			continue;
+		}
+
+		// Fixed-rate logic, independent of the frame rate. Leftover time carries over, but never more than one step
+		const float LogicRate = Arm->GetLockLogicRate();
+		if (LogicRate > 0.f)
+		{
+			const float LogicStep = 1.f / LogicRate;
+			Arm->LockLogicAccumulator = FMath::Min(Arm->LockLogicAccumulator + DeltaSeconds, 2.f * LogicStep);
+
+			if (Arm->LockLogicAccumulator < LogicStep)
+			{
+				Update.bSkip = true;
+
+				// Events are only kept for a frame, so latch any in the shell of an arm that isn't due yet
+				if (Arm->SoftLockShell.bValid && HasEventsInShell(Arm->SoftLockShell.Origin, Arm->MaxTargetLockDistance + Arm->SoftLockShellTolerance))
+					Arm->SoftLockShell.bValid = false;
+				continue;
+			}
+			Arm->LockLogicAccumulator -= LogicStep;
+		}
+
+		Update.Origin = Arm->GetComponentLocation();
+		Update.Forward = Arm->GetForwardVector();
+		Update.IgnoreActor = Arm->GetOwner();
+		Update.IgnoreTeam = Arm->Team;
+		Update.MaxTargetLockDistance = Arm->MaxTargetLockDistance;
+
+		Update.LockState.bLocked = Arm->IsCameraLockedToTarget();
+		Update.LockState.bUseSoftLock = Arm->bUseSoftLock;
+		Update.LockState.bSoftlockRequiresReset = Arm->bSoftlockRequiresReset;
+
+		// Break lock if player is too far from target
+		Update.LockState.bOutOfRange = Update.LockState.bLocked && DSLockOnCore::IsOutOfRange(Arm->GetLockFrame().Distance,
+			GetTargetRadius(Arm->CameraTarget), Arm->MaxTargetLockDistance, Arm->RangeBreakHysteresis);
+
+		// Or if the target has been hidden behind something for too long
+		Update.LockState.bLostSight = Arm->HasLostSightOfTarget();
+		Update.LineOfSight = Arm->bCheckLineOfSight ? &Arm->LineOfSight : nullptr;
+		Update.CandidateRing = &Arm->CandidateRing;
+		Update.bScreenSpace = Arm->bScreenSpaceSelection && Arm->GetCameraViewProjection(Update.ViewProjection);
+		Update.ScreenMargin = Arm->ScreenMargin;
+		Update.SwitchOrderTolerance = Arm->SwitchOrderTolerance;
+		Update.ScoringTables = Arm->GetScoringTables();
+		Update.RecentTargets = &Arm->RecentTargets;
+		Update.WorldTime = WorldTime;
+
+		// An idle soft-lock arm gives the same result as last time unless the arm moved or turned past its shell
+		// tolerances, its state changed, something happened in its range shell or its fallback re-evaluation is due.
+		// The shell keeps the evaluated origin, so slow drift still adds up to a re-evaluation
+		UDSLockArmComponent::FSoftLockShell& Shell = Arm->SoftLockShell;
+		const bool bIdleSoftLock = !Update.LockState.bLocked && Update.LockState.bUseSoftLock;
+
+		Update.bSkip = bIdleSoftLock && Shell.bValid
+			&& FVector::DistSquared(Shell.Origin, Update.Origin) <= FMath::Square(Arm->SoftLockShellTolerance)
+			&& (Shell.Forward | Update.Forward) >= FMath::Cos(FMath::DegreesToRadians(Arm->SoftLockShellAngle))
+			&& Shell.bRequiresReset == Update.LockState.bSoftlockRequiresReset
+			&& WorldTime < Shell.NextFallbackTime
+			&& !HasEventsInShell(Shell.Origin, Update.MaxTargetLockDistance + Arm->SoftLockShellTolerance);
+
+		if (bIdleSoftLock && Update.bSkip)
+		{
+			DS_LOCKON_COUNT(SoftLockSkips, 1);
+
+			// Nothing in range moved, but a wall between the arm and a target may have. Expired results are traced again,
+			// and one that changes invalidates the shell
+			Update.bRefreshLineOfSight = Shell.bOccludedCandidates && Arm->bCheckLineOfSight;
+		}
+		else if (bIdleSoftLock)
+		{
+			DS_LOCKON_COUNT(SoftLockEvaluations, 1);
+			Shell.bValid = true;
+			Shell.Origin = Update.Origin;
+			Shell.Forward = Update.Forward;
+			Shell.NextFallbackTime = Arm->SoftLockFallbackRate > 0.f ? WorldTime + 1.f / Arm->SoftLockFallbackRate : MAX_flt;
+		}
+		else
+		{
+			Shell.bValid = false;
+		}
+	}
+
+	BuildQueryCache(NumArms);
+
+	// Evaluate every arm against the immutable position snapshot
+	ParallelFor(NumArms, [this](int32 i)
+	{
+		EvaluateLockArm(LockArmUpdates[i], LockArmIndices[i], LockArmGroups[i], LockArmCandidates[i]);
+	}, GDSLockOnParallelMinArms <= 0 || NumArms < GDSLockOnParallelMinArms);
+
+#if DS_LOCKON_RECORDING
+	// Before applying, while the arms still hold the state this update was evaluated against
+	if (Recorder.IsValid())
+		Recorder->RecordFrame(*this, DeltaSeconds, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - UpdateStartCycles));
+#endif
+
+	// Apply results on the game thread
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		// A skipped arm's candidates are still the ones its shell was evaluated with, as nothing in range has moved since
+		if (LockArmUpdates[i].bRefreshLineOfSight)
+			LockArms[i]->QueueLineOfSightTraces(LockArmCandidates[i]);
+
+		if (LockArmUpdates[i].bSkip)
+			continue;
+
+		LockArms[i]->ApplyLockAction(LockArmUpdates[i].Action, LockArmUpdates[i].NewTarget);
+
+		// Applying the action may have cleared the reset flag, which the shell compares against next frame
+		LockArms[i]->SoftLockShell.bRequiresReset = LockArms[i]->bSoftlockRequiresReset;
+		LockArms[i]->SoftLockShell.bOccludedCandidates = LockArmUpdates[i].bOccludedCandidates;
+
+		// The next logic update picks again, whether or not the awaited trace changed anything
+		if (LockArmUpdates[i].bAwaitingTrace)
+			LockArms[i]->SoftLockShell.bValid = false;
+
+		// Outside the action's request suppression, as the player asked for these
+		if (LockArms[i]->DeferredLock != UDSLockArmComponent::EDeferredLock::None)
+			LockArms[i]->RetryDeferredLock();
+
+		// One batch of traces per logic update, for results to be read on a later one
+		if (LockArmUpdates[i].LineOfSight)
+			LockArms[i]->QueueLineOfSightTraces(LockArmCandidates[i]);
+	}
+
+	// Settle every arm's lock frame here, after any target change, so later ticks this frame share it
+	for (UDSLockArmComponent* Arm : LockArms)
+		Arm->GetLockFrame();
+
+	// Every arm has now seen this frame's events
+	DirtyCells.Reset();
+	bAllCellsDirty = false;
+}
+
+void ADSLockOnManager::UpdateRotationSprings(float DeltaSeconds)
+{
+	const int32 NumArms = LockArms.Num();
+	SpringTX.SetNumUninitialized(NumArms, false);
+	SpringTY.SetNumUninitialized(NumArms, false);
+	SpringTZ.SetNumUninitialized(NumArms, false);
+	SpringTW.SetNumUninitialized(NumArms, false);
+	SpringFrequency.SetNumUninitialized(NumArms, false);
+
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		UDSLockArmComponent* Arm = LockArms[i];
+		const ADSCharacter* Character = Cast<ADSCharacter>(Arm->GetOwner());
+		const AController* Controller = Character ? Character->GetController() : nullptr;
+
+		// Control rotation belongs to whoever controls the pawn. Remote players send theirs with their moves, and simulated proxies have no controller
+		const FDSLockFrame& LockFrame = Arm->GetLockFrame();
+		if (Controller == nullptr || !LockFrame.bValid || !Character->IsLocallyControlled())
+		{
+			// At rest on its own rotation, so the batched step leaves it where it is
+			SpringsActive[i] = false;
+			SpringTX[i] = SpringQX[i];
+			SpringTY[i] = SpringQY[i];
+			SpringTZ[i] = SpringQZ[i];
+			SpringTW[i] = SpringQW[i];
+			SpringVX[i] = SpringVY[i] = SpringVZ[i] = 0.f;
+			SpringFrequency[i] = 0.f;
+			continue;
+		}
+
+		// Start from the current view when the lock starts, or if something else turned the controller since the last step
+		const FRotator ControlRotation = Controller->GetControlRotation();
+		if (!SpringsActive[i] || !ControlRotation.Equals(GetSteeringRotation(FQuat(SpringQX[i], SpringQY[i], SpringQZ[i], SpringQW[i])), 1.e-2f))
+		{
+			const FQuat Current = ControlRotation.Quaternion();
+			SpringQX[i] = Current.X;
+			SpringQY[i] = Current.Y;
+			SpringQZ[i] = Current.Z;
+			SpringQW[i] = Current.W;
+
+			if (!SpringsActive[i])
+				SpringVX[i] = SpringVY[i] = SpringVZ[i] = 0.f;
+		}
+		SpringsActive[i] = true;
+
+		// Rotation from the arm pivot to the target, or to where it's heading with predictive tracking
+		const FQuat Target = LockFrame.AimRotation.Quaternion();
+		SpringTX[i] = Target.X;
+		SpringTY[i] = Target.Y;
+		SpringTZ[i] = Target.Z;
+		SpringTW[i] = Target.W;
+		SpringFrequency[i] = Character->LockonControlRotationRate;
+	}
+
+	const DSLockOnCore::FRotationSprings Springs = {
+		SpringQX.GetData(), SpringQY.GetData(), SpringQZ.GetData(), SpringQW.GetData(),
+		SpringVX.GetData(), SpringVY.GetData(), SpringVZ.GetData(),
+		SpringTX.GetData(), SpringTY.GetData(), SpringTZ.GetData(), SpringTW.GetData(),
+		SpringFrequency.GetData(), NumArms };
+
+	DSLockOnSteering::StepRotationSprings(Springs, DeltaSeconds);
+
+	for (int32 i = 0; i < NumArms; i++)
+	{
+		if (SpringsActive[i])
+		{
+			AController* Controller = CastChecked<APawn>(LockArms[i]->GetOwner())->GetController();
+			Controller->SetControlRotation(GetSteeringRotation(FQuat(SpringQX[i], SpringQY[i], SpringQZ[i], SpringQW[i])));
+		}
+	}
+}
+
+void ADSLockOnManager::DrawDebug()
+{
+#if DS_LOCKON_DEBUG_DRAW
+	ULineBatchComponent* LineBatcher = GetWorld()->LineBatcher;
+	if (LineBatcher == nullptr)
+		return;
+
+	DebugLines.Reset();
+
+	auto AddCross = [this](const FVector& Center, float Size, const FColor& Color)
+	{
+		DebugLines.Emplace(Center - FVector(Size, 0.f, 0.f), Center + FVector(Size, 0.f, 0.f), Color, 0.f, 0.f, SDPG_World);
+		DebugLines.Emplace(Center - FVector(0.f, Size, 0.f), Center + FVector(0.f, Size, 0.f), Color, 0.f, 0.f, SDPG_World);
+		DebugLines.Emplace(Center - FVector(0.f, 0.f, Size), Center + FVector(0.f, 0.f, Size), Color, 0.f, 0.f, SDPG_World);
+	};
+
+	const int32 NumRangeSegments = 32;
+
+	for (int32 i = 0; i < LockArms.Num(); i++)
+	{
+		UDSLockArmComponent* Arm = LockArms[i];
+		if (!Arm->bDrawDebug)
+			continue;
+
+		const FVector Origin = Arm->GetComponentLocation();
+		const float Range = Arm->MaxTargetLockDistance;
+
+		// Lock range as a ring, coloured by soft-lock state
+		const FColor RangeColor = !Arm->bUseSoftLock ? FColor::Cyan : Arm->bSoftlockRequiresReset ? FColor::Orange : FColor::Yellow;
+		FVector Previous = Origin + FVector(Range, 0.f, 0.f);
+		for (int32 Segment = 1; Segment <= NumRangeSegments; Segment++)
+		{
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, 2.f * PI * Segment / NumRangeSegments);
+
+			const FVector Next = Origin + FVector(Cos * Range, Sin * Range, 0.f);
+			DebugLines.Emplace(Previous, Next, RangeColor, 0.f, 0.f, SDPG_World);
+			Previous = Next;
+		}
+
+		// Candidates from the arm's last lock update. Drawn from the packed positions, so targets destroyed since aren't touched
+		const FDSCandidateSet& Candidates = LockArmCandidates[i];
+		for (int32 c = 0; c < Candidates.Num(); c++)
+		{
+			const bool bOccluded = Arm->bCheckLineOfSight && Arm->LineOfSight.IsOccluded(Candidates.Targets[c]);
+			DebugLines.Emplace(Origin, FVector(Candidates.X[c], Candidates.Y[c], Candidates.Z[c]), bOccluded ? FColor::Silver : FColor::Green, 0.f, 0.f, SDPG_World);
+		}
+
+		const FDSLockFrame& Frame = Arm->GetLockFrame();
+		if (Frame.bValid)
+		{
+			AddCross(Frame.TargetLocation, 20.f, FColor::Red);
+
+			if (Frame.AimLocation != Frame.TargetLocation)
+				AddCross(Frame.AimLocation, 10.f, FColor::Magenta);
+		}
+	}
+
+	if (DebugLines.Num() > 0)
+		LineBatcher->DrawLines(DebugLines);
+#endif
+}
+
+bool ADSLockOnManager::HasEventsInShell(const FVector& Origin, float Radius) const
+{
+	if (bAllCellsDirty)
+		return true;
+
+	if (DirtyCells.Num() == 0)
+		return false;
+
+	const FIntVector Min = TargetGrid.GetCell(Origin - FVector(Radius + MaxGroupRadius));
+	const FIntVector Max = TargetGrid.GetCell(Origin + FVector(Radius + MaxGroupRadius));
+
+	for (const FIntVector& Cell : DirtyCells)
+	{
+		if (Cell.X >= Min.X && Cell.X <= Max.X && Cell.Y >= Min.Y && Cell.Y <= Max.Y && Cell.Z >= Min.Z && Cell.Z <= Max.Z)
+			return true;
+	}
+	return false;
+}
+
+void ADSLockOnManager::EvaluateLockArm(FDSLockArmUpdate& Update, TArray<int32>& Indices, TArray<int32>& Groups, FDSCandidateSet& Candidates) const
+{
+	Update.NewTarget = nullptr;
+	Update.bOccludedCandidates = false;
+	Update.bAwaitingTrace = false;
+
+	if (Update.bSkip)
+	{
+		Update.Action = DSLockOnCore::ELockAction::None;
+		return;
+	}
+
+	Candidates.Reset();
+
+	const bool bNeedsCandidate = DSLockOnCore::NeedsLockCandidate(Update.LockState);
+	if (NeedsTargetQuery(Update))
+	{
+		if (Update.QueryCacheEntry != INDEX_NONE)
+			FilterSharedQuery(QueryCache[Update.QueryCacheEntry].Indices, Update.Origin, Update.MaxTargetLockDistance, Update.IgnoreActor, Update.IgnoreTeam, Indices);
+		else
+			QueryTargets(Update.Origin, Update.MaxTargetLockDistance, Update.IgnoreActor, Update.IgnoreTeam, Indices, Groups);
+
+		for (int32 i : Indices)
+			Candidates.Add(Targets[i], TargetX[i], TargetY[i], TargetZ[i], TargetPriority[i], TargetThreat[i]);
+
+		DS_LOCKON_COUNT(Candidates, Candidates.Num());
+
+		Update.CandidateRing->Update(Candidates, Update.Origin, Update.SwitchOrderTolerance);
+
+		// Drop everything off screen before scoring and line of sight. The switching order above still covers every target in range
+		if (Update.bScreenSpace)
+			DSLockOnScoring::ScoreCandidatesOnScreen(Candidates, Update.ViewProjection, Update.ScreenMargin);
+	}
+
+	if (bNeedsCandidate)
+	{
+		// World-space facing and distance feed the curve terms even when the screen score decides what is in play
+		DSLockOnScoring::ScoreCandidates(Candidates, Update.Origin, Update.Forward);
+
+		// Occluded candidates stay in the set so they're traced again, but can't be picked
+		if (Update.LineOfSight)
+			Update.bOccludedCandidates = Update.LineOfSight->ExcludeOccluded(Candidates) > 0;
+
+		int32 BestIdx;
+		if (Update.ScoringTables)
+		{
+			DSLockOnScoring::ScoreWithTables(Candidates, *Update.ScoringTables, Update.MaxTargetLockDistance, *Update.RecentTargets, Update.WorldTime);
+			BestIdx = DSLockOnScoring::SelectLockTargetByScore(Candidates);
+		}
+		else
+		{
+			BestIdx = DSLockOnScoring::SelectLockTarget(Candidates);
+		}
+
+		// A target that only just entered range hasn't been traced, and may be behind a wall
+		if (BestIdx != INDEX_NONE && Update.LineOfSight && !Update.LineOfSight->IsVisible(Candidates.Targets[BestIdx]))
+		{
+			Update.bAwaitingTrace = true;
+			BestIdx = INDEX_NONE;
+		}
+
+		if (BestIdx != INDEX_NONE)
+			Update.NewTarget = Candidates.Targets[BestIdx];
+	}
+
+	// Waiting on a trace holds the current state, so it neither breaks a soft-lock nor clears a soft-lock reset
+	Update.Action = Update.bAwaitingTrace ? DSLockOnCore::ELockAction::None : DSLockOnCore::UpdateLockState(Update.LockState, Update.NewTarget != nullptr);
+}
+
+void ADSLockOnManager::UpdateTargetPositions()
+{
+	if (LastUpdateFrame == GFrameCounter)
+		return;
+
+	LastUpdateFrame = GFrameCounter;
+
+	GroupsChanged.Init(false, GroupOwners.Num());
+
+	for (int32 i = 0; i < Targets.Num(); i++)
+	{
+		const FVector Location = Targets[i]->GetComponentLocation();
+		const float Radius = GetTargetRadius(Targets[i]);
+
+		if (Location.X == TargetX[i] && Location.Y == TargetY[i] && Location.Z == TargetZ[i] && Radius == TargetRadius[i])
+			continue;
+
+		TargetX[i] = Location.X;
+		TargetY[i] = Location.Y;
+		TargetZ[i] = Location.Z;
+		TargetRadius[i] = Radius;
+
+		GroupsChanged[TargetGroup[i]] = true;
+	}
+
+	// Bounds are only rebuilt for groups that changed, which also marks their cells dirty
+	const float PreviousMaxGroupRadius = MaxGroupRadius;
+	MaxGroupRadius = 0.f;
+
+	for (int32 Group = 0; Group < GroupOwners.Num(); Group++)
+	{
+		if (GroupsChanged[Group])
+			UpdateGroupBounds(Group);
+
+		MaxGroupRadius = FMath::Max(MaxGroupRadius, GroupRadius[Group]);
+	}
+
+	// Shell bounds are padded by the largest radius, so a change invalidates every arm's shell
+	if (MaxGroupRadius != PreviousMaxGroupRadius)
+		bAllCellsDirty = true;
+}
@@ -0,0 +1,430 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnRecording.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Engine/World.h"
+#include "DSLockOnManager.h"
+#include "DSLockArmComponent.h"
+#include "DSLineOfSightCache.h"
+
+namespace DSLockOnRecording
+{
+	static uint32 ZigZag(int32 Value)
+	{
+		return (uint32(Value) << 1) ^ uint32(Value >> 31);
+	}
+
+	static int32 UnZigZag(uint32 Value)
+	{
+		return int32(Value >> 1) ^ -int32(Value & 1);
+	}
+
+	static uint32 FloatBits(float Value)
+	{
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	static float BitsFloat(uint32 Bits)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	void FWriter::WriteVarint(uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Bytes.Add(uint8(Value) | 0x80);
+			Value >>= 7;
+		}
+		Bytes.Add(uint8(Value));
+	}
+
+	void FWriter::WriteSigned(int32 Value)
+	{
+		WriteVarint(ZigZag(Value));
+	}
+
+	void FWriter::WriteFloat(float Value)
+	{
+		const uint32 Bits = FloatBits(Value);
+		Bytes.Append(reinterpret_cast<const uint8*>(&Bits), sizeof(Bits));
+	}
+
+	void FWriter::WriteFloatDelta(float Value, float Previous)
+	{
+		// Nearby floats of the same sign have nearby bit patterns, so small moves give small differences
+		WriteSigned(int32(FloatBits(Value) - FloatBits(Previous)));
+	}
+
+	uint8 FReader::ReadByte()
+	{
+		if (Offset >= Size)
+		{
+			bError = true;
+			return 0;
+		}
+		return Data[Offset++];
+	}
+
+	uint32 FReader::ReadVarint()
+	{
+		uint32 Value = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			const uint8 Byte = ReadByte();
+			Value |= uint32(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+				return Value;
+		}
+
+		bError = true;
+		return 0;
+	}
+
+	int32 FReader::ReadSigned()
+	{
+		return UnZigZag(ReadVarint());
+	}
+
+	float FReader::ReadFloat()
+	{
+		if (Offset + 4 > Size)
+		{
+			bError = true;
+			Offset = Size;
+			return 0.f;
+		}
+
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, Data + Offset, sizeof(Bits));
+		Offset += 4;
+		return BitsFloat(Bits);
+	}
+
+	float FReader::ReadFloatDelta(float Previous)
+	{
+		return BitsFloat(FloatBits(Previous) + uint32(ReadSigned()));
+	}
+}
+
+#if DS_LOCKON_RECORDING
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnRecording, Log, All);
+
+using namespace DSLockOnRecording;
+
+int32 FDSLockOnRecorder::NumOpen = 0;
+
+FDSLockOnRecorder::~FDSLockOnRecorder()
+{
+	Close();
+}
+
+bool FDSLockOnRecorder::Open(const FString& InFilename)
+{
+	Close();
+
+	Archive = IFileManager::Get().CreateFileWriter(*InFilename);
+	if (Archive == nullptr)
+		return false;
+
+	Filename = InFilename;
+	NumOpen++;
+
+	TArray<uint8> Header;
+	FWriter Writer(Header);
+	Writer.WriteVarint(Magic);
+	Writer.WriteVarint(Version);
+	Archive->Serialize(Header.GetData(), Header.Num());
+	return true;
+}
+
+void FDSLockOnRecorder::Close()
+{
+	if (Archive == nullptr)
+		return;
+
+	Archive->Close();
+	delete Archive;
+	Archive = nullptr;
+	NumOpen--;
+}
+
+void FDSLockOnRecorder::RecordInput(const UDSLockArmComponent* Arm, EDSLockOnInput Input, float Value)
+{
+	// Axis bindings report every frame, so idle axes are left out
+	if (NumOpen == 0 || Arm == nullptr || Value == 0.f)
+		return;
+
+	ADSLockOnManager* Manager = ADSLockOnManager::Find(Arm->GetWorld());
+	FDSLockOnRecorder* Recorder = Manager ? Manager->GetRecorder() : nullptr;
+	if (Recorder)
+		Recorder->PendingInputs.Add({ Recorder->GetArmId(Arm), Input, Value });
+}
+
+uint32 FDSLockOnRecorder::GetArmId(const UDSLockArmComponent* Arm)
+{
+	if (const FRecordedArm* Recorded = RecordedArms.Find(Arm))
+		return Recorded->Id;
+
+	FRecordedArm& Recorded = RecordedArms.Add(Arm);
+	Recorded.Id = NextArmId++;
+	Recorded.Origin = FVector::ZeroVector;
+	Recorded.Forward = FVector::ZeroVector;
+	return Recorded.Id;
+}
+
+uint32 FDSLockOnRecorder::GetOwnerId(const AActor* Owner)
+{
+	if (const uint32* Id = OwnerIds.Find(Owner))
+		return *Id;
+
+	return OwnerIds.Add(Owner, NextOwnerId++);
+}
+
+void FDSLockOnRecorder::RecordFrame(const ADSLockOnManager& Manager, float DeltaSeconds, double UpdateMs)
+{
+	if (Archive == nullptr)
+		return;
+
+	FrameBytes.Reset();
+	FWriter Writer(FrameBytes);
+
+	Writer.WriteFloat(DeltaSeconds);
+	Writer.WriteFloat(float(UpdateMs));
+
+	// Targets first, so the arms below can refer to this frame's target ids
+	WriteTargets(Writer, Manager);
+	WriteArms(Writer, Manager);
+
+	Writer.WriteVarint(PendingInputs.Num());
+	for (const FRecordedInput& Input : PendingInputs)
+	{
+		Writer.WriteVarint(Input.ArmId);
+		Writer.WriteByte(uint8(Input.Input));
+		Writer.WriteFloat(Input.Value);
+	}
+	PendingInputs.Reset();
+
+	// Frames are length-prefixed, so a recording cut short still replays up to its last whole frame
+	uint8 Prefix[5];
+	int32 PrefixSize = 0;
+	for (uint32 Length = FrameBytes.Num(); ; Length >>= 7)
+	{
+		Prefix[PrefixSize++] = uint8(Length & 0x7F) | (Length >= 0x80 ? 0x80 : 0);
+		if (Length < 0x80)
+			break;
+	}
+
+	Archive->Serialize(Prefix, PrefixSize);
+	Archive->Serialize(FrameBytes.GetData(), FrameBytes.Num());
+
+	FrameNumber++;
+}
+
+void FDSLockOnRecorder::WriteTargets(FWriter& Writer, const ADSLockOnManager& Manager)
+{
+	AddedTargets.Reset();
+	MovedTargets.Reset();
+	RemovedTargets.Reset();
+
+	for (int32 i = 0; i < Manager.Targets.Num(); i++)
+	{
+		FRecordedTarget* Recorded = RecordedTargets.Find(Manager.Targets[i]);
+		if (Recorded == nullptr)
+		{
+			Recorded = &RecordedTargets.Add(Manager.Targets[i]);
+			Recorded->Id = NextTargetId++;
+			AddedTargets.Add(i);
+		}
+		else if (Recorded->X != Manager.TargetX[i] || Recorded->Y != Manager.TargetY[i] || Recorded->Z != Manager.TargetZ[i] || Recorded->Radius != Manager.TargetRadius[i])
+		{
+			MovedTargets.Add(i);
+		}
+		Recorded->Frame = FrameNumber;
+	}
+
+	for (auto It = RecordedTargets.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Frame != FrameNumber)
+		{
+			RemovedTargets.Add(It.Value().Id);
+			It.RemoveCurrent();
+		}
+	}
+
+	Writer.WriteVarint(RemovedTargets.Num());
+	for (uint32 Id : RemovedTargets)
+		Writer.WriteVarint(Id);
+
+	Writer.WriteVarint(AddedTargets.Num());
+	for (int32 i : AddedTargets)
+	{
+		FRecordedTarget& Recorded = RecordedTargets.FindChecked(Manager.Targets[i]);
+		Recorded.X = Manager.TargetX[i];
+		Recorded.Y = Manager.TargetY[i];
+		Recorded.Z = Manager.TargetZ[i];
+		Recorded.Radius = Manager.TargetRadius[i];
+
+		Writer.WriteVarint(Recorded.Id);
+		Writer.WriteVarint(GetOwnerId(Manager.Targets[i]->GetOwner()));
+		Writer.WriteSigned(Manager.TargetTeam[i]);
+		Writer.WriteFloat(Manager.TargetPriority[i]);
+		Writer.WriteFloat(Manager.TargetThreat[i]);
+		Writer.WriteFloat(Recorded.X);
+		Writer.WriteFloat(Recorded.Y);
+		Writer.WriteFloat(Recorded.Z);
+		Writer.WriteFloat(Recorded.Radius);
+	}
+
+	Writer.WriteVarint(MovedTargets.Num());
+	for (int32 i : MovedTargets)
+	{
+		FRecordedTarget& Recorded = RecordedTargets.FindChecked(Manager.Targets[i]);
+		Writer.WriteVarint(Recorded.Id);
+		Writer.WriteFloatDelta(Manager.TargetX[i], Recorded.X);
+		Writer.WriteFloatDelta(Manager.TargetY[i], Recorded.Y);
+		Writer.WriteFloatDelta(Manager.TargetZ[i], Recorded.Z);
+		Writer.WriteFloatDelta(Manager.TargetRadius[i], Recorded.Radius);
+
+		Recorded.X = Manager.TargetX[i];
+		Recorded.Y = Manager.TargetY[i];
+		Recorded.Z = Manager.TargetZ[i];
+		Recorded.Radius = Manager.TargetRadius[i];
+	}
+}
+
+void FDSLockOnRecorder::WriteArms(FWriter& Writer, const ADSLockOnManager& Manager)
+{
+	// Target ids are written plus one, leaving zero for none or a target that was never registered
+	auto GetTargetId = [this](const USceneComponent* Target) -> uint32
+	{
+		const FRecordedTarget* Recorded = Target ? RecordedTargets.Find(Target) : nullptr;
+		return Recorded ? Recorded->Id + 1 : 0;
+	};
+
+	Writer.WriteVarint(Manager.LockArms.Num());
+	for (int32 i = 0; i < Manager.LockArms.Num(); i++)
+	{
+		UDSLockArmComponent* Arm = Manager.LockArms[i];
+		const FDSLockArmUpdate& Update = Manager.LockArmUpdates[i];
+		const DSLockOnCore::FLockState& State = Update.LockState;
+		const bool bHasCandidates = !Update.bSkip && DSLockOnCore::NeedsLockCandidate(State);
+
+		uint32 Flags = 0;
+		if (Update.bSkip)
+		{
+			Flags = ArmSkipped;
+		}
+		else
+		{
+			Flags |= State.bLocked ? ArmLocked : 0;
+			Flags |= State.bUseSoftLock ? ArmSoftLock : 0;
+			Flags |= State.bSoftlockRequiresReset ? ArmSoftlockRequiresReset : 0;
+			Flags |= State.bLostSight ? ArmLostSight : 0;
+			Flags |= State.bOutOfRange ? ArmOutOfRange : 0;
+			Flags |= Update.bScreenSpace ? ArmScreenSpace : 0;
+			Flags |= bHasCandidates ? ArmHasCandidates : 0;
+			Flags |= Update.ScoringTables ? ArmScoringCurves : 0;
+		}
+
+		const uint32 ArmId = GetArmId(Arm);
+		Writer.WriteVarint(ArmId);
+		Writer.WriteVarint(GetOwnerId(Arm->GetOwner()));
+		Writer.WriteVarint(Flags);
+
+		if (Update.bSkip)
+			continue;
+
+		FRecordedArm& Recorded = RecordedArms.FindChecked(Arm);
+		Writer.WriteFloatDelta(Update.Origin.X, Recorded.Origin.X);
+		Writer.WriteFloatDelta(Update.Origin.Y, Recorded.Origin.Y);
+		Writer.WriteFloatDelta(Update.Origin.Z, Recorded.Origin.Z);
+		Writer.WriteFloatDelta(Update.Forward.X, Recorded.Forward.X);
+		Writer.WriteFloatDelta(Update.Forward.Y, Recorded.Forward.Y);
+		Writer.WriteFloatDelta(Update.Forward.Z, Recorded.Forward.Z);
+		Recorded.Origin = Update.Origin;
+		Recorded.Forward = Update.Forward;
+
+		Writer.WriteFloat(Update.MaxTargetLockDistance);
+		Writer.WriteSigned(Update.IgnoreTeam);
+
+		// The range break's inputs, already settled for this frame while gathering
+		if (State.bLocked)
+		{
+			Writer.WriteVarint(GetTargetId(Arm->CameraTarget));
+			Writer.WriteFloat(Arm->GetLockFrame().Distance);
+			Writer.WriteFloat(ADSLockOnManager::GetTargetRadius(Arm->CameraTarget));
+			Writer.WriteFloat(Arm->RangeBreakHysteresis);
+		}
+
+		if (Update.bScreenSpace)
+		{
+			Writer.WriteFloat(Update.ScreenMargin);
+			for (int32 Row = 0; Row < 4; Row++)
+			{
+				for (int32 Column = 0; Column < 4; Column++)
+					Writer.WriteFloat(Update.ViewProjection.M[Row][Column]);
+			}
+		}
+
+		// Candidates that survived the screen pre-pass, with the line of sight results selection saw
+		if (bHasCandidates)
+		{
+			const FDSCandidateSet& Candidates = Manager.LockArmCandidates[i];
+			Writer.WriteVarint(Candidates.Num());
+			for (int32 c = 0; c < Candidates.Num(); c++)
+			{
+				const bool bOccluded = Update.LineOfSight && Update.LineOfSight->IsOccluded(Candidates.Targets[c]);
+				const bool bUntraced = Update.LineOfSight && !bOccluded && !Update.LineOfSight->IsVisible(Candidates.Targets[c]);
+				Writer.WriteVarint((GetTargetId(Candidates.Targets[c]) << 2) | (bUntraced ? 2 : 0) | (bOccluded ? 1 : 0));
+			}
+		}
+
+		Writer.WriteByte(uint8(Update.Action));
+		Writer.WriteVarint(GetTargetId(Update.NewTarget));
+	}
+}
+
+namespace DSLockOnRecording
+{
+	static void Record(const TArray<FString>& Args, UWorld* World)
+	{
+		ADSLockOnManager* Manager = ADSLockOnManager::Get(World);
+		if (Manager == nullptr)
+			return;
+
+		const FString Filename = Args.Num() > 0 ? Args[0]
+			: FPaths::ProjectSavedDir() / TEXT("LockOnRecordings") / FDateTime::Now().ToString() + TEXT(".dslr");
+
+		if (Manager->StartRecording(Filename))
+			UE_LOG(LogDSLockOnRecording, Display, TEXT("Recording lock-on session to %s"), *Filename);
+		else
+			UE_LOG(LogDSLockOnRecording, Error, TEXT("Couldn't create %s"), *Filename);
+	}
+
+	static void StopRecording(const TArray<FString>& Args, UWorld* World)
+	{
+		if (ADSLockOnManager* Manager = ADSLockOnManager::Find(World))
+			Manager->StopRecording();
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs RecordCommand(
+		TEXT("ds.LockOn.Record"),
+		TEXT("Records the lock-on session to a file for the DSLockOnReplay commandlet. Args: [File=Saved/LockOnRecordings/<time>.dslr]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Record));
+
+	static FAutoConsoleCommandWithWorldAndArgs StopRecordingCommand(
+		TEXT("ds.LockOn.StopRecording"),
+		TEXT("Stops recording the lock-on session"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StopRecording));
+}
+
+#endif
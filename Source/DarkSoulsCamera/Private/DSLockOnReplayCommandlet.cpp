@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnReplayCommandlet.h"
+#include "Async/MappedFileHandle.h"
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "DSLockOnCore.h"
+#include "DSLockOnRecording.h"
+#include "DSLockOnScoring.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnReplayCommandlet, Log, All);
+
+namespace DSLockOnReplayCommandlet
+{
+	using namespace DSLockOnRecording;
+
+	/* Divergences logged before the rest are only counted */
+	static const int32 MaxLoggedDivergences = 20;
+
+	/* Replayed target table, laid out like the manager's so the core filters run over it unchanged */
+	struct FTargetTable
+	{
+		TArray<uint32> Ids;
+		TArray<uint32> Owners;
+		TArray<int32> Teams;
+		TArray<float> Priority;
+		TArray<float> Threat;
+		TArray<float> X;
+		TArray<float> Y;
+		TArray<float> Z;
+		TArray<float> Radius;
+		TMap<uint32, int32> Indices;
+
+		void Add(uint32 Id, uint32 Owner, int32 Team, float InPriority, float InThreat, float InX, float InY, float InZ, float InRadius)
+		{
+			Indices.Add(Id, Ids.Num());
+			Ids.Add(Id);
+			Owners.Add(Owner);
+			Teams.Add(Team);
+			Priority.Add(InPriority);
+			Threat.Add(InThreat);
+			X.Add(InX);
+			Y.Add(InY);
+			Z.Add(InZ);
+			Radius.Add(InRadius);
+		}
+
+		void Remove(uint32 Id)
+		{
+			int32 Index;
+			if (!Indices.RemoveAndCopyValue(Id, Index))
+				return;
+
+			const int32 Last = Ids.Num() - 1;
+			if (Index != Last)
+				Indices[Ids[Last]] = Index;
+
+			Ids.RemoveAtSwap(Index, 1, false);
+			Owners.RemoveAtSwap(Index, 1, false);
+			Teams.RemoveAtSwap(Index, 1, false);
+			Priority.RemoveAtSwap(Index, 1, false);
+			Threat.RemoveAtSwap(Index, 1, false);
+			X.RemoveAtSwap(Index, 1, false);
+			Y.RemoveAtSwap(Index, 1, false);
+			Z.RemoveAtSwap(Index, 1, false);
+			Radius.RemoveAtSwap(Index, 1, false);
+		}
+
+		void Reset()
+		{
+			Ids.Reset();
+			Owners.Reset();
+			Teams.Reset();
+			Priority.Reset();
+			Threat.Reset();
+			X.Reset();
+			Y.Reset();
+			Z.Reset();
+			Radius.Reset();
+			Indices.Reset();
+		}
+	};
+
+	/* Candidate sets carry component pointers, so replayed candidates stand in with their target id plus one */
+	static USceneComponent* ToCandidate(uint32 Id)
+	{
+		return reinterpret_cast<USceneComponent*>(UPTRINT(Id) + 1);
+	}
+
+	static uint32 FromCandidate(const USceneComponent* Candidate)
+	{
+		return uint32(reinterpret_cast<UPTRINT>(Candidate) - 1);
+	}
+
+	struct FReplayStats
+	{
+		int32 NumFrames = 0;
+		int32 NumArmUpdates = 0;
+		int32 NumInputs[int32(EDSLockOnInput::Num)] = {};
+		int32 NumDivergences = 0;
+		int32 NumUncheckedSelections = 0;
+		TArray<double> FrameMs;
+		TArray<double> RecordedMs;
+	};
+
+	/* Replays one recording. Returns false if it's malformed. Divergences are only counted when bCheck is set */
+	static bool Replay(const uint8* Data, int64 Size, bool bCheck, FReplayStats& Stats)
+	{
+		FReader Header(Data, Size);
+		if (Header.ReadVarint() != Magic || Header.ReadVarint() != Version || Header.bError)
+		{
+			UE_LOG(LogDSLockOnReplayCommandlet, Error, TEXT("Not a version %u lock-on recording"), Version);
+			return false;
+		}
+
+		FTargetTable Table;
+		TMap<uint32, TPair<FVector, FVector>> ArmPoses;
+		FDSCandidateSet Candidates;
+		TArray<int32> Indices;
+		TArray<uint32> RecordedIds, ReplayedIds;
+
+		auto Diverged = [&](int32 Frame, uint32 ArmId, const TCHAR* What)
+		{
+			if (bCheck && Stats.NumDivergences++ < MaxLoggedDivergences)
+				UE_LOG(LogDSLockOnReplayCommandlet, Warning, TEXT("Frame %d, arm %u: %s differs from the recording"), Frame, ArmId, What);
+		};
+
+		int64 Offset = Header.Offset;
+		for (int32 Frame = 0; Offset < Size; Frame++)
+		{
+			FReader Prefix(Data + Offset, Size - Offset);
+			const uint32 Length = Prefix.ReadVarint();
+			if (Prefix.bError || Prefix.Offset + Length > Prefix.Size)
+			{
+				// The recording was cut short mid-frame. Everything before it still counts
+				UE_LOG(LogDSLockOnReplayCommandlet, Warning, TEXT("Recording ends in a partial frame %d"), Frame);
+				break;
+			}
+
+			FReader Reader(Data + Offset + Prefix.Offset, Length);
+			Offset += Prefix.Offset + Length;
+
+			Reader.ReadFloat();		// Delta seconds, kept for tools reading the stream
+			const float RecordedMs = Reader.ReadFloat();
+
+			for (uint32 n = Reader.ReadVarint(); n > 0 && !Reader.bError; n--)
+				Table.Remove(Reader.ReadVarint());
+
+			for (uint32 n = Reader.ReadVarint(); n > 0 && !Reader.bError; n--)
+			{
+				const uint32 Id = Reader.ReadVarint();
+				const uint32 Owner = Reader.ReadVarint();
+				const int32 Team = Reader.ReadSigned();
+				const float Priority = Reader.ReadFloat();
+				const float Threat = Reader.ReadFloat();
+				const float X = Reader.ReadFloat();
+				const float Y = Reader.ReadFloat();
+				const float Z = Reader.ReadFloat();
+				const float Radius = Reader.ReadFloat();
+				Table.Add(Id, Owner, Team, Priority, Threat, X, Y, Z, Radius);
+			}
+
+			for (uint32 n = Reader.ReadVarint(); n > 0 && !Reader.bError; n--)
+			{
+				const int32* Index = Table.Indices.Find(Reader.ReadVarint());
+				if (Index == nullptr)
+				{
+					Reader.bError = true;
+					break;
+				}
+				Table.X[*Index] = Reader.ReadFloatDelta(Table.X[*Index]);
+				Table.Y[*Index] = Reader.ReadFloatDelta(Table.Y[*Index]);
+				Table.Z[*Index] = Reader.ReadFloatDelta(Table.Z[*Index]);
+				Table.Radius[*Index] = Reader.ReadFloatDelta(Table.Radius[*Index]);
+			}
+
+			double FrameMs = 0.0;
+
+			for (uint32 n = Reader.ReadVarint(); n > 0 && !Reader.bError; n--)
+			{
+				const uint32 ArmId = Reader.ReadVarint();
+				const uint32 ArmOwner = Reader.ReadVarint();
+				const uint32 Flags = Reader.ReadVarint();
+				if (Flags & ArmSkipped)
+					continue;
+
+				TPair<FVector, FVector>& Pose = ArmPoses.FindOrAdd(ArmId);
+				FVector& Origin = Pose.Key;
+				FVector& Forward = Pose.Value;
+				Origin.X = Reader.ReadFloatDelta(Origin.X);
+				Origin.Y = Reader.ReadFloatDelta(Origin.Y);
+				Origin.Z = Reader.ReadFloatDelta(Origin.Z);
+				Forward.X = Reader.ReadFloatDelta(Forward.X);
+				Forward.Y = Reader.ReadFloatDelta(Forward.Y);
+				Forward.Z = Reader.ReadFloatDelta(Forward.Z);
+
+				const float MaxLockDistance = Reader.ReadFloat();
+				const int32 IgnoreTeam = Reader.ReadSigned();
+
+				DSLockOnCore::FLockState State;
+				State.bLocked = (Flags & ArmLocked) != 0;
+				State.bUseSoftLock = (Flags & ArmSoftLock) != 0;
+				State.bSoftlockRequiresReset = (Flags & ArmSoftlockRequiresReset) != 0;
+				State.bLostSight = (Flags & ArmLostSight) != 0;
+				State.bOutOfRange = false;
+
+				float Distance = 0.f, TargetRadius = 0.f, Hysteresis = 0.f;
+				if (State.bLocked)
+				{
+					Reader.ReadVarint();	// Locked target
+					Distance = Reader.ReadFloat();
+					TargetRadius = Reader.ReadFloat();
+					Hysteresis = Reader.ReadFloat();
+				}
+
+				const bool bScreenSpace = (Flags & ArmScreenSpace) != 0;
+				FMatrix ViewProjection = FMatrix::Identity;
+				float ScreenMargin = 0.f;
+				if (bScreenSpace)
+				{
+					ScreenMargin = Reader.ReadFloat();
+					for (int32 Row = 0; Row < 4; Row++)
+					{
+						for (int32 Column = 0; Column < 4; Column++)
+							ViewProjection.M[Row][Column] = Reader.ReadFloat();
+					}
+				}
+
+				const bool bHasCandidates = (Flags & ArmHasCandidates) != 0;
+				RecordedIds.Reset();
+				TBitArray<> Occluded;
+				TBitArray<> Untraced;
+				if (bHasCandidates)
+				{
+					for (uint32 c = Reader.ReadVarint(); c > 0 && !Reader.bError; c--)
+					{
+						const uint32 Entry = Reader.ReadVarint();
+						RecordedIds.Add((Entry >> 2) - 1);
+						Occluded.Add((Entry & 1) != 0);
+						Untraced.Add((Entry & 2) != 0);
+					}
+				}
+
+				const DSLockOnCore::ELockAction RecordedAction = DSLockOnCore::ELockAction(Reader.ReadByte());
+				const uint32 RecordedTarget = Reader.ReadVarint();
+
+				if (Reader.bError)
+					break;
+
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+
+				State.bOutOfRange = State.bLocked && DSLockOnCore::IsOutOfRange(Distance, TargetRadius, MaxLockDistance, Hysteresis);
+
+				// Candidate query over the replayed table, checked against the set the recording selected from
+				if (bHasCandidates && bCheck)
+				{
+					Indices.Reset();
+					for (int32 i = 0; i < Table.Ids.Num(); i++)
+					{
+						if (Table.Owners[i] != ArmOwner && (IgnoreTeam == 0 || Table.Teams[i] != IgnoreTeam))
+							Indices.Add(i);
+					}
+					Indices.SetNum(DSLockOnCore::FilterInRange(Table.X.GetData(), Table.Y.GetData(), Table.Z.GetData(), Table.Radius.GetData(),
+						Indices.GetData(), Indices.Num(), { Origin.X, Origin.Y, Origin.Z }, MaxLockDistance, Indices.GetData()), false);
+
+					Candidates.Reset();
+					for (int32 i : Indices)
+						Candidates.Add(ToCandidate(Table.Ids[i]), Table.X[i], Table.Y[i], Table.Z[i], Table.Priority[i], Table.Threat[i]);
+
+					if (bScreenSpace)
+						DSLockOnScoring::ScoreCandidatesOnScreen(Candidates, ViewProjection, ScreenMargin);
+
+					ReplayedIds.Reset();
+					for (USceneComponent* Candidate : Candidates.Targets)
+						ReplayedIds.Add(FromCandidate(Candidate));
+
+					TArray<uint32> SortedRecordedIds = RecordedIds;
+					SortedRecordedIds.Sort();
+					ReplayedIds.Sort();
+					if (ReplayedIds != SortedRecordedIds)
+						Diverged(Frame, ArmId, TEXT("Candidate set"));
+				}
+
+				// Selection runs over the recorded set in its recorded order, so ties break the same way
+				bool bHasTarget = false;
+				bool bAwaitingTrace = false;
+				uint32 ReplayedTarget = 0;
+				if (bHasCandidates)
+				{
+					Candidates.Reset();
+					for (uint32 Id : RecordedIds)
+					{
+						const int32* Index = Table.Indices.Find(Id);
+						if (Index)
+							Candidates.Add(ToCandidate(Id), Table.X[*Index], Table.Y[*Index], Table.Z[*Index], Table.Priority[*Index], Table.Threat[*Index]);
+					}
+
+					if (bScreenSpace)
+						DSLockOnScoring::ScoreCandidatesOnScreen(Candidates, ViewProjection, ScreenMargin);
+					DSLockOnScoring::ScoreCandidates(Candidates, Origin, Forward);
+
+					for (int32 c = 0; c < Candidates.Num(); c++)
+					{
+						const int32 RecordedIndex = RecordedIds.Find(FromCandidate(Candidates.Targets[c]));
+						if (Occluded[RecordedIndex])
+							Candidates.Exclude(c);
+					}
+
+					int32 BestIdx = DSLockOnScoring::SelectLockTarget(Candidates);
+
+					// As the manager does, a pick without a trace result waits for the next logic update
+					if (BestIdx != INDEX_NONE && Untraced[RecordedIds.Find(FromCandidate(Candidates.Targets[BestIdx]))])
+					{
+						bAwaitingTrace = true;
+						BestIdx = INDEX_NONE;
+					}
+
+					bHasTarget = BestIdx != INDEX_NONE;
+					ReplayedTarget = bHasTarget ? FromCandidate(Candidates.Targets[BestIdx]) + 1 : 0;
+				}
+
+				const DSLockOnCore::ELockAction Action = bAwaitingTrace ? DSLockOnCore::ELockAction::None : DSLockOnCore::UpdateLockState(State, bHasTarget);
+
+				FrameMs += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+				Stats.NumArmUpdates += bCheck ? 1 : 0;
+
+				if (State.bOutOfRange != ((Flags & ArmOutOfRange) != 0))
+					Diverged(Frame, ArmId, TEXT("Range break"));
+
+				// Scoring curves are assets, not part of the recording, so their picks can't be checked
+				if (Flags & ArmScoringCurves)
+				{
+					Stats.NumUncheckedSelections += bCheck && bHasCandidates ? 1 : 0;
+					continue;
+				}
+
+				if (ReplayedTarget != RecordedTarget)
+					Diverged(Frame, ArmId, TEXT("Selected target"));
+				if (Action != RecordedAction)
+					Diverged(Frame, ArmId, TEXT("Lock action"));
+			}
+
+			for (uint32 n = Reader.ReadVarint(); n > 0 && !Reader.bError; n--)
+			{
+				Reader.ReadVarint();	// Arm
+				const uint8 Input = Reader.ReadByte();
+				Reader.ReadFloat();
+
+				if (bCheck && Input < uint8(EDSLockOnInput::Num))
+					Stats.NumInputs[Input]++;
+			}
+
+			if (Reader.bError)
+			{
+				UE_LOG(LogDSLockOnReplayCommandlet, Error, TEXT("Frame %d is malformed"), Frame);
+				return false;
+			}
+
+			Stats.FrameMs.Add(FrameMs);
+			if (bCheck)
+			{
+				Stats.RecordedMs.Add(RecordedMs);
+				Stats.NumFrames++;
+			}
+		}
+
+		return true;
+	}
+
+	/* Nearest-rank percentile of sorted samples */
+	static double Percentile(const TArray<double>& SortedSamples, double Percent)
+	{
+		if (SortedSamples.Num() == 0)
+			return 0.0;
+
+		const int32 Rank = FMath::CeilToInt(Percent / 100.0 * SortedSamples.Num());
+		return SortedSamples[FMath::Clamp(Rank - 1, 0, SortedSamples.Num() - 1)];
+	}
+
+	static TSharedRef<FJsonObject> MakeTimings(TArray<double>& Samples)
+	{
+		Samples.Sort();
+
+		double Total = 0.0;
+		for (double Sample : Samples)
+			Total += Sample;
+
+		TSharedRef<FJsonObject> Timings = MakeShared<FJsonObject>();
+		Timings->SetNumberField(TEXT("meanMs"), Samples.Num() > 0 ? Total / Samples.Num() : 0.0);
+		Timings->SetNumberField(TEXT("p50Ms"), Percentile(Samples, 50.0));
+		Timings->SetNumberField(TEXT("p95Ms"), Percentile(Samples, 95.0));
+		Timings->SetNumberField(TEXT("maxMs"), Samples.Num() > 0 ? Samples.Last() : 0.0);
+		return Timings;
+	}
+}
+
+UDSLockOnReplayCommandlet::UDSLockOnReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UDSLockOnReplayCommandlet::Main(const FString& Params)
+{
+	using namespace DSLockOnReplayCommandlet;
+
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogDSLockOnReplayCommandlet, Error, TEXT("Usage: -run=DSLockOnReplay -File=<recording> [-Iterations=1] [-Output=]"));
+		return 1;
+	}
+
+	int32 NumIterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("DSLockOnReplay.json");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	// Map the recording where the platform supports it, so long sessions aren't copied into memory first
+	TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion() : nullptr);
+
+	TArray<uint8> LoadedFile;
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Filename))
+	{
+		Data = LoadedFile.GetData();
+		Size = LoadedFile.Num();
+	}
+	else
+	{
+		UE_LOG(LogDSLockOnReplayCommandlet, Error, TEXT("Failed to read '%s'"), *Filename);
+		return 1;
+	}
+
+	// Results are identical every iteration, so only the first is checked. The rest only add timing samples
+	FReplayStats Stats;
+	for (int32 Iteration = 0; Iteration < FMath::Max(NumIterations, 1); Iteration++)
+	{
+		if (!Replay(Data, Size, Iteration == 0, Stats))
+			return 1;
+	}
+
+	static const TCHAR* InputNames[int32(EDSLockOnInput::Num)] = { TEXT("turn"), TEXT("lookUp"), TEXT("turnAtRate"), TEXT("lookUpAtRate"), TEXT("toggleCameraLock"), TEXT("toggleSoftLock") };
+
+	TSharedRef<FJsonObject> Inputs = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < int32(EDSLockOnInput::Num); i++)
+		Inputs->SetNumberField(InputNames[i], Stats.NumInputs[i]);
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("file"), Filename);
+	Report->SetNumberField(TEXT("bytes"), Size);
+	Report->SetNumberField(TEXT("frames"), Stats.NumFrames);
+	Report->SetNumberField(TEXT("armUpdates"), Stats.NumArmUpdates);
+	Report->SetNumberField(TEXT("iterations"), FMath::Max(NumIterations, 1));
+	Report->SetNumberField(TEXT("divergences"), Stats.NumDivergences);
+	Report->SetNumberField(TEXT("uncheckedSelections"), Stats.NumUncheckedSelections);
+	Report->SetObjectField(TEXT("inputs"), Inputs);
+	Report->SetObjectField(TEXT("replay"), MakeTimings(Stats.FrameMs));
+	Report->SetObjectField(TEXT("recorded"), MakeTimings(Stats.RecordedMs));
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogDSLockOnReplayCommandlet, Error, TEXT("Failed to write '%s'"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogDSLockOnReplayCommandlet, Display, TEXT("Replayed %d frames, %d arm updates: %d divergences. Wrote %s"),
+		Stats.NumFrames, Stats.NumArmUpdates, Stats.NumDivergences, *OutputPath);
+
+	return Stats.NumDivergences > 0 ? 2 : 0;
+}
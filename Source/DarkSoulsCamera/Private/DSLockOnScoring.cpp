@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnScoring.h"
+#include "DSLockOnCore.h"
+#include "Curves/CurveFloat.h"
+
+void FDSCandidateSet::Reset()
+{
+	Targets.Reset();
+	X.Reset();
+	Y.Reset();
+	Z.Reset();
+	Priority.Reset();
+	Threat.Reset();
+	Dot.Reset();
+	Side.Reset();
+	Distance.Reset();
+	SinceTargeted.Reset();
+	Score.Reset();
+	ScreenScore.Reset();
+}
+
+void FDSCandidateSet::Add(USceneComponent* Target, float InX, float InY, float InZ, float InPriority, float InThreat)
+{
+	Targets.Add(Target);
+	X.Add(InX);
+	Y.Add(InY);
+	Z.Add(InZ);
+	Priority.Add(InPriority);
+	Threat.Add(InThreat);
+}
+
+void FDSCandidateSet::RemoveAtSwap(int32 Index)
+{
+	// Score arrays only need fixing up if the set was already scored
+	if (Dot.Num() == Targets.Num())
+	{
+		Dot.RemoveAtSwap(Index, 1, false);
+		Side.RemoveAtSwap(Index, 1, false);
+		Distance.RemoveAtSwap(Index, 1, false);
+	}
+
+	if (ScreenScore.Num() == Targets.Num())
+		ScreenScore.RemoveAtSwap(Index, 1, false);
+
+	Targets.RemoveAtSwap(Index, 1, false);
+	X.RemoveAtSwap(Index, 1, false);
+	Y.RemoveAtSwap(Index, 1, false);
+	Z.RemoveAtSwap(Index, 1, false);
+	Priority.RemoveAtSwap(Index, 1, false);
+	Threat.RemoveAtSwap(Index, 1, false);
+}
+
+void FDSCandidateSet::Exclude(int32 Index)
+{
+	// Selection only takes candidates with a positive dot or screen score
+	Dot[Index] = -1.f;
+	if (ScreenScore.Num() == Targets.Num())
+		ScreenScore[Index] = -1.f;
+}
+
+void FDSRecentTargets::Add(const USceneComponent* Target, float Time)
+{
+	const int32 Existing = Targets.Find(Target);
+	if (Existing != INDEX_NONE)
+	{
+		Targets.RemoveAt(Existing, 1, false);
+		Times.RemoveAt(Existing, 1, false);
+	}
+	else if (Targets.Num() == Capacity)
+	{
+		Targets.RemoveAt(0, 1, false);
+		Times.RemoveAt(0, 1, false);
+	}
+
+	Targets.Add(Target);
+	Times.Add(Time);
+}
+
+float FDSRecentTargets::GetSecondsSince(const USceneComponent* Target, float Now) const
+{
+	const int32 Index = Targets.Find(Target);
+	return Index != INDEX_NONE ? Now - Times[Index] : MAX_flt;
+}
+
+namespace DSLockOnScoring
+{
+	void ScoreCandidates(FDSCandidateSet& Candidates, const FVector& Origin, const FVector& Reference)
+	{
+		const int32 Num = Candidates.Num();
+		Candidates.Dot.SetNumUninitialized(Num, false);
+		Candidates.Side.SetNumUninitialized(Num, false);
+		Candidates.Distance.SetNumUninitialized(Num, false);
+
+		ScoreCandidates(Candidates.X.GetData(), Candidates.Y.GetData(), Candidates.Z.GetData(), Num, Origin, Reference,
+			Candidates.Dot.GetData(), Candidates.Side.GetData(), Candidates.Distance.GetData());
+	}
+
+	void ScoreCandidates(const float* X, const float* Y, const float* Z, int32 Num, const FVector& Origin, const FVector& Reference, float* OutDot, float* OutSide, float* OutDistance)
+	{
+		int32 i = 0;
+
+#if DS_LOCKON_SSE
+		// The core's SSE kernel, which the standalone tests check against the scalar one
+		i = DSLockOnCore::ScoreCandidates4(X, Y, Z, Num, { Origin.X, Origin.Y, Origin.Z }, { Reference.X, Reference.Y, Reference.Z }, OutDot, OutSide, OutDistance);
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		const VectorRegister OriginX = VectorSetFloat1(Origin.X);
+		const VectorRegister OriginY = VectorSetFloat1(Origin.Y);
+		const VectorRegister OriginZ = VectorSetFloat1(Origin.Z);
+		const VectorRegister RefX = VectorSetFloat1(Reference.X);
+		const VectorRegister RefY = VectorSetFloat1(Reference.Y);
+		const VectorRegister RefZ = VectorSetFloat1(Reference.Z);
+		const VectorRegister SmallNumber = VectorSetFloat1(SMALL_NUMBER);
+		const VectorRegister Smallest = VectorSetFloat1(FLT_MIN);
+
+		for (; i + 4 <= Num; i += 4)
+		{
+			const VectorRegister DX = VectorSubtract(VectorLoad(X + i), OriginX);
+			const VectorRegister DY = VectorSubtract(VectorLoad(Y + i), OriginY);
+			const VectorRegister DZ = VectorSubtract(VectorLoad(Z + i), OriginZ);
+
+			const VectorRegister LengthSq = VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+
+			// Clamped so a candidate on the origin gets a distance of zero rather than zero times infinity
+			const VectorRegister InvLength = VectorReciprocalSqrtAccurate(VectorMax(LengthSq, Smallest));
+
+			// Degenerate directions normalize to zero and unit directions are left untouched, as GetSafeNormal does
+			const VectorRegister Scale = VectorSelect(VectorCompareEQ(LengthSq, VectorOne()), VectorOne(),
+				VectorSelect(VectorCompareGE(LengthSq, SmallNumber), InvLength, VectorZero()));
+
+			const VectorRegister NX = VectorMultiply(DX, Scale);
+			const VectorRegister NY = VectorMultiply(DY, Scale);
+			const VectorRegister NZ = VectorMultiply(DZ, Scale);
+
+			const VectorRegister Dot = VectorMultiplyAdd(RefZ, NZ, VectorMultiplyAdd(RefY, NY, VectorMultiply(RefX, NX)));
+			const VectorRegister Side = VectorSubtract(VectorMultiply(RefX, NY), VectorMultiply(RefY, NX));
+			const VectorRegister Distance = VectorMultiply(LengthSq, InvLength);
+
+			VectorStore(Dot, OutDot + i);
+			VectorStore(Side, OutSide + i);
+			VectorStore(Distance, OutDistance + i);
+		}
+#endif
+
+		// Remaining candidates, or all of them without vector intrinsics
+		ScoreCandidatesScalar(X + i, Y + i, Z + i, Num - i, Origin, Reference, OutDot + i, OutSide + i, OutDistance + i);
+	}
+
+	void ScoreCandidatesScalar(const float* X, const float* Y, const float* Z, int32 Num, const FVector& Origin, const FVector& Reference, float* OutDot, float* OutSide, float* OutDistance)
+	{
+		DSLockOnCore::ScoreCandidates(X, Y, Z, Num, { Origin.X, Origin.Y, Origin.Z }, { Reference.X, Reference.Y, Reference.Z }, OutDot, OutSide, OutDistance);
+	}
+
+	void ScoreCandidatesOnScreen(FDSCandidateSet& Candidates, const FMatrix& ViewProjection, float ScreenMargin)
+	{
+		const int32 Num = Candidates.Num();
+		Candidates.Dot.SetNumUninitialized(Num, false);
+		Candidates.Side.SetNumUninitialized(Num, false);
+		Candidates.Distance.SetNumUninitialized(Num, false);
+		Candidates.ScreenScore.SetNumUninitialized(Num, false);
+
+		// The screen position and clip W go through Side, Dot and Distance, which keep their slots in step with removals
+		ProjectCandidates(Candidates.X.GetData(), Candidates.Y.GetData(), Candidates.Z.GetData(), Num, ViewProjection,
+			Candidates.Side.GetData(), Candidates.Dot.GetData(), Candidates.Distance.GetData());
+
+		// Back to front, so the candidate swapped into a removed slot has already been scored
+		for (int32 i = Num - 1; i >= 0; i--)
+		{
+			const float Score = DSLockOnCore::ScoreScreenPosition(Candidates.Side[i], Candidates.Dot[i], Candidates.Distance[i], ScreenMargin);
+			if (Score < 0.f)
+				Candidates.RemoveAtSwap(i);
+			else
+				Candidates.ScreenScore[i] = Score;
+		}
+	}
+
+	void ProjectCandidates(const float* X, const float* Y, const float* Z, int32 Num, const FMatrix& ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW)
+	{
+		int32 i = 0;
+
+#if DS_LOCKON_SSE
+		i = DSLockOnCore::ProjectCandidates4(X, Y, Z, Num, &ViewProjection.M[0][0], OutNDCX, OutNDCY, OutW);
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		const FMatrix& M = ViewProjection;
+		const VectorRegister M00 = VectorSetFloat1(M.M[0][0]), M10 = VectorSetFloat1(M.M[1][0]), M20 = VectorSetFloat1(M.M[2][0]), M30 = VectorSetFloat1(M.M[3][0]);
+		const VectorRegister M01 = VectorSetFloat1(M.M[0][1]), M11 = VectorSetFloat1(M.M[1][1]), M21 = VectorSetFloat1(M.M[2][1]), M31 = VectorSetFloat1(M.M[3][1]);
+		const VectorRegister M03 = VectorSetFloat1(M.M[0][3]), M13 = VectorSetFloat1(M.M[1][3]), M23 = VectorSetFloat1(M.M[2][3]), M33 = VectorSetFloat1(M.M[3][3]);
+
+		for (; i + 4 <= Num; i += 4)
+		{
+			const VectorRegister PX = VectorLoad(X + i);
+			const VectorRegister PY = VectorLoad(Y + i);
+			const VectorRegister PZ = VectorLoad(Z + i);
+
+			const VectorRegister ClipX = VectorMultiplyAdd(PZ, M20, VectorMultiplyAdd(PY, M10, VectorMultiplyAdd(PX, M00, M30)));
+			const VectorRegister ClipY = VectorMultiplyAdd(PZ, M21, VectorMultiplyAdd(PY, M11, VectorMultiplyAdd(PX, M01, M31)));
+			const VectorRegister ClipW = VectorMultiplyAdd(PZ, M23, VectorMultiplyAdd(PY, M13, VectorMultiplyAdd(PX, M03, M33)));
+
+			// Points behind the camera project to the origin, as in the scalar kernel. W marks them for culling
+			const VectorRegister InFront = VectorCompareGT(ClipW, VectorZero());
+			const VectorRegister InvW = VectorSelect(InFront, VectorReciprocalAccurate(ClipW), VectorZero());
+
+			VectorStore(VectorMultiply(ClipX, InvW), OutNDCX + i);
+			VectorStore(VectorMultiply(ClipY, InvW), OutNDCY + i);
+			VectorStore(ClipW, OutW + i);
+		}
+#endif
+
+		// Remaining candidates, or all of them without vector intrinsics
+		DSLockOnCore::ProjectCandidates(X + i, Y + i, Z + i, Num - i, &ViewProjection.M[0][0], OutNDCX + i, OutNDCY + i, OutW + i);
+	}
+
+	int32 SelectLockTarget(const FDSCandidateSet& Candidates)
+	{
+		const int32 BestIdx = DSLockOnCore::SelectLockTarget(Candidates.GetSelectionDot().GetData(), Candidates.Priority.GetData(), Candidates.Num());
+		return BestIdx >= 0 ? BestIdx : INDEX_NONE;
+	}
+
+	void ScoreWithTables(FDSCandidateSet& Candidates, const DSLockOnCore::FScoringTables& Tables, float MaxDistance, const FDSRecentTargets& RecentTargets, float Now)
+	{
+		const int32 Num = Candidates.Num();
+		Candidates.SinceTargeted.SetNumUninitialized(Num, false);
+		Candidates.Score.SetNumUninitialized(Num, false);
+
+		if (Tables.RecencyWeight != 0.f)
+		{
+			for (int32 i = 0; i < Num; i++)
+				Candidates.SinceTargeted[i] = RecentTargets.GetSecondsSince(Candidates.Targets[i], Now);
+		}
+
+		DSLockOnCore::ScoreWithTables(Tables, Candidates.Dot.GetData(), Candidates.Distance.GetData(), Candidates.Threat.GetData(), Candidates.SinceTargeted.GetData(),
+			Candidates.Priority.GetData(), Num, MaxDistance, Candidates.Score.GetData());
+	}
+
+	int32 SelectLockTargetByScore(const FDSCandidateSet& Candidates)
+	{
+		// The curve terms used the world-space Dot. The screen score only decides what is in play
+		const int32 BestIdx = DSLockOnCore::SelectByScore(Candidates.GetSelectionDot().GetData(), Candidates.Score.GetData(), Candidates.Num());
+		return BestIdx >= 0 ? BestIdx : INDEX_NONE;
+	}
+
+	void BakeScoreTable(DSLockOnCore::FScoreTable& Table, const UCurveFloat* Curve, float Min, float Max, bool bAngle)
+	{
+		if (Curve == nullptr)
+		{
+			DSLockOnCore::BakeScoreTable(Table, Min, Max, [](float) { return 1.f; });
+			return;
+		}
+
+		// The angle table is indexed by sin(Angle / 2), so each sample evaluates the curve at the angle it stands for
+		if (bAngle)
+			DSLockOnCore::BakeScoreTable(Table, 0.f, 1.f, [Curve](float HalfChord) { return Curve->GetFloatValue(FMath::RadiansToDegrees(2.f * FMath::Asin(HalfChord))); });
+		else
+			DSLockOnCore::BakeScoreTable(Table, Min, Max, [Curve](float Value) { return Curve->GetFloatValue(Value); });
+	}
+
+	int32 SelectSwitchTarget(const FDSCandidateSet& Candidates, const USceneComponent* CurrentTarget, bool bRight)
+	{
+		const int32 CurrentIdx = Candidates.Targets.Find(const_cast<USceneComponent*>(CurrentTarget));
+		const int32 BestIdx = DSLockOnCore::SelectSwitchTarget(Candidates.Dot.GetData(), Candidates.Side.GetData(), Candidates.Num(), CurrentIdx, bRight);
+		return BestIdx >= 0 ? BestIdx : INDEX_NONE;
+	}
+}
@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnStats.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+DEFINE_STAT(STAT_DSLockOn_GetTargetComponents);
+DEFINE_STAT(STAT_DSLockOn_GetLockTarget);
+DEFINE_STAT(STAT_DSLockOn_SwitchTarget);
+DEFINE_STAT(STAT_DSLockOn_TickComponent);
+DEFINE_STAT(STAT_DSLockOn_CharacterTick);
+DEFINE_STAT(STAT_DSLockOn_ManagerTick);
+DEFINE_STAT(STAT_DSLockOn_ArmProbe);
+DEFINE_STAT(STAT_DSLockOn_Registration);
+
+DEFINE_STAT(STAT_DSLockOn_Candidates);
+DEFINE_STAT(STAT_DSLockOn_Acquisitions);
+DEFINE_STAT(STAT_DSLockOn_Breaks);
+DEFINE_STAT(STAT_DSLockOn_Switches);
+DEFINE_STAT(STAT_DSLockOn_ArmProbeSweeps);
+DEFINE_STAT(STAT_DSLockOn_ArmProbeReuses);
+DEFINE_STAT(STAT_DSLockOn_TargetsRegistered);
+DEFINE_STAT(STAT_DSLockOn_TargetsQueued);
+DEFINE_STAT(STAT_DSLockOn_SoftLockSkips);
+DEFINE_STAT(STAT_DSLockOn_SoftLockEvaluations);
+DEFINE_STAT(STAT_DSLockOn_QueryCacheHits);
+DEFINE_STAT(STAT_DSLockOn_QueryCacheMisses);
+DEFINE_STAT(STAT_DSLockOn_NetRequests);
+DEFINE_STAT(STAT_DSLockOn_NetStateUpdates);
+DEFINE_STAT(STAT_DSLockOn_NetCorrections);
+DEFINE_STAT(STAT_DSLockOn_NetStateBits);
+
+#if DS_LOCKON_STATS
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnStats, Log, All);
+
+uint64 FDSLockOnCounters::ScopeCycles[FDSLockOnCounters::NumScopes];
+int32 FDSLockOnCounters::ScopeCalls[FDSLockOnCounters::NumScopes];
+uint64 FDSLockOnCounters::OuterCycles = 0;
+int32 FDSLockOnCounters::ScopeDepth = 0;
+int32 FDSLockOnCounters::Candidates = 0;
+int32 FDSLockOnCounters::Acquisitions = 0;
+int32 FDSLockOnCounters::Breaks = 0;
+int32 FDSLockOnCounters::Switches = 0;
+int32 FDSLockOnCounters::ArmProbeSweeps = 0;
+int32 FDSLockOnCounters::ArmProbeReuses = 0;
+int32 FDSLockOnCounters::TargetsRegistered = 0;
+uint64 FDSLockOnCounters::MaxRegistrationCycles = 0;
+int32 FDSLockOnCounters::SoftLockSkips = 0;
+int32 FDSLockOnCounters::SoftLockEvaluations = 0;
+int32 FDSLockOnCounters::QueryCacheHits = 0;
+int32 FDSLockOnCounters::QueryCacheMisses = 0;
+int32 FDSLockOnCounters::NetRequests = 0;
+int32 FDSLockOnCounters::NetStateUpdates = 0;
+int32 FDSLockOnCounters::NetCorrections = 0;
+int32 FDSLockOnCounters::NetStateBits = 0;
+
+void FDSLockOnCounters::Reset()
+{
+	FMemory::Memzero(ScopeCycles);
+	FMemory::Memzero(ScopeCalls);
+	OuterCycles = 0;
+	Candidates = 0;
+	Acquisitions = 0;
+	Breaks = 0;
+	Switches = 0;
+	ArmProbeSweeps = 0;
+	ArmProbeReuses = 0;
+	TargetsRegistered = 0;
+	MaxRegistrationCycles = 0;
+	SoftLockSkips = 0;
+	SoftLockEvaluations = 0;
+	QueryCacheHits = 0;
+	QueryCacheMisses = 0;
+	NetRequests = 0;
+	NetStateUpdates = 0;
+	NetCorrections = 0;
+	NetStateBits = 0;
+}
+
+double FDSLockOnCounters::GetTotalMs()
+{
+	return FPlatformTime::ToMilliseconds64(OuterCycles);
+}
+
+void FDSLockOnCounters::LogSummary(int32 NumFrames)
+{
+	static const TCHAR* ScopeNames[NumScopes] = { TEXT("GetTargetComponents"), TEXT("GetLockTarget"), TEXT("SwitchTarget"), TEXT("TickComponent"), TEXT("CharacterTick"), TEXT("ManagerTick"), TEXT("ArmProbe"), TEXT("Registration") };
+
+	const double Frames = FMath::Max(NumFrames, 1);
+
+	UE_LOG(LogDSLockOnStats, Display, TEXT("Lock-on summary over %d frames"), NumFrames);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  %-20s %10s %12s %10s"), TEXT("Scope"), TEXT("Calls"), TEXT("Total ms"), TEXT("ms/frame"));
+	for (int32 i = 0; i < NumScopes; i++)
+	{
+		const double TotalMs = FPlatformTime::ToMilliseconds64(ScopeCycles[i]);
+		UE_LOG(LogDSLockOnStats, Display, TEXT("  %-20s %10d %12.3f %10.4f"), ScopeNames[i], ScopeCalls[i], TotalMs, TotalMs / Frames);
+	}
+
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Candidates/frame: %.1f"), Candidates / Frames);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Acquisitions: %d, Breaks: %d, Switches: %d"), Acquisitions, Breaks, Switches);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Arm probe sweeps: %d, reuses: %d"), ArmProbeSweeps, ArmProbeReuses);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Targets registered: %d, longest registration pass: %.3f ms"), TargetsRegistered, FPlatformTime::ToMilliseconds64(MaxRegistrationCycles));
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Idle soft-lock skips: %d, evaluations: %d (%.1f%% skipped)"), SoftLockSkips, SoftLockEvaluations,
+		SoftLockSkips + SoftLockEvaluations > 0 ? 100.0 * SoftLockSkips / (SoftLockSkips + SoftLockEvaluations) : 0.0);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Query cache hits: %d, misses: %d (%.1f%% hit rate)"), QueryCacheHits, QueryCacheMisses,
+		QueryCacheHits + QueryCacheMisses > 0 ? 100.0 * QueryCacheHits / (QueryCacheHits + QueryCacheMisses) : 0.0);
+	UE_LOG(LogDSLockOnStats, Display, TEXT("  Net requests: %d, state updates: %d, corrections: %d, state bytes sent: %d"), NetRequests, NetStateUpdates, NetCorrections, NetStateBits / 8);
+}
+
+namespace DSLockOnNetStats
+{
+	static double StartTime = 0.0;
+	static int32 StartRequests = 0;
+	static int32 StartStateUpdates = 0;
+	static int32 StartCorrections = 0;
+	static int32 StartStateBits = 0;
+
+	/* Reports lock-on replication since the last reset, per player in World */
+	static void NetStats(const TArray<FString>& Args, UWorld* World)
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (Args.Num() == 0 || Args[0] != TEXT("reset"))
+		{
+			const double Seconds = FMath::Max(Now - StartTime, 1e-3);
+			const int32 NumPlayers = FMath::Max(World ? World->GetNumPlayerControllers() : 1, 1);
+			const int32 Requests = FDSLockOnCounters::NetRequests - StartRequests;
+			const int32 StateUpdates = FDSLockOnCounters::NetStateUpdates - StartStateUpdates;
+			const int32 Corrections = FDSLockOnCounters::NetCorrections - StartCorrections;
+			const int32 StateBits = FDSLockOnCounters::NetStateBits - StartStateBits;
+
+			UE_LOG(LogDSLockOnStats, Display, TEXT("Lock-on replication over %.1f s, %d players"), Seconds, NumPlayers);
+			UE_LOG(LogDSLockOnStats, Display, TEXT("  State sent: %.2f bytes/player/s (%d bytes)"), StateBits / 8.0 / Seconds / NumPlayers, StateBits / 8);
+			UE_LOG(LogDSLockOnStats, Display, TEXT("  Requests: %d, state updates: %d, corrections: %d (%.1f%% of requests)"),
+				Requests, StateUpdates, Corrections, Requests > 0 ? 100.0 * Corrections / Requests : 0.0);
+		}
+
+		StartTime = Now;
+		StartRequests = FDSLockOnCounters::NetRequests;
+		StartStateUpdates = FDSLockOnCounters::NetStateUpdates;
+		StartCorrections = FDSLockOnCounters::NetCorrections;
+		StartStateBits = FDSLockOnCounters::NetStateBits;
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs NetStatsCommand(
+		TEXT("ds.LockOn.NetStats"),
+		TEXT("Logs lock-on replication bandwidth and correction rate since the last call, then starts a new measurement. Args: [reset]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&NetStats));
+}
+
+#endif
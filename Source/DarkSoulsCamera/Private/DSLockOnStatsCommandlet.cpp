@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnStatsCommandlet.h"
+#include "DSLockOnHeadlessWorld.h"
+#include "DSLockOnStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogDSLockOnStatsCommandlet, Log, All);
+
+UDSLockOnStatsCommandlet::UDSLockOnStatsCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UDSLockOnStatsCommandlet::Main(const FString& Params)
+{
+#if DS_LOCKON_STATS
+	FString MapName;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	int32 NumFrames = 600;
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+
+	float DeltaSeconds = 1.f / 60.f;
+	FParse::Value(*Params, TEXT("DeltaSeconds="), DeltaSeconds);
+
+	FDSLockOnHeadlessWorld HeadlessWorld;
+	if (!HeadlessWorld.Initialize(MapName))
+	{
+		UE_LOG(LogDSLockOnStatsCommandlet, Error, TEXT("Failed to load map '%s'"), *MapName);
+		return 1;
+	}
+
+	// Let everything register before measuring
+	HeadlessWorld.Tick(DeltaSeconds);
+	FDSLockOnCounters::Reset();
+
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		HeadlessWorld.Tick(DeltaSeconds);
+
+	FDSLockOnCounters::LogSummary(NumFrames);
+	return 0;
+#else
+	UE_LOG(LogDSLockOnStatsCommandlet, Error, TEXT("Lock-on stats are compiled out of this build configuration"));
+	return 1;
+#endif
+}
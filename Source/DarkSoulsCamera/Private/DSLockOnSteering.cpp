@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnSteering.h"
+
+namespace DSLockOnSteering
+{
+	/* Springs from Offset onwards */
+	static DSLockOnCore::FRotationSprings SliceSprings(const DSLockOnCore::FRotationSprings& S, int32 Offset)
+	{
+		return { S.QX + Offset, S.QY + Offset, S.QZ + Offset, S.QW + Offset, S.VX + Offset, S.VY + Offset, S.VZ + Offset,
+			S.TX + Offset, S.TY + Offset, S.TZ + Offset, S.TW + Offset, S.Frequency + Offset, S.Num - Offset };
+	}
+
+	void StepRotationSprings(const DSLockOnCore::FRotationSprings& S, float DeltaSeconds)
+	{
+		int32 i = 0;
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS
+		const VectorRegister Dt = VectorSetFloat1(DeltaSeconds);
+		const VectorRegister Half = VectorSetFloat1(0.5f);
+		const VectorRegister Two = VectorSetFloat1(2.f);
+		const VectorRegister SmallAngleSq = VectorSetFloat1(DSLockOnCore::SpringSmallAngle * DSLockOnCore::SpringSmallAngle);
+
+		float SinHalfLanes[4], CosHalfLanes[4], FrequencyLanes[4];
+		float HalfAngleLanes[4], DecayLanes[4];
+
+		for (; i + 4 <= S.Num; i += 4)
+		{
+			const VectorRegister QX = VectorLoad(S.QX + i), QY = VectorLoad(S.QY + i), QZ = VectorLoad(S.QZ + i), QW = VectorLoad(S.QW + i);
+			const VectorRegister TX = VectorLoad(S.TX + i), TY = VectorLoad(S.TY + i), TZ = VectorLoad(S.TZ + i), TW = VectorLoad(S.TW + i);
+			const VectorRegister VX = VectorLoad(S.VX + i), VY = VectorLoad(S.VY + i), VZ = VectorLoad(S.VZ + i);
+			const VectorRegister W = VectorLoad(S.Frequency + i);
+
+			// Error rotation D = Q * conjugate(T), taking the short way round
+			VectorRegister DX = VectorSubtract(VectorSubtract(VectorMultiply(TW, QX), VectorMultiply(QW, TX)), VectorSubtract(VectorMultiply(QY, TZ), VectorMultiply(QZ, TY)));
+			VectorRegister DY = VectorSubtract(VectorSubtract(VectorMultiply(TW, QY), VectorMultiply(QW, TY)), VectorSubtract(VectorMultiply(QZ, TX), VectorMultiply(QX, TZ)));
+			VectorRegister DZ = VectorSubtract(VectorSubtract(VectorMultiply(TW, QZ), VectorMultiply(QW, TZ)), VectorSubtract(VectorMultiply(QX, TY), VectorMultiply(QY, TX)));
+			VectorRegister DW = VectorMultiplyAdd(QZ, TZ, VectorMultiplyAdd(QY, TY, VectorMultiplyAdd(QX, TX, VectorMultiply(QW, TW))));
+
+			const VectorRegister Flip = VectorCompareGT(VectorZero(), DW);
+			DX = VectorSelect(Flip, VectorNegate(DX), DX);
+			DY = VectorSelect(Flip, VectorNegate(DY), DY);
+			DZ = VectorSelect(Flip, VectorNegate(DZ), DZ);
+			DW = VectorSelect(Flip, VectorNegate(DW), DW);
+
+			const VectorRegister SinHalfSq = VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+			const VectorRegister ErrorValid = VectorCompareGT(SinHalfSq, SmallAngleSq);
+			const VectorRegister InvSinHalf = VectorSelect(ErrorValid, VectorReciprocalSqrtAccurate(SinHalfSq), VectorZero());
+
+			// The engine has no vector atan2 or exp, so the error angle and the decay are taken lane by lane
+			VectorStore(VectorMultiply(SinHalfSq, InvSinHalf), SinHalfLanes);
+			VectorStore(DW, CosHalfLanes);
+			VectorStore(W, FrequencyLanes);
+			for (int32 Lane = 0; Lane < 4; Lane++)
+			{
+				HalfAngleLanes[Lane] = FMath::Atan2(SinHalfLanes[Lane], CosHalfLanes[Lane]);
+				DecayLanes[Lane] = FMath::Exp(-FrequencyLanes[Lane] * DeltaSeconds);
+			}
+			const VectorRegister Decay = VectorLoad(DecayLanes);
+
+			// Logarithm of the error: its axis scaled by its angle
+			const VectorRegister LogScale = VectorSelect(ErrorValid, VectorMultiply(Two, VectorMultiply(VectorLoad(HalfAngleLanes), InvSinHalf)), Two);
+			const VectorRegister X0X = VectorMultiply(DX, LogScale);
+			const VectorRegister X0Y = VectorMultiply(DY, LogScale);
+			const VectorRegister X0Z = VectorMultiply(DZ, LogScale);
+
+			// x(t) = (x0 + (v0 + w x0) t) e^-wt and v(t) = (v0 - w (v0 + w x0) t) e^-wt
+			const VectorRegister JX = VectorMultiplyAdd(W, X0X, VX);
+			const VectorRegister JY = VectorMultiplyAdd(W, X0Y, VY);
+			const VectorRegister JZ = VectorMultiplyAdd(W, X0Z, VZ);
+			const VectorRegister X1X = VectorMultiply(VectorMultiplyAdd(JX, Dt, X0X), Decay);
+			const VectorRegister X1Y = VectorMultiply(VectorMultiplyAdd(JY, Dt, X0Y), Decay);
+			const VectorRegister X1Z = VectorMultiply(VectorMultiplyAdd(JZ, Dt, X0Z), Decay);
+
+			const VectorRegister WDt = VectorMultiply(W, Dt);
+			VectorStore(VectorMultiply(VectorSubtract(VX, VectorMultiply(WDt, JX)), Decay), S.VX + i);
+			VectorStore(VectorMultiply(VectorSubtract(VY, VectorMultiply(WDt, JY)), Decay), S.VY + i);
+			VectorStore(VectorMultiply(VectorSubtract(VZ, VectorMultiply(WDt, JZ)), Decay), S.VZ + i);
+
+			// Back to a rotation, applied on top of the target
+			const VectorRegister AngleSq = VectorMultiplyAdd(X1Z, X1Z, VectorMultiplyAdd(X1Y, X1Y, VectorMultiply(X1X, X1X)));
+			const VectorRegister AngleValid = VectorCompareGT(AngleSq, SmallAngleSq);
+			const VectorRegister InvAngle = VectorSelect(AngleValid, VectorReciprocalSqrtAccurate(AngleSq), VectorZero());
+			const VectorRegister HalfAngle = VectorMultiply(VectorMultiply(AngleSq, InvAngle), Half);
+
+			VectorRegister SinHalfAngle, CosHalfAngle;
+			VectorSinCos(&SinHalfAngle, &CosHalfAngle, &HalfAngle);
+
+			const VectorRegister ExpScale = VectorSelect(AngleValid, VectorMultiply(SinHalfAngle, InvAngle), Half);
+			const VectorRegister EX = VectorMultiply(X1X, ExpScale);
+			const VectorRegister EY = VectorMultiply(X1Y, ExpScale);
+			const VectorRegister EZ = VectorMultiply(X1Z, ExpScale);
+			const VectorRegister EW = CosHalfAngle;
+
+			const VectorRegister NX = VectorAdd(VectorMultiplyAdd(EW, TX, VectorMultiply(TW, EX)), VectorSubtract(VectorMultiply(EY, TZ), VectorMultiply(EZ, TY)));
+			const VectorRegister NY = VectorAdd(VectorMultiplyAdd(EW, TY, VectorMultiply(TW, EY)), VectorSubtract(VectorMultiply(EZ, TX), VectorMultiply(EX, TZ)));
+			const VectorRegister NZ = VectorAdd(VectorMultiplyAdd(EW, TZ, VectorMultiply(TW, EZ)), VectorSubtract(VectorMultiply(EX, TY), VectorMultiply(EY, TX)));
+			const VectorRegister NW = VectorSubtract(VectorMultiply(EW, TW), VectorMultiplyAdd(EZ, TZ, VectorMultiplyAdd(EY, TY, VectorMultiply(EX, TX))));
+
+			const VectorRegister InvLength = VectorReciprocalSqrtAccurate(VectorMultiplyAdd(NW, NW, VectorMultiplyAdd(NZ, NZ, VectorMultiplyAdd(NY, NY, VectorMultiply(NX, NX)))));
+			VectorStore(VectorMultiply(NX, InvLength), S.QX + i);
+			VectorStore(VectorMultiply(NY, InvLength), S.QY + i);
+			VectorStore(VectorMultiply(NZ, InvLength), S.QZ + i);
+			VectorStore(VectorMultiply(NW, InvLength), S.QW + i);
+		}
+#endif
+
+		// Remaining springs, or all of them without vector intrinsics
+		StepRotationSpringsScalar(SliceSprings(S, i), DeltaSeconds);
+	}
+
+	void StepRotationSpringsScalar(const DSLockOnCore::FRotationSprings& Springs, float DeltaSeconds)
+	{
+		DSLockOnCore::StepRotationSprings(Springs, DeltaSeconds);
+	}
+}
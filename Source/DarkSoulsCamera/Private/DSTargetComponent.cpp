@@ -1,10 +1,62 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "DSTargetComponent.h"
+#include "DSLockOnManager.h"
+#include "Engine/World.h"
 
 
 /**
 * Targetable component used for camera lock-on system
-* For selection only.  Intentionally empty.
+* For selection only.  Registers itself with the world's lock-on manager while playing.
 */
 
+UDSTargetComponent::UDSTargetComponent()
+{
+	Team = 0;
+	Priority = 0.f;
+	Threat = 0.f;
+	bDeferPhysicsState = false;
+	LockOnIndex = INDEX_NONE;
+	bPhysicsStateReleased = false;
+}
+
+void UDSTargetComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->RegisterTarget(this);
+	else
+		ReleasePhysicsState();
+}
+
+void UDSTargetComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Find(GetWorld()))
+		Manager->UnregisterTarget(this);
+
+	// Registering again, e.g. when the level streams back in, defers the physics state again
+	bPhysicsStateReleased = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UDSTargetComponent::ReleasePhysicsState()
+{
+	if (bPhysicsStateReleased)
+		return;
+
+	bPhysicsStateReleased = true;
+	if (bDeferPhysicsState && IsRegistered() && !IsPhysicsStateCreated())
+		RecreatePhysicsState();
+}
+
+bool UDSTargetComponent::ShouldCreatePhysicsState() const
+{
+	// Only game worlds have a lock-on manager to release it
+	const UWorld* World = GetWorld();
+	if (bDeferPhysicsState && !bPhysicsStateReleased && World && World->IsGameWorld())
+		return false;
+
+	return Super::ShouldCreatePhysicsState();
+}
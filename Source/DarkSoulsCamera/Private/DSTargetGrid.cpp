@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSTargetGrid.h"
+
+FDSTargetGrid::FDSTargetGrid()
+{
+	SetCellSize(500.f);
+}
+
+void FDSTargetGrid::SetCellSize(float NewCellSize)
+{
+	CellSize = FMath::Max(NewCellSize, 1.f);
+	InvCellSize = 1.f / CellSize;
+	Reset();
+}
+
+void FDSTargetGrid::Add(int32 Index, const FVector& Location)
+{
+	check(Index == TargetCells.Num());
+
+	const FIntVector Cell = GetCell(Location);
+	TargetCells.Add(Cell);
+	AddToCell(Cell, Index);
+}
+
+void FDSTargetGrid::RemoveAtSwap(int32 Index)
+{
+	check(TargetCells.IsValidIndex(Index));
+
+	const int32 LastIndex = TargetCells.Num() - 1;
+
+	RemoveFromCell(TargetCells[Index], Index);
+
+	// Re-point the last target's cell entry at its new slot
+	if (Index != LastIndex)
+	{
+		TArray<int32>& LastCell = Cells.FindChecked(TargetCells[LastIndex]);
+		LastCell[LastCell.Find(LastIndex)] = Index;
+	}
+
+	TargetCells.RemoveAtSwap(Index, 1, false);
+}
+
+bool FDSTargetGrid::Move(int32 Index, const FVector& Location)
+{
+	const FIntVector NewCell = GetCell(Location);
+	FIntVector& CurrentCell = TargetCells[Index];
+
+	if (NewCell == CurrentCell)
+		return false;
+
+	RemoveFromCell(CurrentCell, Index);
+	AddToCell(NewCell, Index);
+	CurrentCell = NewCell;
+	return true;
+}
+
+void FDSTargetGrid::Query(const FVector& Origin, float Radius, TArray<int32>& OutIndices) const
+{
+	const FIntVector Min = GetCell(Origin - FVector(Radius));
+	const FIntVector Max = GetCell(Origin + FVector(Radius));
+	const int64 NumQueryCells = int64(Max.X - Min.X + 1) * int64(Max.Y - Min.Y + 1) * int64(Max.Z - Min.Z + 1);
+
+	// For very large radii it is cheaper to walk the occupied cells than every cell in the bounds
+	if (NumQueryCells > Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<int32>>& Pair : Cells)
+		{
+			const FIntVector& Cell = Pair.Key;
+			if (Cell.X >= Min.X && Cell.X <= Max.X && Cell.Y >= Min.Y && Cell.Y <= Max.Y && Cell.Z >= Min.Z && Cell.Z <= Max.Z)
+				OutIndices.Append(Pair.Value);
+		}
+		return;
+	}
+
+	for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			for (int32 X = Min.X; X <= Max.X; X++)
+			{
+				if (const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z)))
+					OutIndices.Append(*Cell);
+			}
+		}
+	}
+}
+
+void FDSTargetGrid::Reset()
+{
+	Cells.Reset();
+	TargetCells.Reset();
+}
+
+void FDSTargetGrid::AddToCell(const FIntVector& Cell, int32 Index)
+{
+	Cells.FindOrAdd(Cell).Add(Index);
+}
+
+void FDSTargetGrid::RemoveFromCell(const FIntVector& Cell, int32 Index)
+{
+	// Empty cells are kept so targets moving back and forth don't reallocate their buckets
+	Cells.FindChecked(Cell).RemoveSingleSwap(Index, false);
+}
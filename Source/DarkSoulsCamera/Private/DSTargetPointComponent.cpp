@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSTargetPointComponent.h"
+#include "DSLockOnManager.h"
+
+UDSTargetPointComponent::UDSTargetPointComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	Radius = 32.f;
+	Team = 0;
+	Priority = 0.f;
+	Threat = 0.f;
+	LockOnIndex = INDEX_NONE;
+}
+
+void UDSTargetPointComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Get(GetWorld()))
+		Manager->RegisterTarget(this);
+}
+
+void UDSTargetPointComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ADSLockOnManager* Manager = ADSLockOnManager::Find(GetWorld()))
+		Manager->UnregisterTarget(this);
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Components/SceneComponent.h"
+#include "DSCandidateRing.h"
+#include "DSLockOnScoring.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSCandidateRingNeighborTest, "DarkSoulsCamera.LockOn.CandidateRing.FindNeighbor", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/**
+* Four targets around the origin, at -45, 0, 30 and 60 degrees of yaw. Switching steps to the nearest target on the
+* requested side, and past the last one on a side only when wrapping.
+*/
+bool FDSCandidateRingNeighborTest::RunTest(const FString& Parameters)
+{
+	const float Yaws[] = { -45.f, 0.f, 30.f, 60.f };
+
+	TArray<USceneComponent*> Targets;
+	FDSCandidateSet Candidates;
+	for (float Yaw : Yaws)
+	{
+		USceneComponent* Target = NewObject<USceneComponent>();
+		const FVector Location = FRotator(0.f, Yaw, 0.f).Vector() * 500.f;
+		Target->SetWorldLocation(Location);
+		Targets.Add(Target);
+		Candidates.Add(Target, Location.X, Location.Y, Location.Z);
+	}
+
+	FDSCandidateRing Ring;
+	Ring.Update(Candidates, FVector::ZeroVector, 2.f);
+
+	TestTrue(TEXT("Right of 0 is 30"), Ring.FindNeighbor(Targets[1], FVector::ZeroVector, true, false, nullptr) == Targets[2]);
+	TestTrue(TEXT("Left of 0 is -45"), Ring.FindNeighbor(Targets[1], FVector::ZeroVector, false, false, nullptr) == Targets[0]);
+
+	// -45 is 105 degrees to the left of 60, and 60 as far to the right of -45
+	TestNull(TEXT("Nothing right of 60"), Ring.FindNeighbor(Targets[3], FVector::ZeroVector, true, false, nullptr));
+	TestNull(TEXT("Nothing left of -45"), Ring.FindNeighbor(Targets[0], FVector::ZeroVector, false, false, nullptr));
+	TestTrue(TEXT("Right of 60 wraps to -45"), Ring.FindNeighbor(Targets[3], FVector::ZeroVector, true, true, nullptr) == Targets[0]);
+	TestTrue(TEXT("Left of -45 wraps to 60"), Ring.FindNeighbor(Targets[0], FVector::ZeroVector, false, true, nullptr) == Targets[3]);
+	return !HasAnyErrors();
+}
+
+#endif
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "DSLockOnHeadlessWorld.h"
+#include "DSLockOnManager.h"
+#include "DSLockArmComponent.h"
+#include "DSTargetPointComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace DSLockOnAllocationTest
+{
+	/**
+	* Forwards to the allocator it replaces, counting allocations made on the game thread while it's installed as
+	* GMalloc. Memory allocated before or after is freed through whichever allocator is current, which always ends up
+	* in the inner one. Static, so another thread that read GMalloc just before it was uninstalled can still call it.
+	*/
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		FCountingMalloc() : Inner(nullptr), NumAllocations(0) {}
+
+		/* Installs this as GMalloc, forwarding to the current one. Uninstall restores it */
+		void Install()
+		{
+			check(GMalloc != this);
+			Inner = GMalloc;
+			NumAllocations = 0;
+			GMalloc = this;
+		}
+
+		/* Returns the number of game thread allocations since Install */
+		int32 Uninstall()
+		{
+			GMalloc = Inner;
+			return NumAllocations;
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// Shrinking to nothing is a free
+			if (Count > 0)
+				CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("DSLockOnCountingMalloc"); }
+
+	private:
+		void CountAllocation()
+		{
+			// Other engine threads keep allocating while the test runs
+			if (IsInGameThread())
+				NumAllocations++;
+		}
+
+		FMalloc* Inner;
+		int32 NumAllocations;
+	};
+
+	static FCountingMalloc CountingMalloc;
+
+	/* Where target i is after Time seconds. Every target circles once every two seconds, so the warm-up covers every cell the test visits */
+	static FVector GetTargetLocation(int32 i, float Time)
+	{
+		const FVector Center((i % 16) * 250.f - 2000.f, (i / 16) * 250.f - 2000.f, 100.f);
+		const float Angle = PI * Time + i;
+		return Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * 300.f;
+	}
+
+	/**
+	* Runs the lock-on manager's per-frame update over moving targets and a mix of hard-locked, soft-lock and idle arms
+	* until its scratch storage has grown to size, then checks that further frames make no allocations on the game thread.
+	* Line of sight is off, as its asynchronous traces allocate inside the engine, and the batch runs inline, as
+	* ParallelFor's task bookkeeping allocates when the batch goes wide. With bPairArms the arms among the targets stand
+	* in pairs, so they share broad phase queries.
+	*/
+	static bool RunSteadyStateTest(FAutomationTestBase& Test, float LockDistance, bool bPairArms)
+	{
+		const int32 NumTargets = 256;
+		const int32 NumArms = 16;
+		const int32 NumWarmupFrames = 60;
+		const int32 NumTestFrames = 60;
+		const float DeltaSeconds = 1.f / 30.f;
+
+		FDSLockOnHeadlessWorld HeadlessWorld;
+		if (!Test.TestTrue(TEXT("Created a world"), HeadlessWorld.Initialize(FString())))
+			return false;
+
+		UWorld* World = HeadlessWorld.GetWorld();
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<UDSTargetPointComponent*> Targets;
+		for (int32 i = 0; i < NumTargets; i++)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(GetTargetLocation(i, 0.f)), SpawnParams);
+			UDSTargetPointComponent* Target = NewObject<UDSTargetPointComponent>(Actor);
+			Actor->SetRootComponent(Target);
+			Target->SetWorldLocation(GetTargetLocation(i, 0.f));
+			Target->RegisterComponent();
+			Targets.Add(Target);
+		}
+
+		// A quarter of the arms hard-lock, a quarter soft-lock among the targets, and the rest idle in soft-lock out of range
+		TArray<UDSLockArmComponent*> Arms;
+		for (int32 i = 0; i < NumArms; i++)
+		{
+			const bool bAmongTargets = i < NumArms / 2;
+			const int32 Slot = bPairArms ? i / 2 * 2 : i;
+			const FVector Location = bAmongTargets ? FVector(Slot * 400.f - 1600.f, 0.f, 100.f) : FVector(20000.f + i * 2.f * LockDistance, 0.f, 100.f);
+
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FRotator(0.f, i * 45.f, 0.f), Location), SpawnParams);
+			UDSLockArmComponent* Arm = NewObject<UDSLockArmComponent>(Actor);
+			Arm->bCheckLineOfSight = false;
+			Arm->bUseSoftLock = i >= NumArms / 4;
+			Arm->MaxTargetLockDistance = LockDistance;
+
+			// Hard locks hold for the whole test, however far their target circles away
+			Arm->RangeBreakHysteresis = Arm->bUseSoftLock ? 0.f : 1000.f;
+			Actor->SetRootComponent(Arm);
+			Arm->SetWorldLocationAndRotation(Location, FRotator(0.f, i * 45.f, 0.f));
+			Arm->RegisterComponent();
+			Arms.Add(Arm);
+		}
+
+		ADSLockOnManager* Manager = ADSLockOnManager::Find(World);
+		if (!Test.TestNotNull(TEXT("Lock-on manager"), Manager))
+			return false;
+
+		IConsoleVariable* ParallelMinArms = IConsoleManager::Get().FindConsoleVariable(TEXT("ds.LockOn.ParallelMinArms"));
+		const int32 PreviousParallelMinArms = ParallelMinArms ? ParallelMinArms->GetInt() : 0;
+		if (ParallelMinArms)
+			ParallelMinArms->Set(0);
+
+		Manager->ProcessRegistrationQueue(0.f);
+		GFrameCounter++;
+		Manager->Tick(DeltaSeconds);
+
+		for (int32 i = 0; i < NumArms / 4; i++)
+			Arms[i]->ToggleCameraLock();
+
+		int32 NumAllocations = 0;
+		int32 NumLocked = 0;
+		for (int32 Frame = 1; Frame <= NumWarmupFrames + NumTestFrames; Frame++)
+		{
+			for (int32 i = 0; i < NumTargets; i++)
+				Targets[i]->SetWorldLocation(GetTargetLocation(i, Frame * DeltaSeconds));
+			GFrameCounter++;
+
+			if (Frame <= NumWarmupFrames)
+			{
+				Manager->Tick(DeltaSeconds);
+				continue;
+			}
+
+			CountingMalloc.Install();
+			Manager->Tick(DeltaSeconds);
+			NumAllocations += CountingMalloc.Uninstall();
+		}
+
+		for (UDSLockArmComponent* Arm : Arms)
+			NumLocked += Arm->IsCameraLockedToTarget() ? 1 : 0;
+
+		if (ParallelMinArms)
+			ParallelMinArms->Set(PreviousParallelMinArms);
+
+		// Otherwise the test proves nothing about the selection path
+		Test.TestTrue(TEXT("Arms locked on during the test"), NumLocked >= NumArms / 4);
+		Test.TestEqual(TEXT("Allocations over steady-state lock updates"), NumAllocations, 0);
+		return !Test.HasAnyErrors();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnUpdateAllocationTest, "DarkSoulsCamera.LockOn.Manager.SteadyStateAllocations", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/* At the default lock distance each query covers a few dozen target actors */
+bool FDSLockOnUpdateAllocationTest::RunTest(const FString& Parameters)
+{
+	return DSLockOnAllocationTest::RunSteadyStateTest(*this, 750.f, false);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnDenseUpdateAllocationTest, "DarkSoulsCamera.LockOn.Manager.SteadyStateAllocationsDense", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/* Each query covers well over 64 target actors, and arms in pairs share theirs */
+bool FDSLockOnDenseUpdateAllocationTest::RunTest(const FString& Parameters)
+{
+	return DSLockOnAllocationTest::RunSteadyStateTest(*this, 2500.f, true);
+}
+
+#endif
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "DSLockOnHeadlessWorld.h"
+#include "DSLockOnManager.h"
+#include "DSLockArmComponent.h"
+#include "DSTargetPointComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnNetSoftLockBreakTest, "DarkSoulsCamera.LockOn.Net.SoftLockBreak", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/**
+* Plays a server arm and its owning client's arm side by side in one world, with the test carrying the client's
+* request and the server's replicated state between them. After the client breaks soft-lock, the server's batched
+* update must not re-acquire the target, which replication would then push back onto the client.
+*/
+bool FDSLockOnNetSoftLockBreakTest::RunTest(const FString& Parameters)
+{
+	const float DeltaSeconds = 1.f / 30.f;
+	const int32 NumFrames = 30;
+
+	FDSLockOnHeadlessWorld HeadlessWorld;
+	if (!TestTrue(TEXT("Created a world"), HeadlessWorld.Initialize(FString())))
+		return false;
+
+	UWorld* World = HeadlessWorld.GetWorld();
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FVector TargetLocation(300.f, 0.f, 100.f);
+	AActor* TargetActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(TargetLocation), SpawnParams);
+	UDSTargetPointComponent* Target = NewObject<UDSTargetPointComponent>(TargetActor);
+	TargetActor->SetRootComponent(Target);
+	Target->SetWorldLocation(TargetLocation);
+	Target->RegisterComponent();
+
+	auto SpawnArm = [World, &SpawnParams](ENetRole Role)
+	{
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FVector(0.f, 0.f, 100.f)), SpawnParams);
+		Actor->Role = Role;
+
+		UDSLockArmComponent* Arm = NewObject<UDSLockArmComponent>(Actor);
+		Arm->bCheckLineOfSight = false;
+		Arm->bUseSoftLock = true;
+		Actor->SetRootComponent(Arm);
+		Arm->SetWorldLocation(FVector(0.f, 0.f, 100.f));
+		Arm->RegisterComponent();
+		return Arm;
+	};
+
+	UDSLockArmComponent* ServerArm = SpawnArm(ROLE_Authority);
+	UDSLockArmComponent* ClientArm = SpawnArm(ROLE_AutonomousProxy);
+
+	ADSLockOnManager* Manager = ADSLockOnManager::Find(World);
+	if (!TestNotNull(TEXT("Lock-on manager"), Manager))
+		return false;
+
+	// Sends the server's state through the net serializer while it has no target, which needs no package map
+	auto Replicate = [ServerArm, ClientArm]()
+	{
+		bool bSuccess = false;
+		if (ServerArm->ReplicatedLockState.Target)
+		{
+			ClientArm->ReplicatedLockState = ServerArm->ReplicatedLockState;
+		}
+		else
+		{
+			FBitWriter Writer(64, true);
+			ServerArm->ReplicatedLockState.NetSerialize(Writer, nullptr, bSuccess);
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			ClientArm->ReplicatedLockState.NetSerialize(Reader, nullptr, bSuccess);
+		}
+		ClientArm->OnRep_LockState();
+	};
+
+	auto TickFrames = [Manager, &Replicate, DeltaSeconds](int32 Num)
+	{
+		for (int32 Frame = 0; Frame < Num; Frame++)
+		{
+			GFrameCounter++;
+			Manager->Tick(DeltaSeconds);
+			Replicate();
+		}
+	};
+
+	Manager->ProcessRegistrationQueue(0.f);
+	TickFrames(NumFrames);
+
+	if (!TestTrue(TEXT("Server soft-locked"), ServerArm->IsCameraLockedToTarget()) || !TestTrue(TEXT("Client soft-locked"), ClientArm->IsCameraLockedToTarget()))
+		return false;
+
+	// A harsh mouse movement on the client, as ADSCharacter applies it. With no net driver the RPC is absorbed, so it's delivered by hand
+	ClientArm->bSoftlockRequiresReset = true;
+	ClientArm->BreakTargetLock();
+	ServerArm->ServerSetLockState_Implementation(ClientArm->CameraTarget, ClientArm->bUseSoftLock, ClientArm->bSoftlockRequiresReset, ClientArm->PredictionSequence);
+	Replicate();
+
+	TestTrue(TEXT("Server holds the soft-lock reset"), ServerArm->bSoftlockRequiresReset);
+	TestTrue(TEXT("Replicated state carries the soft-lock reset"), ServerArm->ReplicatedLockState.bSoftlockRequiresReset);
+
+	// The target stays in range, so nothing may clear the reset
+	TickFrames(NumFrames);
+
+	TestFalse(TEXT("Server stays unlocked"), ServerArm->IsCameraLockedToTarget());
+	TestFalse(TEXT("Client stays unlocked"), ClientArm->IsCameraLockedToTarget());
+	TestTrue(TEXT("Client keeps the soft-lock reset"), ClientArm->bSoftlockRequiresReset);
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnNetRejectTargetTest, "DarkSoulsCamera.LockOn.Net.RejectTarget", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/**
+* Sends the server arm lock requests a client could make up, for targets in range that its own lock logic would never
+* pick: one on the arm's team and one the server has seen behind a wall. Both must be refused, and a fair one accepted.
+*/
+bool FDSLockOnNetRejectTargetTest::RunTest(const FString& Parameters)
+{
+	FDSLockOnHeadlessWorld HeadlessWorld;
+	if (!TestTrue(TEXT("Created a world"), HeadlessWorld.Initialize(FString())))
+		return false;
+
+	UWorld* World = HeadlessWorld.GetWorld();
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	auto SpawnTarget = [World, &SpawnParams](const FVector& Location, int32 Team)
+	{
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Location), SpawnParams);
+		UDSTargetPointComponent* Target = NewObject<UDSTargetPointComponent>(Actor);
+		Target->Team = Team;
+		Actor->SetRootComponent(Target);
+		Target->SetWorldLocation(Location);
+		Target->RegisterComponent();
+		return Target;
+	};
+
+	UDSTargetPointComponent* Teammate = SpawnTarget(FVector(300.f, 0.f, 100.f), 1);
+	UDSTargetPointComponent* Hidden = SpawnTarget(FVector(0.f, 300.f, 100.f), 2);
+	UDSTargetPointComponent* Enemy = SpawnTarget(FVector(0.f, -300.f, 100.f), 2);
+
+	AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FVector(0.f, 0.f, 100.f)), SpawnParams);
+	Actor->Role = ROLE_Authority;
+
+	UDSLockArmComponent* Arm = NewObject<UDSLockArmComponent>(Actor);
+	Arm->Team = 1;
+	Actor->SetRootComponent(Arm);
+	Arm->SetWorldLocation(FVector(0.f, 0.f, 100.f));
+	Arm->RegisterComponent();
+
+	// As if the server's last trace to it was blocked
+	FDSLineOfSightCache::FEntry& Entry = Arm->LineOfSight.Entries[Arm->LineOfSight.FindOrAdd(Hidden)];
+	Entry.bHasResult = true;
+	Entry.bVisible = false;
+
+	Arm->ServerSetLockState_Implementation(Teammate, false, false, 1);
+	TestFalse(TEXT("Teammate refused"), Arm->IsCameraLockedToTarget());
+
+	Arm->ServerSetLockState_Implementation(Hidden, false, false, 2);
+	TestFalse(TEXT("Occluded target refused"), Arm->IsCameraLockedToTarget());
+
+	Arm->ServerSetLockState_Implementation(Enemy, false, false, 3);
+	TestTrue(TEXT("Visible enemy accepted"), Arm->CameraTarget == Enemy);
+	return !HasAnyErrors();
+}
+
+#endif
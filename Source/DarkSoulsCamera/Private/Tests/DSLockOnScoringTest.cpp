@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "DSLockOnScoring.h"
+#include "DSLockOnCore.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Checks the vectorized scoring and projection kernels against the scalar ones in DSLockOnCore, over random candidates.
+* On SSE2 targets these are the core's own 4-wide kernels, which the standalone tests cover too.
+* Candidate counts run from 0 to 13 and on to a large batch, so every length of scalar tail is covered.
+*/
+namespace DSLockOnScoringTest
+{
+	static const int32 CandidateCounts[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 1027 };
+
+	/* Relative to the magnitude of the values, so long distances get the same share of slack as unit directions */
+	static bool IsNearlyEqual(float A, float B)
+	{
+		const float Tolerance = 1.e-5f;
+		return FMath::Abs(A - B) <= Tolerance * FMath::Max3(1.f, FMath::Abs(A), FMath::Abs(B));
+	}
+
+	static void FillCandidates(FRandomStream& Random, int32 Num, const FVector& Origin, TArray<float>& X, TArray<float>& Y, TArray<float>& Z)
+	{
+		X.SetNumUninitialized(Num);
+		Y.SetNumUninitialized(Num);
+		Z.SetNumUninitialized(Num);
+
+		for (int32 i = 0; i < Num; i++)
+		{
+			// Every so often a candidate sits on the origin, around GetSafeNormal's tolerance or at unit length along an axis
+			static const float SpecialLengths[] = { 0.f, 1.e-8f, 9.9e-5f, 1.e-4f, 1.01e-4f, 1.f };
+			const int32 Special = Random.RandRange(0, 15);
+			const FVector Position = Special < (int32)ARRAY_COUNT(SpecialLengths) ? Origin + FVector(0.f, SpecialLengths[Special], 0.f) : Origin + Random.GetUnitVector() * Random.FRandRange(1.f, 5000.f);
+			X[i] = Position.X;
+			Y[i] = Position.Y;
+			Z[i] = Position.Z;
+		}
+	}
+
+	static bool CompareArrays(FAutomationTestBase& Test, const TCHAR* What, int32 Num, const TArray<float>& Vector, const TArray<float>& Scalar)
+	{
+		for (int32 i = 0; i < Vector.Num(); i++)
+		{
+			if (!IsNearlyEqual(Vector[i], Scalar[i]))
+			{
+				Test.AddError(FString::Printf(TEXT("%s differs for candidate %d of %d: vector %f, scalar %f"), What, i, Num, Vector[i], Scalar[i]));
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnScoreCandidatesTest, "DarkSoulsCamera.LockOn.Scoring.ScoreCandidates", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDSLockOnScoreCandidatesTest::RunTest(const FString& Parameters)
+{
+	using namespace DSLockOnScoringTest;
+
+	FRandomStream Random(0x5C0E);
+	TArray<float> X, Y, Z, Dot, Side, Distance, ScalarDot, ScalarSide, ScalarDistance;
+
+	for (const int32 Num : CandidateCounts)
+	{
+		// Every other batch queries from the world origin, where the smallest offsets above aren't lost to rounding
+		const FVector Origin = Num % 2 == 0 ? FVector::ZeroVector : Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f);
+		const FVector Reference = Random.GetUnitVector();
+		FillCandidates(Random, Num, Origin, X, Y, Z);
+
+		Dot.SetNumUninitialized(Num);
+		Side.SetNumUninitialized(Num);
+		Distance.SetNumUninitialized(Num);
+		ScalarDot.SetNumUninitialized(Num);
+		ScalarSide.SetNumUninitialized(Num);
+		ScalarDistance.SetNumUninitialized(Num);
+
+		DSLockOnScoring::ScoreCandidates(X.GetData(), Y.GetData(), Z.GetData(), Num, Origin, Reference, Dot.GetData(), Side.GetData(), Distance.GetData());
+		DSLockOnScoring::ScoreCandidatesScalar(X.GetData(), Y.GetData(), Z.GetData(), Num, Origin, Reference, ScalarDot.GetData(), ScalarSide.GetData(), ScalarDistance.GetData());
+
+		CompareArrays(*this, TEXT("Dot"), Num, Dot, ScalarDot);
+		CompareArrays(*this, TEXT("Side"), Num, Side, ScalarSide);
+		CompareArrays(*this, TEXT("Distance"), Num, Distance, ScalarDistance);
+	}
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnProjectCandidatesTest, "DarkSoulsCamera.LockOn.Scoring.ProjectCandidates", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDSLockOnProjectCandidatesTest::RunTest(const FString& Parameters)
+{
+	using namespace DSLockOnScoringTest;
+
+	FRandomStream Random(0x960C);
+	TArray<float> X, Y, Z, NDCX, NDCY, W, ScalarNDCX, ScalarNDCY, ScalarW;
+
+	for (const int32 Num : CandidateCounts)
+	{
+		// Candidates surround the camera, so some are behind it and some are off screen
+		const FVector Eye = Random.GetUnitVector() * Random.FRandRange(0.f, 10000.f);
+		const FMatrix View = FLookAtMatrix(Eye, Eye + Random.GetUnitVector(), FVector::UpVector);
+		const FMatrix ViewProjection = View * FReversedZPerspectiveMatrix(FMath::DegreesToRadians(45.f), 16.f, 9.f, 10.f);
+		FillCandidates(Random, Num, Eye, X, Y, Z);
+
+		NDCX.SetNumUninitialized(Num);
+		NDCY.SetNumUninitialized(Num);
+		W.SetNumUninitialized(Num);
+		ScalarNDCX.SetNumUninitialized(Num);
+		ScalarNDCY.SetNumUninitialized(Num);
+		ScalarW.SetNumUninitialized(Num);
+
+		DSLockOnScoring::ProjectCandidates(X.GetData(), Y.GetData(), Z.GetData(), Num, ViewProjection, NDCX.GetData(), NDCY.GetData(), W.GetData());
+		DSLockOnCore::ProjectCandidates(X.GetData(), Y.GetData(), Z.GetData(), Num, &ViewProjection.M[0][0], ScalarNDCX.GetData(), ScalarNDCY.GetData(), ScalarW.GetData());
+
+		// The kernels sum the matrix terms in a different order, so rounding is relative to the size of the terms rather
+		// than the result. Near the camera plane W cancels to almost nothing, so NDCs are compared back in clip space
+		const FMatrix& M = ViewProjection;
+		for (int32 i = 0; i < Num; i++)
+		{
+			float Scale = 0.f;
+			for (int32 Column : { 0, 1, 3 })
+				Scale = FMath::Max(Scale, FMath::Abs(X[i] * M.M[0][Column]) + FMath::Abs(Y[i] * M.M[1][Column]) + FMath::Abs(Z[i] * M.M[2][Column]) + FMath::Abs(M.M[3][Column]));
+
+			const float Tolerance = 1.e-5f * FMath::Max(Scale, 1.f);
+			bool bMatches = FMath::IsNearlyEqual(W[i], ScalarW[i], Tolerance);
+
+			// Either kernel may cull a point W rounds to zero for
+			if (bMatches && W[i] > Tolerance && ScalarW[i] > Tolerance)
+			{
+				bMatches = FMath::IsNearlyEqual(NDCX[i] * W[i], ScalarNDCX[i] * ScalarW[i], Tolerance)
+					&& FMath::IsNearlyEqual(NDCY[i] * W[i], ScalarNDCY[i] * ScalarW[i], Tolerance);
+			}
+
+			if (!bMatches)
+			{
+				AddError(FString::Printf(TEXT("Projection differs for candidate %d of %d: vector (%f, %f, %f), scalar (%f, %f, %f)"),
+					i, Num, NDCX[i], NDCY[i], W[i], ScalarNDCX[i], ScalarNDCY[i], ScalarW[i]));
+				break;
+			}
+		}
+	}
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDSLockOnScreenSpaceCurvesTest, "DarkSoulsCamera.LockOn.Scoring.ScreenSpaceCurves", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+/**
+* With screen-space selection and scoring curves together, the distance curve must be read at the world distance.
+* The off-axis candidate is nearer in clip W but further away, so reading the curve at W would pick it instead.
+*/
+bool FDSLockOnScreenSpaceCurvesTest::RunTest(const FString& Parameters)
+{
+	FDSCandidateSet Candidates;
+	Candidates.Add(nullptr, 200.f, 190.f, 0.f);
+	Candidates.Add(nullptr, 260.f, 0.f, 0.f);
+
+	const FMatrix View = FLookAtMatrix(FVector::ZeroVector, FVector::ForwardVector, FVector::UpVector);
+	DSLockOnScoring::ScoreCandidatesOnScreen(Candidates, View * FReversedZPerspectiveMatrix(FMath::DegreesToRadians(60.f), 16.f, 9.f, 10.f), 0.f);
+	if (!TestEqual(TEXT("Candidates on screen"), Candidates.Num(), 2))
+		return false;
+
+	DSLockOnScoring::ScoreCandidates(Candidates, FVector::ZeroVector, FVector::ForwardVector);
+
+	DSLockOnCore::FScoringTables Tables;
+	DSLockOnCore::BakeScoreTable(Tables.Distance, 0.f, 1.f, [](float Fraction) { return 1.f - Fraction; });
+	Tables.AngleWeight = 0.f;
+	Tables.DistanceWeight = 1.f;
+	Tables.ThreatWeight = 0.f;
+	Tables.RecencyWeight = 0.f;
+
+	DSLockOnScoring::ScoreWithTables(Candidates, Tables, 750.f, FDSRecentTargets(), 0.f);
+	const int32 BestIdx = DSLockOnScoring::SelectLockTargetByScore(Candidates);
+
+	TestTrue(TEXT("Screen scores kept apart"), Candidates.HasScreenScores());
+	TestEqual(TEXT("World distance of the off-axis candidate"), Candidates.Distance[0], FVector(200.f, 190.f, 0.f).Size(), 1e-2f);
+	TestTrue(TEXT("Picked the nearer candidate in world space"), BestIdx != INDEX_NONE && Candidates.X[BestIdx] == 260.f);
+	return !HasAnyErrors();
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class USceneComponent;
+struct FDSCandidateSet;
+struct FDSLineOfSightCache;
+
+/**
+* In-range lock-on candidates sorted by world yaw around their arm, so a left or right target switch is a neighbor lookup.
+* Updated incrementally from the candidates of each lock logic update. An entry's yaw only changes once it has moved by
+* more than the resort tolerance, and the nearly sorted ring is repaired with an insertion sort, so switching cycles
+* through targets in a stable order. Entries are indexed by target, so an update is linear in the number of candidates.
+*/
+struct DARKSOULSCAMERA_API FDSCandidateRing
+{
+	struct FEntry
+	{
+		TWeakObjectPtr<USceneComponent> Target;
+
+		/* World yaw in degrees from the arm, in (-180, 180] */
+		float Yaw;
+
+		/* Set while matching entries against a candidate update */
+		bool bSeen;
+	};
+
+	/* Sorted by ascending yaw, i.e. clockwise seen from above */
+	TArray<FEntry> Entries;
+
+	/* Index of each target's entry. Keys are only compared, never dereferenced */
+	TMap<const USceneComponent*, int32> EntryIndices;
+
+	/* Replaces the ring's contents with Candidates as seen from Origin. Entries within ResortTolerance degrees of their stored yaw keep their place */
+	void Update(const FDSCandidateSet& Candidates, const FVector& Origin, float ResortTolerance);
+
+	/**
+	* The next target after CurrentTarget to the right (clockwise) or left. Skips targets that LineOfSight knows to be
+	* occluded, if given. If CurrentTarget isn't in the ring, starts from where it would be. Without bWrap the search ends
+	* at the target directly behind, so it only returns targets on the requested side of CurrentTarget. With it, the
+	* search carries on round to the far side. Returns null if there is no such target.
+	*/
+	USceneComponent* FindNeighbor(const USceneComponent* CurrentTarget, const FVector& Origin, bool bRight, bool bWrap, const FDSLineOfSightCache* LineOfSight) const;
+
+	int32 Num() const { return Entries.Num(); }
+
+	void Reset() { Entries.Reset(); EntryIndices.Reset(); }
+
+private:
+	/* Entry of Target, or INDEX_NONE */
+	int32 Find(const USceneComponent* Target) const;
+
+	void RebuildIndices();
+};
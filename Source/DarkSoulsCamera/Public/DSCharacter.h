@@ -4,13 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "DSLockOnCore.h"
 #include "DSCharacter.generated.h"
 
+class FDSLockOnInputProcessor;
+
 UCLASS(config=Game)
 class ADSCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	/* Drives the input handlers with synthetic input */
+	friend class UDSLockOnBenchmarkCommandlet;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		class UDSLockArmComponent* CameraLockArm;
@@ -32,6 +38,7 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Lock On Camera")
 	float BaseLookUpRate;
 
+	/** Natural frequency of the spring steering the control rotation towards the lock target, in rad/sec. Higher values settle faster. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Lock On Camera")
 	float LockonControlRotationRate;;
 
@@ -65,6 +72,22 @@ public:
 	/* Time that player broke camera lock at */
 	float BrokeLockTime;
 
+	/* Detect target switches and lock breaks from raw, timestamped input events instead of per-frame axis values, when running with Slate */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+	bool bUseRawLockInput;
+
+	/* Scale from raw mouse pixels to the turn axis units the mouse thresholds are in. Should match the MouseX axis sensitivity in DefaultInput.ini */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+	float RawMouseTurnScale;
+
+	/* Raw stick deflection below which the analog stick counts as returned to centre */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+	float TargetSwitchSettleValue;
+
+	/* Window raw mouse deltas are summed over before comparing with the mouse thresholds, which were tuned per frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+	float RawMouseWindowSeconds;
+
 public:
 	/* Constructor */
 	ADSCharacter();
@@ -92,6 +115,27 @@ protected:
 
 	/* Tick every frame */
 	virtual void TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction) override;
+
+	virtual void BeginPlay() override;
+	virtual void UnPossessed() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/* Raw input recorder, registered with Slate while a local player controls this character */
+	TSharedPtr<FDSLockOnInputProcessor> RawInputProcessor;
+
+	/* Next raw input event to process */
+	uint32 RawInputReadIndex;
+
+	DSLockOnCore::FGestureState GestureState;
+
+	void RegisterRawInput();
+	void UnregisterRawInput();
+
+	/* Runs gesture detection over the raw input received since the last tick and applies the results */
+	void ProcessRawLockInput();
+
+	void ApplyLockGesture(DSLockOnCore::ELockGesture Gesture);
 	
 public:
 	/** Returns CameraBoom subobject **/
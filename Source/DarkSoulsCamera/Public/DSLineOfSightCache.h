@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldCollision.h"
+
+class USceneComponent;
+struct FDSCandidateSet;
+
+/**
+* Per-arm line of sight results for lock-on targets, filled by asynchronous traces.
+* The last known result for a target stands until a newer trace completes, so an expired entry is re-traced but
+* still used for filtering. Entries are indexed by target, so filtering a candidate set is linear in its size.
+* Read from worker threads during the batched lock update, written only on the game thread.
+*/
+struct DARKSOULSCAMERA_API FDSLineOfSightCache
+{
+	struct FEntry
+	{
+		/* Only used as a key, never dereferenced */
+		const USceneComponent* Target;
+
+		/* Trace in flight for this target, invalid if none */
+		FTraceHandle PendingTrace;
+		float IssueTime;
+
+		/* World time of the last completed trace */
+		float ResultTime;
+		bool bHasResult;
+		bool bVisible;
+	};
+
+	TArray<FEntry> Entries;
+
+	/* Index of each target's entry, kept in step with Entries by FindOrAdd and Prune */
+	TMap<const USceneComponent*, int32> EntryIndices;
+
+	/* Index of Target's entry, or INDEX_NONE */
+	int32 Find(const USceneComponent* Target) const;
+
+	/* Index of the entry waiting on Handle, or INDEX_NONE. HintIndex is checked first */
+	int32 FindPending(const FTraceHandle& Handle, int32 HintIndex) const;
+
+	/* Index of Target's entry, adding an empty one if it has none */
+	int32 FindOrAdd(const USceneComponent* Target);
+
+	/* True if the last completed trace to Target was blocked */
+	bool IsOccluded(const USceneComponent* Target) const;
+
+	/* True if the last completed trace to Target reached it. A target not traced yet is neither visible nor occluded */
+	bool IsVisible(const USceneComponent* Target) const;
+
+	/* True if the entry has no trace in flight and no result newer than TTL. Traces lost for longer than a second are reissued */
+	bool NeedsTrace(int32 Index, float Now, float TTL) const;
+
+	/* Removes candidates whose last known line of sight was blocked */
+	void RemoveOccluded(FDSCandidateSet& Candidates) const;
+
+	/* Keeps occluded candidates in a scored set but pushes them behind the reference, so lock selection skips them. Returns how many */
+	int32 ExcludeOccluded(FDSCandidateSet& Candidates) const;
+
+	/* Drops entries with no trace in flight and no result for longer than MaxAge */
+	void Prune(float Now, float MaxAge);
+
+	void Reset() { Entries.Reset(); EntryIndices.Reset(); }
+};
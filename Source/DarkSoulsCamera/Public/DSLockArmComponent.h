@@ -4,8 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/SpringArmComponent.h"
+#include "DSLockOnCore.h"
+#include "DSLockOnScoring.h"
+#include "DSLineOfSightCache.h"
+#include "DSCandidateRing.h"
 #include "DSLockArmComponent.generated.h"
 
+class UCurveFloat;
+
 UENUM(BlueprintType)
 enum class EDirection : uint8
 {
@@ -13,6 +19,71 @@ enum class EDirection : uint8
 	Right	UMETA(DisplayName = "Right"),
 };
 
+/**
+* Server-authoritative lock state, replicated whenever it changes.
+* Serialized as a 7-bit header (soft-lock, has target, soft-lock reset and a 4-bit prediction sequence) followed by the
+* target's network handle when locked, so a lock, switch or break costs a few bytes once rather than bandwidth every frame.
+*/
+USTRUCT()
+struct DARKSOULSCAMERA_API FDSLockOnRepState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		USceneComponent* Target;
+
+	UPROPERTY()
+		bool bUseSoftLock;
+
+	/* Soft-lock was broken and may not re-acquire until every candidate has left range */
+	UPROPERTY()
+		bool bSoftlockRequiresReset;
+
+	/* Last prediction sequence the server accepted from the owning client. Wraps at SequenceMask */
+	UPROPERTY()
+		uint8 Sequence;
+
+	static const uint8 SequenceMask = 0xF;
+
+	FDSLockOnRepState() : Target(nullptr), bUseSoftLock(false), bSoftlockRequiresReset(false), Sequence(0) {}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FDSLockOnRepState> : public TStructOpsTypeTraitsBase2<FDSLockOnRepState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/* Arm-to-target geometry for one frame, computed once and shared by everything steering towards the locked target */
+struct FDSLockFrame
+{
+	/* Arm pivot the frame was measured from */
+	FVector Origin;
+	FVector TargetLocation;
+
+	/* Unit direction from Origin to the target, and its rotation */
+	FVector Direction;
+	FRotator Rotation;
+
+	/* Horizontal basis facing the target, for movement input */
+	FVector YawForward;
+	FVector YawRight;
+
+	float Distance;
+
+	/* Where the camera should aim. The target's predicted position with predictive tracking, otherwise TargetLocation */
+	FVector AimLocation;
+	FRotator AimRotation;
+
+	/* False while nothing is locked. Nothing else is set then */
+	bool bValid;
+};
+
 /**
  * 
  */
@@ -21,38 +92,360 @@ class DARKSOULSCAMERA_API UDSLockArmComponent : public USpringArmComponent
 {
 	GENERATED_BODY()
 
+	friend class ADSLockOnManager;
+
 public:	
 	/* Max Distance from the character for an actor to be targetable */
 	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
 		float MaxTargetLockDistance;
 
+	/* Extra distance beyond MaxTargetLockDistance a locked target may move before the lock breaks */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float RangeBreakHysteresis;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
 		bool bUseSoftLock;
 
-	/* Turn debug visuals on/off */
+	/* Targets on this team are skipped. 0 can lock on to every target */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		int32 Team;
+
+	/* Rate in Hz of the lock logic update (target validity, range break, soft-lock) while locked on. 0 updates every frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float LockLogicRate;
+
+	/* Rate in Hz of the lock logic update while nothing is locked. 0 updates every frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float IdleLockLogicRate;
+
+	/* Rate in Hz of the lock logic update while the locked target is further than FarTargetDistanceRatio of the lock distance */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float FarTargetLockLogicRate;
+
+	/* Fraction of MaxTargetLockDistance beyond which a locked target counts as far */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+		float FarTargetDistanceRatio;
+
+	/* Rate in Hz at which an idle soft-lock arm re-evaluates even when nothing in range changed. 0 disables the fallback */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float SoftLockFallbackRate;
+
+	/* Distance the arm may drift from where idle soft-lock was last evaluated before it's evaluated again. Absorbs jitter and idle sway */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera", meta = (ClampMin = "0.0"))
+		float SoftLockShellTolerance;
+
+	/* Degrees the arm may turn from where idle soft-lock was last evaluated before it's evaluated again */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera", meta = (ClampMin = "0.0", ClampMax = "180.0"))
+		float SoftLockShellAngle;
+
+	/* Reject occluded targets and break lock on targets that stay occluded. Checked with asynchronous traces */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		bool bCheckLineOfSight;
+
+	/* Channel used for line of sight traces */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		TEnumAsByte<ECollisionChannel> LineOfSightChannel;
+
+	/* Seconds a line of sight result is trusted before the target is traced again */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float LineOfSightTTL;
+
+	/* Seconds the locked target must stay occluded before the lock breaks */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		float OcclusionBreakDelay;
+
+	/* Degrees a target's bearing must change before it moves in the target switching order */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera", meta = (ClampMin = "0.0"))
+		float SwitchOrderTolerance;
+
+	/* Switching past the last target on one side carries on round to the far side, instead of keeping the current target */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
+		bool bWrapTargetSwitching;
+
+	/* Pick lock targets by distance from the center of the attached camera's view, ignoring targets off screen or behind the camera */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Selection")
+		bool bScreenSpaceSelection;
+
+	/* Fraction of the half-screen inset from each edge. Targets projected outside it can't be picked */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Selection", meta = (EditCondition = "bScreenSpaceSelection", ClampMin = "0.0", ClampMax = "0.9"))
+		float ScreenMargin;
+
+	/* Pick lock targets by the weighted scoring curves below instead of facing alone. Priority is still added on top */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring")
+		bool bUseScoringCurves;
+
+	/* Score by degrees between the target and the arm's forward direction, 0 to 180. With screen-space selection, 0 is the screen center */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		UCurveFloat* AngleScoreCurve;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		float AngleScoreWeight;
+
+	/* Score by distance as a fraction of MaxTargetLockDistance, 0 to 1 */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		UCurveFloat* DistanceScoreCurve;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		float DistanceScoreWeight;
+
+	/* Score by the target's Threat, over the curve's time range */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		UCurveFloat* ThreatScoreCurve;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		float ThreatScoreWeight;
+
+	/* Score by seconds since this arm last locked on to the target, from 0 to the curve's last key. Targets never locked read the last key */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		UCurveFloat* RecencyScoreCurve;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Scoring", meta = (EditCondition = "bUseScoringCurves"))
+		float RecencyScoreWeight;
+
+	/* Aim ahead of the locked target along its estimated motion, so the camera doesn't trail fast targets */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking")
+		bool bPredictiveTracking;
+
+	/* How far ahead to aim, in seconds. The steering spring trails a target turning at a constant rate by 2 / LockonControlRotationRate,
+	* which is the lead used while this is 0 */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking", ClampMin = "0.0"))
+		float TrackingLeadSeconds;
+
+	/* Tracking filter gains for position, velocity and acceleration */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking", ClampMin = "0.0", ClampMax = "1.0"))
+		float TrackingAlpha;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking", ClampMin = "0.0", ClampMax = "1.0"))
+		float TrackingBeta;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking", ClampMin = "0.0", ClampMax = "1.0"))
+		float TrackingGamma;
+
+	/* Furthest the aim point may lead the target */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking"))
+		float TrackingMaxLeadDistance;
+
+	/* Prediction error at which the lead is dropped, e.g. when the target changes direction. The lead fades out up to it */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Tracking", meta = (EditCondition = "bPredictiveTracking"))
+		float TrackingOvershootTolerance;
+
+	/* While locked on, reuse the last camera collision probe while the arm barely moves and refresh it with asynchronous sweeps.
+	* A refreshed result lands the frame after its sweep was issued, so obstacles moving into a held arm are seen a frame late */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Collision")
+		bool bCoherentArmProbe;
+
+	/* Distance the arm pivot may move from where the cached probe was taken before a full sweep is needed */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Collision", meta = (EditCondition = "bCoherentArmProbe", ClampMin = "0.0"))
+		float ArmProbeReuseDistance;
+
+	/* Degrees the arm may rotate from where the cached probe was taken before a full sweep is needed */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Collision", meta = (EditCondition = "bCoherentArmProbe", ClampMin = "0.0"))
+		float ArmProbeReuseAngle;
+
+	/* Frames a reused probe may age before an asynchronous refresh is issued, however still the arm holds */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Collision", meta = (EditCondition = "bCoherentArmProbe", ClampMin = "1"))
+		int32 ArmProbeRefreshFrames;
+
+	/* Fraction of the reuse distance and angle the arm may move before the reused probe is refreshed early */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Collision", meta = (EditCondition = "bCoherentArmProbe", ClampMin = "0.0", ClampMax = "1.0"))
+		float ArmProbeRefreshFraction;
+
+	/* Extra distance the server allows beyond the range break when validating a target the owning client locked on to */
+	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera|Network", meta = (ClampMin = "0.0"))
+		float NetTargetSlack;
+
+	/* Include this arm in the lock-on debug visualization, which is switched on with ds.LockOn.DrawDebug */
 	UPROPERTY(EditDefaultsOnly, Category = "Lock On Camera")
 		bool bDrawDebug;
 
-	/* True if lock was recently broken and mouse delta is still high */
+	/* True if soft-lock was broken and may not re-acquire until every candidate has left range. Set before breaking the
+	* lock, so the owning client sends it to the server with the break */
 	bool bSoftlockRequiresReset;
 
 	/* The component the camera is currently locked on to */
 	UPROPERTY(BlueprintReadOnly)
-		class UDSTargetComponent* CameraTarget;
+		USceneComponent* CameraTarget;
 
 	UDSLockArmComponent();
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	/* Applies the result of the lock-on manager's batched update for this arm */
+	void ApplyLockAction(DSLockOnCore::ELockAction Action, USceneComponent* NewCameraTarget);
+
 	void ToggleCameraLock();
 	void ToggleSoftLock();
-	void LockToTarget(UDSTargetComponent* NewTargetComponent);
+	void LockToTarget(USceneComponent* NewTargetComponent);
 	void BreakTargetLock();
-	class UDSTargetComponent* GetLockTarget();
+	/* Best target to lock on to, or null. Also null if the best has no line of sight result yet, in which case it is
+	* traced and the lock retried on the next logic update */
+	USceneComponent* GetLockTarget();
+
+	/* Switches to the next target to one side. Like GetLockTarget, waits for a trace to a neighbour not traced yet */
 	void SwitchTarget(EDirection SwitchDirection);
-	TArray<class UDSTargetComponent*> GetTargetComponents();
+	TArray<USceneComponent*> GetTargetComponents();
+
+	/* Gathers targets within lock-on range into OutCandidates, replacing its contents, with positions packed for batched scoring */
+	void GatherCandidates(FDSCandidateSet& OutCandidates);
+
+	/* Issues asynchronous line of sight traces to the candidates and the current target whose results have expired */
+	void QueueLineOfSightTraces(const FDSCandidateSet& Candidates);
+
+	/* View-projection matrix of the camera attached to this arm. False if no camera is attached */
+	bool GetCameraViewProjection(FMatrix& OutViewProjection);
+
+	/* True if the locked target has been occluded for longer than OcclusionBreakDelay */
+	bool HasLostSightOfTarget() const;
+
+	/* Lock frame for the current frame, computed on first use. The lock-on manager refreshes it after each batched lock update */
+	const FDSLockFrame& GetLockFrame();
 
 	/* True if the camera is currently locked to a target */
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Lock On Camera")
 		bool IsCameraLockedToTarget();
+
+	/* True if this machine runs the arm's lock logic: on the server, and on the owning client as a prediction. Simulated proxies only follow replication */
+	bool RunsLockLogic() const;
+
+protected:
+	/* Lock state the server last accepted, replicated to every client */
+	UPROPERTY(ReplicatedUsing = OnRep_LockState)
+		FDSLockOnRepState ReplicatedLockState;
+
+	UFUNCTION()
+		void OnRep_LockState();
+
+	/* Owning client's predicted lock, switch, break or soft-lock toggle. The server validates it and replicates the result */
+	UFUNCTION(Server, Reliable, WithValidation)
+		void ServerSetLockState(USceneComponent* NewTarget, bool bNewUseSoftLock, bool bNewSoftlockRequiresReset, uint8 Sequence);
+
+	virtual void UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime) override;
+
+private:
+	/* Arm state at the last idle soft-lock evaluation. Soft-lock is only re-evaluated once something here changes */
+	struct FSoftLockShell
+	{
+		FVector Origin;
+		FVector Forward;
+		float NextFallbackTime;
+		bool bRequiresReset;
+
+		/* The evaluation passed over occluded candidates, whose line of sight is refreshed while the shell holds */
+		bool bOccludedCandidates;
+		bool bValid;
+	};
+
+	FSoftLockShell SoftLockShell;
+
+	/* Candidate storage reused by every query this arm makes, so steady-state queries don't allocate */
+	FDSCandidateSet CandidateScratch;
+
+	/* Targets in range sorted by bearing, maintained by the lock logic update and read by SwitchTarget */
+	FDSCandidateRing CandidateRing;
+
+	/* Line of sight results per target, refreshed by asynchronous traces */
+	FDSLineOfSightCache LineOfSight;
+
+	/* Completion delegate shared by every line of sight trace this arm issues */
+	FTraceDelegate LineOfSightDelegate;
+
+	/* World time the locked target was first seen occluded, negative while it is visible */
+	float TargetOccludedTime;
+
+	/* Lock or switch requested while the target it would pick was waiting on its first line of sight trace */
+	enum class EDeferredLock : uint8
+	{
+		None,
+		Lock,
+		SwitchLeft,
+		SwitchRight,
+	};
+
+	EDeferredLock DeferredLock;
+
+	/* Runs a deferred lock or switch again. Called by the lock-on manager on the arm's next logic update */
+	void RetryDeferredLock();
+
+	/* Issues one line of sight trace to Target if its cached result has expired */
+	void QueueLineOfSightTrace(const USceneComponent* Target, float Now);
+
+	/* Called the frame after a line of sight trace was issued */
+	void OnLineOfSightTrace(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	/* Last camera collision probe, kept as the unobstructed fraction of the arm so it follows the arm as it orbits */
+	struct FArmProbe
+	{
+		/* Pivot, rotation and length of the arm the probe was taken for */
+		FVector Origin;
+		FQuat Rotation;
+		float ArmLength;
+		float Fraction;
+		bool bValid;
+
+		/* Frame the arm pose of the probe was sampled on */
+		uint64 FrameNumber;
+
+		/* Refresh sweep in flight, and the arm and frame it was issued for */
+		FTraceHandle PendingSweep;
+		FQuat PendingRotation;
+		float PendingArmLength;
+		uint64 PendingFrameNumber;
+	};
+
+	FArmProbe ArmProbe;
+
+	/* Completion delegate for the asynchronous arm probe refresh */
+	FTraceDelegate ArmProbeDelegate;
+
+	/* Called the frame after an arm probe refresh was issued */
+	void OnArmProbeSweep(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	FDSLockFrame LockFrame;
+
+	/* Motion estimate for the locked target, restarted whenever the target changes */
+	DSLockOnCore::FTargetTracker TargetTracker;
+	bool bTrackerValid;
+
+	/* Frame LockFrame was computed on. Reset whenever the target changes */
+	uint64 LockFrameNumber;
+
+	/* Time accumulated towards the next lock logic update */
+	float LockLogicAccumulator;
+
+	/* Returns the lock logic rate for the arm's current state */
+	float GetLockLogicRate();
+
+	/* Scoring curves baked into lookup tables on BeginPlay, and again in the editor whenever one of the curves changes */
+	DSLockOnCore::FScoringTables ScoringTables;
+
+	/* Targets this arm locked on to recently, for the recency curve */
+	FDSRecentTargets RecentTargets;
+
+	void BakeScoringTables();
+
+	/* Scoring tables for the lock update, or null to pick by facing alone */
+	const DSLockOnCore::FScoringTables* GetScoringTables() const { return bUseScoringCurves ? &ScoringTables : nullptr; }
+
+#if WITH_EDITOR
+	FDelegateHandle CurveChangedHandle;
+
+	/* Rebakes the scoring tables when one of the curves is edited */
+	void OnObjectPropertyChanged(UObject* Object, struct FPropertyChangedEvent& Event);
+#endif
+
+	/* Publishes a local lock state change: replicated on the server, sent to the server as a prediction on the owning client */
+	void OnLockStateChanged();
+
+	/* Sequence of the owning client's latest prediction. Replicated state acknowledging an older one is ignored */
+	uint8 PredictionSequence;
+
+	/* Set while applying a change that mustn't be sent to the server: the batched update's own results, or replicated state */
+	bool bSuppressLockRequests;
+
+	/* Stands in for the network between a client and a server arm */
+	friend class FDSLockOnNetSoftLockBreakTest;
+	friend class FDSLockOnNetRejectTargetTest;
 };
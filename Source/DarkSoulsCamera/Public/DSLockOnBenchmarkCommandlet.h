@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DSLockOnBenchmarkCommandlet.generated.h"
+
+class ADSCharacter;
+
+/**
+* Headless lock-on benchmark. For each target count it builds a world with a grid of moving targets and a number of
+* characters fed scripted turn and lock input, then writes per-frame lock-on game thread time percentiles to JSON.
+* Usage: DarkSoulsCamera -run=DSLockOnBenchmark [-Targets=100,1000,10000] [-Characters=8] [-Frames=600] [-WarmupFrames=60]
+*        [-DeltaSeconds=0.016667] [-Spacing=300] [-PathRadius=150] [-PointsPerTarget=0] [-CharacterSpread=0] [-QueryCacheCellSize=] [-Map=] [-Output=Saved/Benchmarks/DSLockOnBenchmark.json]
+*        [-BudgetP95Ms=] -nullrhi
+* -PointsPerTarget=N gives each target actor N DSTargetPointComponents instead of one DSTargetComponent.
+* -CharacterSpread packs the characters closer together, and -QueryCacheCellSize sets ds.LockOn.QueryCacheCellSize,
+* to compare the query cache hit rate and lock-on time between cell sizes.
+* Returns non-zero if any scenario's p95 exceeds BudgetP95Ms.
+* With -Mode=Tracking it instead locks a character onto a target following scripted trajectories and writes the angular
+* tracking error with and without predictive tracking (default output Saved/Benchmarks/DSLockOnTracking.json).
+* With -Mode=Spring it steps the lock-on rotation springs along a scripted target switch at 30, 60, 144 and 240 fps,
+* checks every trajectory against the closed form, then times steering -Pawns=1000 pawns with RInterpTo and with the
+* scalar and vector spring kernels (default output Saved/Benchmarks/DSLockOnSpring.json). Returns non-zero if the
+* trajectories differ by more than 0.01 degrees.
+*/
+UCLASS()
+class DARKSOULSCAMERA_API UDSLockOnBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDSLockOnBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	/* Feeds one frame of scripted input to a character, the same way its input bindings would */
+	static void DriveCharacter(ADSCharacter* Character, int32 CharacterIndex, int32 Frame, float DeltaSeconds);
+};
@@ -0,0 +1,301 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/* The 4-wide kernels are built with SSE2 intrinsics wherever the target guarantees them, in the engine or out */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DS_LOCKON_SSE 1
+#else
+#define DS_LOCKON_SSE 0
+#endif
+
+/**
+* Engine-independent lock-on selection logic.
+* Plain C++ with no Unreal includes, so it can be compiled and profiled outside the editor with a stock toolchain.
+* The Unreal components gather positions and apply the results; every decision is made here.
+*/
+namespace DSLockOnCore
+{
+	struct FVec3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	/**
+	* Narrow-phase range filter. Tests each of the NumIndices targets referenced by Indices against the sphere at
+	* Origin, treating each target as a sphere of its own radius. Writes survivors to OutIndices and returns their count.
+	* OutIndices may alias Indices.
+	*/
+	int FilterInRange(const float* X, const float* Y, const float* Z, const float* Radius, const int* Indices, int NumIndices, const FVec3& Origin, float QueryRadius, int* OutIndices);
+
+	/**
+	* Scalar candidate scoring. For each candidate writes the dot product of its normalized direction from Origin with
+	* Reference, the Z component of Cross(Reference, Direction) and its distance from Origin.
+	*/
+	void ScoreCandidates(const float* X, const float* Y, const float* Z, int Num, const FVec3& Origin, const FVec3& Reference, float* OutDot, float* OutSide, float* OutDistance);
+
+	/**
+	* Scalar screen projection. Transforms each position by ViewProjection, a row-major 4x4 matrix applied to row vectors
+	* as FMatrix is, and writes its normalized device coordinates and clip W. Points behind the camera get W <= 0.
+	*/
+	void ProjectCandidates(const float* X, const float* Y, const float* Z, int Num, const float* ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW);
+
+#if DS_LOCKON_SSE
+	/**
+	* 4-wide versions of ScoreCandidates and ProjectCandidates, which the engine's batched scoring runs. Each takes the
+	* candidates in whole groups of four and returns how many it took, leaving the rest to the scalar kernel. Results
+	* match the scalar kernels', degenerate and unit directions included, up to the rounding of the reciprocal square root.
+	*/
+	int ScoreCandidates4(const float* X, const float* Y, const float* Z, int Num, const FVec3& Origin, const FVec3& Reference, float* OutDot, float* OutSide, float* OutDistance);
+	int ProjectCandidates4(const float* X, const float* Y, const float* Z, int Num, const float* ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW);
+#endif
+
+	/**
+	* Screen-space score of a projected point: 1 at the center of the screen, falling to 0 at the corners. Returns -1 for
+	* points behind the camera or outside the screen inset by Margin, a fraction of the half-screen.
+	*/
+	float ScoreScreenPosition(float NDCX, float NDCY, float W, float Margin);
+
+	/* Index of the candidate with the highest positive dot product, or -1 if none are in front of the reference */
+	int SelectLockTarget(const float* Dot, int Num);
+
+	/* As above, but ranks candidates in front of the reference by Dot plus Priority */
+	int SelectLockTarget(const float* Dot, const float* Priority, int Num);
+
+	/**
+	* Index of the candidate on the requested side (negative Side is left, positive is right) with the highest dot
+	* product, skipping ExcludeIndex. Returns -1 if no candidate is on that side.
+	*/
+	int SelectSwitchTarget(const float* Dot, const float* Side, int Num, int ExcludeIndex, bool bRight);
+
+	/**
+	* Scoring curve baked into a fixed-size table over [Min, Max]. Lookups clamp to the range and interpolate linearly
+	* between samples, so a lookup costs the same however many keys the source curve had.
+	*/
+	struct FScoreTable
+	{
+		enum { NumSamples = 64 };
+
+		float Min;
+		/* (NumSamples - 1) / (Max - Min) */
+		float SampleScale;
+		float Samples[NumSamples];
+	};
+
+	/* Fills Table with Evaluate(X) at NumSamples evenly spaced points from Min to Max */
+	template<typename FunctionType>
+	void BakeScoreTable(FScoreTable& Table, float Min, float Max, FunctionType Evaluate)
+	{
+		const float Step = (Max - Min) / (FScoreTable::NumSamples - 1);
+		Table.Min = Min;
+		Table.SampleScale = Step > 0.f ? 1.f / Step : 0.f;
+		for (int i = 0; i < FScoreTable::NumSamples; i++)
+			Table.Samples[i] = Evaluate(Min + Step * i);
+	}
+
+	inline float LookupScore(const FScoreTable& Table, float Value)
+	{
+		float Position = (Value - Table.Min) * Table.SampleScale;
+		Position = Position > 0.f ? Position : 0.f;
+		Position = Position < FScoreTable::NumSamples - 1.f ? Position : FScoreTable::NumSamples - 1.f;
+
+		const int Index = (int)Position < FScoreTable::NumSamples - 1 ? (int)Position : FScoreTable::NumSamples - 2;
+		return Table.Samples[Index] + (Table.Samples[Index + 1] - Table.Samples[Index]) * (Position - Index);
+	}
+
+	/* Weighted lock target scoring. Each term is a table lookup scaled by its weight. A zero weight skips its table */
+	struct FScoringTables
+	{
+		/* Indexed by sin(Angle / 2), 0 facing the reference and 1 directly behind, which keeps resolution near the center */
+		FScoreTable Angle;
+		/* Indexed by distance as a fraction of the lock distance */
+		FScoreTable Distance;
+		FScoreTable Threat;
+		/* Indexed by seconds since the arm last locked on to the candidate */
+		FScoreTable Recency;
+
+		float AngleWeight;
+		float DistanceWeight;
+		float ThreatWeight;
+		float RecencyWeight;
+	};
+
+	/* Batched table scoring. Writes the weighted sum of every term plus Priority to OutScore, one per candidate */
+	void ScoreWithTables(const FScoringTables& Tables, const float* Dot, const float* Distance, const float* Threat, const float* SinceTargeted,
+		const float* Priority, int Num, float MaxDistance, float* OutScore);
+
+	/* Index of the candidate in front of the reference (positive Dot) with the highest Score, or -1 if none are */
+	int SelectByScore(const float* Dot, const float* Score, int Num);
+
+	/* True once a locked target is further than the lock distance plus hysteresis, measured to the target's surface */
+	inline bool IsOutOfRange(float Distance, float TargetRadius, float MaxLockDistance, float Hysteresis)
+	{
+		return Distance > MaxLockDistance + TargetRadius + Hysteresis;
+	}
+
+	/* True once a locked target has been continuously occluded for at least BreakDelay seconds */
+	inline bool HasLostSight(float OccludedSeconds, float BreakDelay)
+	{
+		return OccludedSeconds >= BreakDelay;
+	}
+
+	/* Lock state of an arm at the start of a logic update */
+	struct FLockState
+	{
+		bool bLocked;
+		bool bOutOfRange;
+		/* Locked target has been out of sight for longer than the occlusion break delay */
+		bool bLostSight;
+		bool bUseSoftLock;
+		bool bSoftlockRequiresReset;
+	};
+
+	enum class ELockAction : unsigned char
+	{
+		None,
+		/* Lock on to the best candidate */
+		LockToCandidate,
+		/* Drop the current target */
+		Break,
+		/* No candidate in range, so a forcibly broken soft-lock may re-acquire */
+		ClearSoftlockReset,
+	};
+
+	/* True if UpdateLockState needs to know whether a lock candidate exists. Lets callers skip the query otherwise */
+	bool NeedsLockCandidate(const FLockState& State);
+
+	/* Soft-lock state machine. bHasCandidate is only read when NeedsLockCandidate returned true */
+	ELockAction UpdateLockState(const FLockState& State, bool bHasCandidate);
+
+	/* Alpha-beta-gamma filter state estimating a target's motion from its position history */
+	struct FTargetTracker
+	{
+		FVec3 Position;
+		FVec3 Velocity;
+		FVec3 Acceleration;
+
+		/* Distance between the last measurement and the filter's prediction for it */
+		float Residual;
+	};
+
+	struct FTrackerConfig
+	{
+		/* Position, velocity and acceleration gains. Higher values follow measurements more closely but pass on more noise */
+		float Alpha;
+		float Beta;
+		float Gamma;
+
+		/* Longest lead the prediction may add to the measured position */
+		float MaxLeadDistance;
+
+		/* Residual at which the lead is dropped entirely. The lead fades out linearly up to it, so a target changing direction isn't overshot */
+		float OvershootTolerance;
+	};
+
+	/* Restarts tracking at Position with no motion */
+	void ResetTracker(FTargetTracker& Tracker, const FVec3& Position);
+
+	/* Folds a new position measurement, taken DeltaSeconds after the previous one, into the estimate */
+	void UpdateTracker(FTargetTracker& Tracker, const FTrackerConfig& Config, const FVec3& Measured, float DeltaSeconds);
+
+	/* Where the target is expected to be LeadSeconds after Measured was taken, with the lead clamped as configured */
+	FVec3 PredictTarget(const FTargetTracker& Tracker, const FTrackerConfig& Config, const FVec3& Measured, float LeadSeconds);
+
+	/**
+	* Critically damped rotation springs, one per pawn, as structure of arrays. Rotations are unit quaternions in world
+	* space. Velocities are the rate of change of the rotation from the target as an axis scaled by an angle, in radians
+	* per second. Frequency is the spring's natural frequency in radians per second. Higher values settle faster.
+	*/
+	struct FRotationSprings
+	{
+		float* QX;
+		float* QY;
+		float* QZ;
+		float* QW;
+		float* VX;
+		float* VY;
+		float* VZ;
+		const float* TX;
+		const float* TY;
+		const float* TZ;
+		const float* TW;
+		const float* Frequency;
+		int Num;
+	};
+
+	/**
+	* Below this, in radians, a spring's error or step is too small to take an axis from and the rotation maps use their
+	* small-angle limits. Shared by every implementation of StepRotationSprings so they all settle at the same point.
+	*/
+	const float SpringSmallAngle = 1.e-4f;
+
+	/**
+	* Advances every spring DeltaSeconds towards its target rotation with the exact solution of the spring equation on
+	* the rotation between them. Any step is stable, however long, and while the target holds still the result doesn't
+	* depend on how the time is split into steps. A spring resting on its target stays there.
+	*/
+	void StepRotationSprings(const FRotationSprings& Springs, float DeltaSeconds);
+
+	/* Seconds a settled spring of natural Frequency trails a target turning at a constant rate by. Zero for a spring that doesn't move */
+	inline float GetSpringLagSeconds(float Frequency)
+	{
+		return Frequency > 0.f ? 2.f / Frequency : 0.f;
+	}
+
+	/* Lock gestures recognised from timestamped turn input */
+	enum class ELockGesture : unsigned char
+	{
+		None,
+		SwitchLeft,
+		SwitchRight,
+		/* Harsh mouse movement that breaks soft-lock */
+		BreakLock,
+	};
+
+	struct FGestureConfig
+	{
+		/* Mouse turn delta, summed over MouseWindowSeconds, that switches target or breaks soft-lock */
+		float SwitchMouseDelta;
+		float BreakMouseDelta;
+
+		/* Stick deflection that switches target, and below which the stick has settled */
+		float SwitchStickValue;
+		float SettleStickValue;
+
+		/* Mouse deltas are summed over this window, the frame time the per-frame mouse thresholds were tuned at */
+		double MouseWindowSeconds;
+
+		/* Cooldown between mouse switches, so one movement only switches once */
+		double SwitchMinDelaySeconds;
+
+		/* Scale from raw mouse deltas to the turn axis units the mouse thresholds are in, i.e. the MouseX axis sensitivity */
+		float MouseTurnScale;
+	};
+
+	/* Gesture detector state. Times are in the same clock as the input event timestamps */
+	struct FGestureState
+	{
+		/* Time of the last switch from either the mouse or the stick */
+		double LastSwitchTime;
+
+		/* Mouse input before this time was already used by a gesture */
+		double MouseWindowStart;
+
+		/* Stick returned to centre since the last stick switch */
+		bool bStickSettled;
+	};
+
+	/* Start of the window to sum mouse deltas over for an event at Time */
+	inline double GetMouseWindowStart(const FGestureState& State, const FGestureConfig& Config, double Time)
+	{
+		return Time - Config.MouseWindowSeconds > State.MouseWindowStart ? Time - Config.MouseWindowSeconds : State.MouseWindowStart;
+	}
+
+	/* Classifies a mouse event at Time, given the raw mouse delta summed over its window. Only soft-lock can be broken */
+	ELockGesture DetectMouseGesture(FGestureState& State, const FGestureConfig& Config, double Time, float WindowDelta, bool bLocked, bool bSoftLock);
+
+	/* Classifies a stick sample at Time. A switch needs the stick to have settled since the last one, and restarts the mouse switch cooldown */
+	ELockGesture DetectStickGesture(FGestureState& State, const FGestureConfig& Config, double Time, float Value, bool bLocked);
+}
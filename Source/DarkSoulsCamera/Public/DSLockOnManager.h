@@ -0,0 +1,326 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "DSTargetGrid.h"
+#include "DSLockOnScoring.h"
+#include "DSLockOnCore.h"
+#include "Components/LineBatchComponent.h"
+#include "DSLockOnManager.generated.h"
+
+/* Lock-on debug visualization, controlled by ds.LockOn.DrawDebug. Compiled out of shipping and test builds */
+#define DS_LOCKON_DEBUG_DRAW (!(UE_BUILD_SHIPPING || UE_BUILD_TEST))
+
+class UDSTargetComponent;
+class UDSTargetPointComponent;
+class UDSLockArmComponent;
+struct FDSLineOfSightCache;
+struct FDSCandidateRing;
+class FDSLockOnRecorder;
+
+/* Per-arm inputs and results of the batched lock update. Inputs are gathered and results applied on the game thread */
+struct FDSLockArmUpdate
+{
+	FVector Origin;
+	FVector Forward;
+	const AActor* IgnoreActor;
+	int32 IgnoreTeam;
+	float MaxTargetLockDistance;
+	DSLockOnCore::FLockState LockState;
+
+	/* Arm's line of sight results, used to drop occluded candidates. Null if the arm doesn't check line of sight */
+	const FDSLineOfSightCache* LineOfSight;
+
+	/* Camera view-projection for the screen-space pre-pass, valid if bScreenSpace */
+	FMatrix ViewProjection;
+	float ScreenMargin;
+	bool bScreenSpace;
+
+	/* Arm's baked scoring curves and lock history, or null to pick by facing alone */
+	const DSLockOnCore::FScoringTables* ScoringTables;
+	const FDSRecentTargets* RecentTargets;
+	float WorldTime;
+
+	/* Arm's switching order, refreshed from the candidates. Each update writes only its own arm's ring */
+	FDSCandidateRing* CandidateRing;
+	float SwitchOrderTolerance;
+
+	/* Query cache entry shared with other arms in the same cell, or INDEX_NONE to query alone */
+	int32 QueryCacheEntry;
+
+	/* True if the arm isn't due a logic update, or nothing in its range shell changed since its last soft-lock evaluation */
+	bool bSkip;
+
+	/* Set on an idle soft-lock arm skipped while its last candidates include occluded ones. Their line of sight is still
+	refreshed, so one coming into view counts as an event */
+	bool bRefreshLineOfSight;
+
+	/* Set by the update if line of sight kept any candidate from being picked */
+	bool bOccludedCandidates;
+
+	/* Set by the update if the best candidate has no line of sight result yet. Its trace is queued and the lock action
+	waits for the next logic update rather than risk picking a target behind a wall */
+	bool bAwaitingTrace;
+
+	DSLockOnCore::ELockAction Action;
+	USceneComponent* NewTarget;
+};
+
+/**
+* Per-world registry for the camera lock-on system.
+* Every DSTargetComponent and DSTargetPointComponent registers itself here on BeginPlay, and is added from a queue
+* within a per-frame time budget so levels streaming in many targets don't hitch. Target positions are
+* cached once per frame in flat arrays. Targets are grouped by owning actor, and each group's bounding sphere is
+* bucketed in a uniform grid, so lock arms can gather candidates without running a physics overlap query or
+* scanning every target in the world, and an actor's lock points are culled together before any is tested alone.
+* Lock arms register here too. Their acquisition, range-break and soft-lock updates run as one batch per frame,
+* spread across worker threads and reading a snapshot of the target positions. Each arm's logic runs at its own
+* fixed rate, decoupled from the frame rate. Idle soft-lock arms are only
+* re-evaluated when a target enters, leaves or moves within the grid cells covering their range.
+* The control rotation of every locally controlled pawn that is locked on is then steered towards its target by one
+* batched pass over packed critically damped quaternion springs, one per arm.
+* Line of sight to each arm's candidates is checked with asynchronous traces issued after the batch, so results
+* are read from the arm's cache on a later update and the game thread never waits on physics.
+*/
+UCLASS(NotPlaceable, Transient, config=Game)
+class DARKSOULSCAMERA_API ADSLockOnManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	ADSLockOnManager();
+
+	/* Returns the lock-on manager for World, spawning one if the world doesn't have one yet */
+	static ADSLockOnManager* Get(UWorld* World);
+
+	/* Returns the lock-on manager for World if one exists */
+	static ADSLockOnManager* Find(UWorld* World);
+
+	virtual void PostInitializeComponents() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Targets are queued and added over the following frames, within ds.LockOn.RegistrationBudgetMs per frame */
+	void RegisterTarget(UDSTargetComponent* Target);
+	void RegisterTarget(UDSTargetPointComponent* Target);
+	void UnregisterTarget(UDSTargetComponent* Target);
+	void UnregisterTarget(UDSTargetPointComponent* Target);
+
+	/* Adds queued targets, creating their deferred physics states, until BudgetMs has passed. Always adds at least one,
+	and 0 empties the queue. Returns the number taken off the queue */
+	int32 ProcessRegistrationQueue(float BudgetMs);
+
+	/* Number of entries in the registration queue, including targets unregistered while queued that haven't been dropped yet */
+	int32 GetNumPendingTargets() const { return PendingTargets.Num(); }
+
+	/* LockOnIndex of a target waiting in the registration queue */
+	static const int32 PendingLockOnIndex = -2;
+
+	void RegisterLockArm(UDSLockArmComponent* LockArm);
+	void UnregisterLockArm(UDSLockArmComponent* LockArm);
+
+	/* Appends every target overlapping the sphere at Origin, ignoring targets owned by IgnoreActor or on IgnoreTeam. Team 0 ignores nothing */
+	void GetTargetsInRadius(const FVector& Origin, float Radius, const AActor* IgnoreActor, TArray<USceneComponent*>& OutTargets, int32 IgnoreTeam = 0);
+
+	/* As GetTargetsInRadius, but also copies each target's cached position into the candidate set for batched scoring */
+	void GatherCandidates(const FVector& Origin, float Radius, const AActor* IgnoreActor, FDSCandidateSet& OutCandidates, int32 IgnoreTeam = 0);
+
+	/* Number of registered targets */
+	int32 GetNumTargets() const { return Targets.Num(); }
+
+	/* Number of actors with registered targets */
+	int32 GetNumTargetGroups() const { return GroupOwners.Num(); }
+
+	/* Lock-on radius of a target component of either type */
+	static float GetTargetRadius(const USceneComponent* Target);
+
+	/* Team of a target component of either type, 0 for any other component */
+	static int32 GetTargetTeam(const USceneComponent* Target);
+
+	/* Starts streaming this world's lock-on session to Filename, replacing any recording in progress. Does nothing in shipping builds */
+	bool StartRecording(const FString& Filename);
+	void StopRecording();
+
+	/* Recording in progress, if any */
+	FDSLockOnRecorder* GetRecorder() const { return Recorder.Get(); }
+
+	/* Edge length of the target grid cells. Should be in the region of the typical lock-on distance */
+	UPROPERTY(Config)
+	float TargetGridCellSize;
+
+private:
+	friend class FDSLockOnRecorder;
+
+	/* Queues Target, or adds it straight away if registration isn't time-sliced */
+	void QueueTarget(USceneComponent* Target, int32& LockOnIndex);
+
+	/* Adds a target of either type with its registration settings, and releases its deferred physics state. Returns its group */
+	int32 InsertTarget(USceneComponent* Target);
+
+	/* Registration shared by both target component types. LockOnIndex is the component's slot. Returns the target's group,
+	whose bounds are left for the caller to update, or INDEX_NONE if the target was already registered */
+	int32 AddTarget(USceneComponent* Target, int32& LockOnIndex, float Radius, int32 Team, float Priority, float Threat);
+	void RemoveTarget(USceneComponent* Target, int32& LockOnIndex);
+
+	/* Slot of a target component of either type */
+	static int32* GetLockOnIndex(USceneComponent* Target);
+
+	/* Recomputes the bounding sphere of a group's targets and moves it in the grid */
+	void UpdateGroupBounds(int32 Group);
+	void RemoveGroup(int32 Group);
+
+	/* Refresh cached target positions, at most once per frame */
+	void UpdateTargetPositions();
+
+	/* Fills OutIndices with the registered targets overlapping the sphere at Origin. OutGroups is scratch for the broad
+	phase, kept by the caller so it doesn't allocate once grown. Safe to call from worker threads */
+	void QueryTargets(const FVector& Origin, float Radius, const AActor* IgnoreActor, int32 IgnoreTeam, TArray<int32>& OutIndices, TArray<int32>& OutGroups) const;
+
+	/* Appends every target of the groups overlapping the sphere at Origin, without testing the targets themselves. OutGroups is scratch as above */
+	void QueryGroupTargets(const FVector& Origin, float Radius, TArray<int32>& OutIndices, TArray<int32>& OutGroups) const;
+
+	/* Fills OutIndices with the targets in SharedIndices overlapping the sphere at Origin, as QueryTargets would. Safe to call from worker threads */
+	void FilterSharedQuery(const TArray<int32>& SharedIndices, const FVector& Origin, float Radius, const AActor* IgnoreActor, int32 IgnoreTeam, TArray<int32>& OutIndices) const;
+
+	/* Groups this frame's querying arms by cell and range, and runs one broad phase for each group of more than one arm */
+	void BuildQueryCache(int32 NumArms);
+
+	/* Runs the lock update for every registered arm that is due one */
+	void UpdateLockArms(float DeltaSeconds);
+
+	/* Steps the rotation springs of every locked, locally controlled pawn and applies them to its control rotation */
+	void UpdateRotationSprings(float DeltaSeconds);
+
+	/* True if any target entered, left or moved within the cells overlapping the sphere since the last lock update */
+	bool HasEventsInShell(const FVector& Origin, float Radius) const;
+
+	/* Records a target event in Cell for idle soft-lock arms to pick up */
+	void MarkCellDirty(const FIntVector& Cell) { DirtyCells.Add(Cell); }
+
+	/* Lock update for a single arm against the current position snapshot. Safe to call from worker threads */
+	void EvaluateLockArm(FDSLockArmUpdate& Update, TArray<int32>& Indices, TArray<int32>& Groups, FDSCandidateSet& Candidates) const;
+
+	/* Draws every arm's range, candidates and locked target as one line batch, reusing the candidates of the batched update */
+	void DrawDebug();
+
+	/* Targets waiting to be added, oldest first. A target unregistered while queued stays in place, no longer marked
+	pending, and is dropped when the queue reaches it */
+	UPROPERTY(Transient)
+	TArray<USceneComponent*> PendingTargets;
+
+	/* Groups a registration pass added targets to, so each group's bounds are rebuilt once per pass */
+	TArray<int32> RegisteredGroups;
+
+	/* Registered targets, indexed alongside the position arrays below */
+	UPROPERTY(Transient)
+	TArray<USceneComponent*> Targets;
+
+	/* Cached target positions and radii, one entry per registered target */
+	TArray<float> TargetX;
+	TArray<float> TargetY;
+	TArray<float> TargetZ;
+	TArray<float> TargetRadius;
+
+	/* Per-target attributes read on registration, and the group each target belongs to */
+	TArray<int32> TargetTeam;
+	TArray<float> TargetPriority;
+	TArray<float> TargetThreat;
+	TArray<int32> TargetGroup;
+
+	/* Targets grouped by owning actor, indexed alongside the group bounds below */
+	TArray<const AActor*> GroupOwners;
+	TArray<TArray<int32>> GroupTargets;
+	TMap<const AActor*, int32> GroupIndices;
+
+	/* Bounding sphere of each group's targets, radii included */
+	TArray<float> GroupX;
+	TArray<float> GroupY;
+	TArray<float> GroupZ;
+	TArray<float> GroupRadius;
+
+	/* Groups with a target that moved or resized this frame */
+	TBitArray<> GroupsChanged;
+
+	/* Largest group radius, used to pad grid queries */
+	float MaxGroupRadius;
+
+	/* Spatial index over the group bounds */
+	FDSTargetGrid TargetGrid;
+
+	/* Cells a target entered, left or moved within since the last lock update */
+	TSet<FIntVector> DirtyCells;
+
+	/* Set when every cell must be treated as dirty, e.g. when the query padding changed */
+	bool bAllCellsDirty;
+
+	/* Scratch storage for grid query results on the game thread */
+	TArray<int32> QueryIndices;
+	TArray<int32> QueryGroups;
+
+	/* Arms querying from the same query cell with the same quantized range share one broad phase */
+	struct FQueryCacheKey
+	{
+		FIntVector Cell;
+		int32 Range;
+
+		bool operator==(const FQueryCacheKey& Other) const { return Cell == Other.Cell && Range == Other.Range; }
+		friend uint32 GetTypeHash(const FQueryCacheKey& Key) { return HashCombine(GetTypeHash(Key.Cell), GetTypeHash(Key.Range)); }
+	};
+
+	/* Targets of every group overlapping the padded sphere around a cell, shared by the arms querying from it this frame */
+	struct FQueryCacheEntry
+	{
+		FVector Center;
+		float Radius;
+		int32 NumArms;
+		TArray<int32> Indices;
+		TArray<int32> Groups;
+	};
+
+	/* Query cache for the current lock update. Entries past NumQueryCacheEntries are stale and kept to reuse their allocations */
+	TMap<FQueryCacheKey, int32> QueryCacheKeys;
+	TArray<FQueryCacheEntry> QueryCache;
+	int32 NumQueryCacheEntries;
+
+	/* Registered lock arms, updated together each frame */
+	UPROPERTY(Transient)
+	TArray<UDSLockArmComponent*> LockArms;
+
+	/* Per-arm batch state and scratch storage, indexed alongside LockArms and kept between frames to reuse allocations */
+	TArray<FDSLockArmUpdate> LockArmUpdates;
+	TArray<TArray<int32>> LockArmIndices;
+	TArray<TArray<int32>> LockArmGroups;
+	TArray<FDSCandidateSet> LockArmCandidates;
+
+	/* Control rotation spring of each arm's pawn, indexed alongside LockArms. Rotations persist between frames, targets
+	and frequencies are written each frame. Springs of arms that aren't steering rest on their own rotation */
+	TArray<float> SpringQX;
+	TArray<float> SpringQY;
+	TArray<float> SpringQZ;
+	TArray<float> SpringQW;
+	TArray<float> SpringVX;
+	TArray<float> SpringVY;
+	TArray<float> SpringVZ;
+	TArray<float> SpringTX;
+	TArray<float> SpringTY;
+	TArray<float> SpringTZ;
+	TArray<float> SpringTW;
+	TArray<float> SpringFrequency;
+
+	/* Arms whose spring steered their pawn last frame */
+	TBitArray<> SpringsActive;
+
+	/* Debug lines for the current frame, kept between frames to reuse the allocation */
+	TArray<FBatchedLine> DebugLines;
+
+	/* Recording in progress, written once per batched lock update */
+	TSharedPtr<FDSLockOnRecorder> Recorder;
+
+	/* Frame the cached positions were last refreshed on */
+	uint64 LastUpdateFrame;
+
+	/* Manager for each world currently playing */
+	static TMap<TWeakObjectPtr<UWorld>, TWeakObjectPtr<ADSLockOnManager>> WorldManagers;
+};
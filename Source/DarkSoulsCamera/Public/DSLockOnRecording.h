@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class USceneComponent;
+class UDSLockArmComponent;
+class ADSLockOnManager;
+
+/**
+* Lock-on session recordings.
+* A recording is a stream of length-prefixed frames. Each frame holds the target changes since the previous frame,
+* the inputs and results of every lock arm's batched update, and the pawn inputs received that frame. Positions are
+* stored as the difference between the bit patterns of consecutive floats, so they are lossless but a target that
+* barely moved takes a byte or two per axis. Targets that didn't change aren't written at all.
+* DSLockOnReplay replays a recording through the lock-on core without a world.
+*/
+
+/* Recording is compiled out of shipping builds. Replaying works in every build */
+#define DS_LOCKON_RECORDING (!UE_BUILD_SHIPPING)
+
+/* Pawn inputs stored in recordings */
+enum class EDSLockOnInput : uint8
+{
+	Turn,
+	LookUp,
+	TurnAtRate,
+	LookUpAtRate,
+	ToggleCameraLock,
+	ToggleSoftLock,
+	Num
+};
+
+namespace DSLockOnRecording
+{
+	static const uint32 Magic = 0x524C5344;		// "DSLR"
+	static const uint32 Version = 3;
+
+	/* Per-arm flags */
+	enum EArmFlags : uint32
+	{
+		ArmSkipped = 1 << 0,
+		ArmLocked = 1 << 1,
+		ArmSoftLock = 1 << 2,
+		ArmSoftlockRequiresReset = 1 << 3,
+		ArmLostSight = 1 << 4,
+		ArmOutOfRange = 1 << 5,
+		ArmScreenSpace = 1 << 6,
+		ArmHasCandidates = 1 << 7,
+		/* Selection used the arm's baked scoring curves, which aren't recorded */
+		ArmScoringCurves = 1 << 8,
+	};
+
+	/* Appends variable-length and delta-coded values to a byte buffer */
+	struct DARKSOULSCAMERA_API FWriter
+	{
+		explicit FWriter(TArray<uint8>& InBytes) : Bytes(InBytes) {}
+
+		void WriteByte(uint8 Value) { Bytes.Add(Value); }
+		void WriteVarint(uint32 Value);
+		void WriteSigned(int32 Value);
+		void WriteFloat(float Value);
+
+		/* Writes Value as the zigzagged difference between its bits and Previous's. Lossless */
+		void WriteFloatDelta(float Value, float Previous);
+
+		TArray<uint8>& Bytes;
+	};
+
+	/* Reads values written by FWriter. Reading past the end sets bError and returns zeros */
+	struct DARKSOULSCAMERA_API FReader
+	{
+		FReader(const uint8* InData, int64 InSize) : Data(InData), Size(InSize), Offset(0), bError(false) {}
+
+		uint8 ReadByte();
+		uint32 ReadVarint();
+		int32 ReadSigned();
+		float ReadFloat();
+		float ReadFloatDelta(float Previous);
+
+		bool IsAtEnd() const { return Offset >= Size; }
+
+		const uint8* Data;
+		int64 Size;
+		int64 Offset;
+		bool bError;
+	};
+}
+
+#if DS_LOCKON_RECORDING
+
+/**
+* Streams a world's lock-on session to disk. Owned by the world's lock-on manager while recording.
+* Started and stopped with ds.LockOn.Record [File] and ds.LockOn.StopRecording.
+*/
+class DARKSOULSCAMERA_API FDSLockOnRecorder
+{
+public:
+	~FDSLockOnRecorder();
+
+	/* Opens Filename and writes the header. False if the file can't be created */
+	bool Open(const FString& Filename);
+	void Close();
+
+	const FString& GetFilename() const { return Filename; }
+
+	/* Buffers an input to Arm's pawn for the current frame, if Arm's world is being recorded */
+	static void RecordInput(const UDSLockArmComponent* Arm, EDSLockOnInput Input, float Value);
+
+	/* Writes one frame. Called by the manager between evaluating and applying the batched lock update */
+	void RecordFrame(const ADSLockOnManager& Manager, float DeltaSeconds, double UpdateMs);
+
+private:
+	struct FRecordedTarget
+	{
+		uint32 Id;
+		float X, Y, Z, Radius;
+		uint32 Frame;
+	};
+
+	struct FRecordedArm
+	{
+		uint32 Id;
+		FVector Origin;
+		FVector Forward;
+	};
+
+	struct FRecordedInput
+	{
+		uint32 ArmId;
+		EDSLockOnInput Input;
+		float Value;
+	};
+
+	uint32 GetArmId(const UDSLockArmComponent* Arm);
+	uint32 GetOwnerId(const AActor* Owner);
+
+	void WriteTargets(DSLockOnRecording::FWriter& Writer, const ADSLockOnManager& Manager);
+	void WriteArms(DSLockOnRecording::FWriter& Writer, const ADSLockOnManager& Manager);
+
+	FString Filename;
+	FArchive* Archive = nullptr;
+
+	/* Last written state of every live target, and the frame it was last seen on */
+	TMap<const USceneComponent*, FRecordedTarget> RecordedTargets;
+	TMap<const UDSLockArmComponent*, FRecordedArm> RecordedArms;
+	TMap<const AActor*, uint32> OwnerIds;
+	uint32 NextTargetId = 0;
+	uint32 NextArmId = 0;
+	uint32 NextOwnerId = 0;
+	uint32 FrameNumber = 0;
+
+	/* Inputs received since the last frame was written */
+	TArray<FRecordedInput> PendingInputs;
+
+	/* Scratch storage reused every frame */
+	TArray<uint8> FrameBytes;
+	TArray<int32> AddedTargets;
+	TArray<int32> MovedTargets;
+	TArray<uint32> RemovedTargets;
+
+	/* Number of open recorders in every world, so RecordInput costs nothing when none are */
+	static int32 NumOpen;
+};
+
+#define DS_LOCKON_RECORD_INPUT(Arm, Input, Value) FDSLockOnRecorder::RecordInput(Arm, EDSLockOnInput::Input, Value)
+
+#else
+
+#define DS_LOCKON_RECORD_INPUT(Arm, Input, Value)
+
+#endif
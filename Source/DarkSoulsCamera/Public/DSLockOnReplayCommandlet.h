@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DSLockOnReplayCommandlet.generated.h"
+
+/**
+* Replays a lock-on recording made with ds.LockOn.Record through the lock-on core, without a world.
+* Every recorded lock update is re-run from the recorded target positions and arm inputs: the range break, the
+* candidate query and screen pre-pass, scoring, selection and the soft-lock state machine. Any result that differs
+* from the recording is logged as a divergence. The core work is timed per frame and written to JSON.
+* Usage: DarkSoulsCamera -run=DSLockOnReplay -File=<recording> [-Iterations=1] [-Output=Saved/Benchmarks/DSLockOnReplay.json]
+* Returns non-zero if the recording can't be read or the replay diverged.
+*/
+UCLASS()
+class DARKSOULSCAMERA_API UDSLockOnReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDSLockOnReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USceneComponent;
+class UCurveFloat;
+
+/**
+* Lock-on candidates gathered for one query, stored as structure of arrays so they can be scored in batches.
+* Score arrays are filled by DSLockOnScoring::ScoreCandidates.
+*/
+struct DARKSOULSCAMERA_API FDSCandidateSet
+{
+	TArray<USceneComponent*> Targets;
+
+	/* Candidate positions */
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+
+	/* Bias added to Dot when picking a lock target */
+	TArray<float> Priority;
+
+	/* Input to the threat scoring curve */
+	TArray<float> Threat;
+
+	/* Dot product of the normalized candidate direction with the reference direction */
+	TArray<float> Dot;
+	/* Z component of Cross(Reference, CandidateDir). Negative is left of the reference, positive is right */
+	TArray<float> Side;
+	/* Distance from the query origin */
+	TArray<float> Distance;
+
+	/* Seconds since the arm last locked on to each candidate, and the weighted score. Filled by DSLockOnScoring::ScoreWithTables */
+	TArray<float> SinceTargeted;
+	TArray<float> Score;
+
+	/* Closeness to the screen center, from 0 at the inset edge to 1 at the center. Only filled by DSLockOnScoring::ScoreCandidatesOnScreen */
+	TArray<float> ScreenScore;
+
+	int32 Num() const { return Targets.Num(); }
+
+	/* True if the set went through the screen-space pre-pass, whose score then decides which candidates are in play */
+	bool HasScreenScores() const { return ScreenScore.Num() == Targets.Num() && Targets.Num() > 0; }
+
+	/* What selection ranks and gates candidates by without curves: the screen score after the screen pre-pass, Dot otherwise */
+	const TArray<float>& GetSelectionDot() const { return HasScreenScores() ? ScreenScore : Dot; }
+
+	/* Keeps a scored candidate in the set, but out of play for lock selection */
+	void Exclude(int32 Index);
+
+	void Reset();
+	void Add(USceneComponent* Target, float InX, float InY, float InZ, float InPriority = 0.f, float InThreat = 0.f);
+
+	/* Removes a candidate by swapping the last one into its place */
+	void RemoveAtSwap(int32 Index);
+};
+
+/* The last few targets an arm locked on to, and when */
+struct DARKSOULSCAMERA_API FDSRecentTargets
+{
+	enum { Capacity = 8 };
+
+	/* Records a lock on Target at Time, replacing the oldest entry once full */
+	void Add(const USceneComponent* Target, float Time);
+
+	/* Seconds between Target's last lock and Now, or MAX_flt if it isn't among the recent targets */
+	float GetSecondsSince(const USceneComponent* Target, float Now) const;
+
+	void Reset() { Targets.Reset(); Times.Reset(); }
+
+private:
+	TArray<const USceneComponent*, TInlineAllocator<Capacity>> Targets;
+	TArray<float, TInlineAllocator<Capacity>> Times;
+};
+
+namespace DSLockOnScoring
+{
+	/**
+	* Scores every candidate in Candidates against Reference, as seen from Origin.
+	* Processes four candidates per instruction where vector intrinsics are available, with a scalar tail.
+	*/
+	DARKSOULSCAMERA_API void ScoreCandidates(FDSCandidateSet& Candidates, const FVector& Origin, const FVector& Reference);
+
+	/* Vectorized kernel over raw arrays, DSLockOnCore::ScoreCandidates4 on SSE2 targets. Output arrays must hold Num entries */
+	DARKSOULSCAMERA_API void ScoreCandidates(const float* X, const float* Y, const float* Z, int32 Num, const FVector& Origin, const FVector& Reference, float* OutDot, float* OutSide, float* OutDistance);
+
+	/* Scalar reference kernel from the engine-independent core, matching GetSafeNormal followed by dot and cross products */
+	DARKSOULSCAMERA_API void ScoreCandidatesScalar(const float* X, const float* Y, const float* Z, int32 Num, const FVector& Origin, const FVector& Reference, float* OutDot, float* OutSide, float* OutDistance);
+
+	/**
+	* Screen-space pre-pass. Projects every candidate with ViewProjection, removes those behind the camera or outside
+	* the screen inset by ScreenMargin, and writes the rest's distance from the screen center to ScreenScore.
+	* Dot, Side and Distance are used as scratch, so ScoreCandidates must run after it for the world-space terms.
+	*/
+	DARKSOULSCAMERA_API void ScoreCandidatesOnScreen(FDSCandidateSet& Candidates, const FMatrix& ViewProjection, float ScreenMargin);
+
+	/* Vectorized projection to normalized device coordinates over raw arrays, DSLockOnCore::ProjectCandidates4 on SSE2 targets. Output arrays must hold Num entries */
+	DARKSOULSCAMERA_API void ProjectCandidates(const float* X, const float* Y, const float* Z, int32 Num, const FMatrix& ViewProjection, float* OutNDCX, float* OutNDCY, float* OutW);
+
+	/* Index of the candidate in play with the highest selection dot plus Priority, or INDEX_NONE. See FDSCandidateSet::GetSelectionDot */
+	DARKSOULSCAMERA_API int32 SelectLockTarget(const FDSCandidateSet& Candidates);
+
+	/**
+	* Weighted scoring through baked curve tables, after any candidates have been removed. Dot and Distance must already
+	* be scored in world space, whether or not the screen pre-pass ran. Reads each candidate's recency from RecentTargets
+	* and writes the result to Score.
+	*/
+	DARKSOULSCAMERA_API void ScoreWithTables(FDSCandidateSet& Candidates, const DSLockOnCore::FScoringTables& Tables, float MaxDistance, const FDSRecentTargets& RecentTargets, float Now);
+
+	/* Index of the candidate in play with the highest table score, or INDEX_NONE. After the screen pre-pass, on-screen candidates are in play, otherwise those in front of the reference */
+	DARKSOULSCAMERA_API int32 SelectLockTargetByScore(const FDSCandidateSet& Candidates);
+
+	/**
+	* Bakes Curve, sampled over [Min, Max], into Table. With bAngle the curve takes degrees from 0 to 180 and the table
+	* is indexed the way DSLockOnCore::FScoringTables::Angle expects. Without a curve the table is flat at 1.
+	*/
+	DARKSOULSCAMERA_API void BakeScoreTable(DSLockOnCore::FScoreTable& Table, const UCurveFloat* Curve, float Min, float Max, bool bAngle = false);
+
+	/* Index of the candidate on the requested side with the smallest angle to the reference direction, or INDEX_NONE */
+	DARKSOULSCAMERA_API int32 SelectSwitchTarget(const FDSCandidateSet& Candidates, const USceneComponent* CurrentTarget, bool bRight);
+}
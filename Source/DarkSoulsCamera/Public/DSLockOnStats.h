@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/**
+* Instrumentation for the camera lock-on system.
+* Cycle and counter stats appear under "stat DSLockOn" and in stats captures, and every timed scope also emits a
+* named event for external profilers. FDSLockOnCounters keeps running totals that commandlets can print without
+* the stats system. All of it compiles out in shipping builds.
+*/
+
+#define DS_LOCKON_STATS (!UE_BUILD_SHIPPING)
+
+DECLARE_STATS_GROUP(TEXT("DSLockOn"), STATGROUP_DSLockOn, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetTargetComponents"), STAT_DSLockOn_GetTargetComponents, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetLockTarget"), STAT_DSLockOn_GetLockTarget, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SwitchTarget"), STAT_DSLockOn_SwitchTarget, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LockArm TickComponent"), STAT_DSLockOn_TickComponent, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character TickActor"), STAT_DSLockOn_CharacterTick, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Tick"), STAT_DSLockOn_ManagerTick, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arm Probe"), STAT_DSLockOn_ArmProbe, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Target Registration"), STAT_DSLockOn_Registration, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Candidates Considered"), STAT_DSLockOn_Candidates, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock Acquisitions"), STAT_DSLockOn_Acquisitions, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock Breaks"), STAT_DSLockOn_Breaks, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Target Switches"), STAT_DSLockOn_Switches, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Arm Probe Sweeps"), STAT_DSLockOn_ArmProbeSweeps, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Arm Probe Reuses"), STAT_DSLockOn_ArmProbeReuses, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Targets Registered"), STAT_DSLockOn_TargetsRegistered, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Targets Queued"), STAT_DSLockOn_TargetsQueued, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Idle Soft-Lock Skips"), STAT_DSLockOn_SoftLockSkips, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Idle Soft-Lock Evaluations"), STAT_DSLockOn_SoftLockEvaluations, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Query Cache Hits"), STAT_DSLockOn_QueryCacheHits, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Query Cache Misses"), STAT_DSLockOn_QueryCacheMisses, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Lock Requests"), STAT_DSLockOn_NetRequests, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Lock State Updates"), STAT_DSLockOn_NetStateUpdates, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Lock Corrections"), STAT_DSLockOn_NetCorrections, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Lock State Bits"), STAT_DSLockOn_NetStateBits, STATGROUP_DSLockOn, DARKSOULSCAMERA_API);
+
+#if DS_LOCKON_STATS
+
+/* Running lock-on totals since the last Reset */
+struct DARKSOULSCAMERA_API FDSLockOnCounters
+{
+	enum EScope
+	{
+		GetTargetComponents,
+		GetLockTarget,
+		SwitchTarget,
+		TickComponent,
+		CharacterTick,
+		ManagerTick,
+		ArmProbe,
+		Registration,
+		NumScopes
+	};
+
+	/* Timed scopes only run on the game thread */
+	static uint64 ScopeCycles[NumScopes];
+	static int32 ScopeCalls[NumScopes];
+
+	/* Cycles spent in outermost scopes only, so nested scopes aren't counted twice */
+	static uint64 OuterCycles;
+	static int32 ScopeDepth;
+
+	/* Event counters, incremented atomically as candidates are also counted on worker threads */
+	static int32 Candidates;
+	static int32 Acquisitions;
+	static int32 Breaks;
+	static int32 Switches;
+
+	/* Synchronous spring arm sweeps while locked on, and frames that reused the previous probe instead */
+	static int32 ArmProbeSweeps;
+	static int32 ArmProbeReuses;
+
+	/* Targets added to the lock-on index, and the longest single pass over the registration queue */
+	static int32 TargetsRegistered;
+	static uint64 MaxRegistrationCycles;
+
+	/* Idle soft-lock logic updates skipped because nothing changed in the arm's range shell, and those that re-evaluated */
+	static int32 SoftLockSkips;
+	static int32 SoftLockEvaluations;
+
+	/* Lock arm range queries served from another arm's broad phase this frame, and broad phase queries run */
+	static int32 QueryCacheHits;
+	static int32 QueryCacheMisses;
+
+	/* Predictions the owning client sent to the server, replicated lock states received, and those that overrode a prediction */
+	static int32 NetRequests;
+	static int32 NetStateUpdates;
+	static int32 NetCorrections;
+
+	/* Bits of replicated lock state written by the server */
+	static int32 NetStateBits;
+
+	static void Reset();
+
+	/* Total milliseconds spent in lock-on code since the last Reset */
+	static double GetTotalMs();
+
+	/* Logs totals and per-frame averages over NumFrames */
+	static void LogSummary(int32 NumFrames);
+};
+
+/* Adds the lifetime of the scope to one of the FDSLockOnCounters scopes */
+struct FDSLockOnScopeTimer
+{
+	FDSLockOnScopeTimer(FDSLockOnCounters::EScope InScope)
+		: Scope(InScope)
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+		FDSLockOnCounters::ScopeDepth++;
+	}
+
+	~FDSLockOnScopeTimer()
+	{
+		const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+		FDSLockOnCounters::ScopeCycles[Scope] += Cycles;
+		FDSLockOnCounters::ScopeCalls[Scope]++;
+
+		if (--FDSLockOnCounters::ScopeDepth == 0)
+			FDSLockOnCounters::OuterCycles += Cycles;
+	}
+
+	FDSLockOnCounters::EScope Scope;
+	uint64 StartCycles;
+};
+
+#define DS_LOCKON_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_DSLockOn_##Name); \
+	SCOPED_NAMED_EVENT(DSLockOn_##Name, FColor::Cyan); \
+	FDSLockOnScopeTimer DSLockOnScopeTimer_##Name(FDSLockOnCounters::Name)
+
+#define DS_LOCKON_COUNT(Name, Amount) \
+	INC_DWORD_STAT_BY(STAT_DSLockOn_##Name, Amount); \
+	FPlatformAtomics::InterlockedAdd(&FDSLockOnCounters::Name, Amount)
+
+#else
+
+#define DS_LOCKON_SCOPE(Name)
+#define DS_LOCKON_COUNT(Name, Amount)
+
+#endif
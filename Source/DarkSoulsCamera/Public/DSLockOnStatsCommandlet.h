@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DSLockOnStatsCommandlet.generated.h"
+
+/**
+* Runs a map headless for a number of frames and prints a summary of the lock-on counters.
+* Usage: DarkSoulsCamera -run=DSLockOnStats -Map=/Game/Maps/ThirdPersonExampleMap [-Frames=600] [-DeltaSeconds=0.016667] -nullrhi
+*/
+UCLASS()
+class DARKSOULSCAMERA_API UDSLockOnStatsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDSLockOnStatsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DSLockOnCore.h"
+
+/**
+* Batched lock-on steering. The lock-on manager keeps a rotation spring per lock arm and steps those of every locked
+* pawn together, see DSLockOnCore::StepRotationSprings.
+*/
+namespace DSLockOnSteering
+{
+	/* Steps every spring, four at a time where vector intrinsics are available */
+	DARKSOULSCAMERA_API void StepRotationSprings(const DSLockOnCore::FRotationSprings& Springs, float DeltaSeconds);
+
+	/* Scalar reference for StepRotationSprings */
+	DARKSOULSCAMERA_API void StepRotationSpringsScalar(const DSLockOnCore::FRotationSprings& Springs, float DeltaSeconds);
+}
@@ -8,15 +8,49 @@
 
 /**
 * Targetable component used for camera lock-on system
-* For selection only.  Intentionally empty.
+* For selection only.  Registers itself with the world's lock-on manager while playing.
+* Creates a collision primitive. DSTargetPointComponent is the lighter choice for targets nothing collides with.
 */
 
 UCLASS(meta = (BlueprintSpawnableComponent))
 class DARKSOULSCAMERA_API UDSTargetComponent : public USphereComponent
 {
 	GENERATED_BODY()
-	
-	
-	
-	
+
+	friend class ADSLockOnManager;
+
+public:
+	/* Lock arms on the same team skip this target. 0 can be targeted by every arm. Read when the target registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		int32 Team;
+
+	/* Added to the target's facing score when picking a target to lock on to, so it wins close calls. Read when the target registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		float Priority;
+
+	/* Input to the lock arm's threat scoring curve, e.g. how dangerous the enemy is. Read when the target registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		float Threat;
+
+	/* Leaves the collision sphere's physics state to be created by the lock-on manager as it works through its registration
+	queue, within ds.LockOn.RegistrationBudgetMs, instead of when the component registers. Created straight away if
+	there is no manager to queue with */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		bool bDeferPhysicsState;
+
+	UDSTargetComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual bool ShouldCreatePhysicsState() const override;
+
+private:
+	/* Lets a deferred physics state be created, once the target is added or nothing is left to add it */
+	void ReleasePhysicsState();
+
+	/* Slot in the lock-on manager's target arrays, INDEX_NONE while unregistered or PendingLockOnIndex while queued */
+	int32 LockOnIndex;
+
+	/* Set once the lock-on manager has let the physics state be created */
+	bool bPhysicsStateReleased;
 };
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Uniform hash grid over lock-on target positions. The lock-on manager buckets one entry per target group.
+* Targets are identified by their index in the lock-on manager's arrays. Moving a target only touches the
+* cell it leaves and the cell it enters, and radius queries only visit cells overlapping the query bounds.
+*/
+class DARKSOULSCAMERA_API FDSTargetGrid
+{
+public:
+	FDSTargetGrid();
+
+	/* Sets the cell edge length. Clears the grid, so callers must re-add their targets */
+	void SetCellSize(float NewCellSize);
+	float GetCellSize() const { return CellSize; }
+
+	/* Adds a target. Index must equal the number of targets already in the grid */
+	void Add(int32 Index, const FVector& Location);
+
+	/* Removes Index, moving the last target into its slot to mirror TArray::RemoveAtSwap */
+	void RemoveAtSwap(int32 Index);
+
+	/* Updates a target's location. Returns true if it changed cell */
+	bool Move(int32 Index, const FVector& Location);
+
+	/* Appends the index of every target whose cell overlaps the box around Origin with half-extent Radius */
+	void Query(const FVector& Origin, float Radius, TArray<int32>& OutIndices) const;
+
+	void Reset();
+
+	/* Number of cells that have ever held a target. Emptied cells keep their storage for reuse */
+	int32 GetNumCells() const { return Cells.Num(); }
+
+	FIntVector GetCell(const FVector& Location) const
+	{
+		return FIntVector(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize), FMath::FloorToInt(Location.Z * InvCellSize));
+	}
+
+private:
+	void AddToCell(const FIntVector& Cell, int32 Index);
+	void RemoveFromCell(const FIntVector& Cell, int32 Index);
+
+	float CellSize;
+	float InvCellSize;
+
+	/* Target indices bucketed by cell */
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	/* Cell each target is currently bucketed in, indexed by target */
+	TArray<FIntVector> TargetCells;
+};
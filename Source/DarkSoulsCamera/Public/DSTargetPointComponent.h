@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "DSTargetPointComponent.generated.h"
+
+/**
+* Lightweight targetable point used for camera lock-on system.
+* Unlike DSTargetComponent it has no collision or physics body. It only registers its position, radius, team and
+* priority with the world's lock-on manager while playing. Add several to one actor for head, torso and weak-spot
+* lock points. Points on the same actor are culled together before they're scored.
+*/
+
+UCLASS(meta = (BlueprintSpawnableComponent))
+class DARKSOULSCAMERA_API UDSTargetPointComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+	friend class ADSLockOnManager;
+
+public:
+	/* Radius of the point, scaled with the component. The point is in lock range once this sphere touches it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		float Radius;
+
+	/* Lock arms on the same team skip this point. 0 can be targeted by every arm. Read when the point registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		int32 Team;
+
+	/* Added to the point's facing score when picking a target to lock on to, so it wins close calls. Read when the point registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		float Priority;
+
+	/* Input to the lock arm's threat scoring curve, e.g. how dangerous the enemy is. Read when the point registers */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lock On")
+		float Threat;
+
+	UDSTargetPointComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	float GetScaledRadius() const { return Radius * GetComponentTransform().GetMinimumAxisScale(); }
+
+private:
+	/* Slot in the lock-on manager's target arrays, INDEX_NONE while unregistered or PendingLockOnIndex while queued */
+	int32 LockOnIndex;
+};
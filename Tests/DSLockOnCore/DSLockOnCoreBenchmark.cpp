@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+/**
+* Lock-on core kernels at the candidate counts of the editor benchmark scenarios, 100 to 10,000.
+* Scalar only: the vectorized kernels need the engine's vector intrinsics and are compared in the editor.
+*/
+using namespace DSLockOnCore;
+
+namespace
+{
+	struct FCandidates
+	{
+		std::vector<float> X, Y, Z, Radius, Dot, Side, Distance, Threat, SinceTargeted, Priority, Score;
+		std::vector<int> Indices;
+
+		explicit FCandidates(int Num)
+		{
+			std::mt19937 Random(0x5EED);
+			std::uniform_real_distribution<float> Position(-5000.f, 5000.f);
+			std::uniform_real_distribution<float> Unit(0.f, 1.f);
+
+			for (int i = 0; i < Num; i++)
+			{
+				X.push_back(Position(Random));
+				Y.push_back(Position(Random));
+				Z.push_back(Unit(Random) * 400.f);
+				Radius.push_back(50.f);
+				Threat.push_back(Unit(Random) * 10.f);
+				SinceTargeted.push_back(Unit(Random) * 30.f);
+				Priority.push_back(0.f);
+				Indices.push_back(i);
+			}
+
+			Dot.resize(Num);
+			Side.resize(Num);
+			Distance.resize(Num);
+			Score.resize(Num);
+			ScoreCandidates(X.data(), Y.data(), Z.data(), Num, { 0.f, 0.f, 100.f }, { 1.f, 0.f, 0.f }, Dot.data(), Side.data(), Distance.data());
+		}
+	};
+
+	void BM_FilterInRange(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		FCandidates Candidates(Num);
+		std::vector<int> Found(Num);
+
+		for (auto _ : State)
+		{
+			const int NumFound = FilterInRange(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Candidates.Radius.data(),
+				Candidates.Indices.data(), Num, { 0.f, 0.f, 100.f }, 1500.f, Found.data());
+			benchmark::DoNotOptimize(NumFound);
+		}
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+
+	void BM_ScoreCandidates(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		FCandidates Candidates(Num);
+
+		for (auto _ : State)
+		{
+			ScoreCandidates(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, { 0.f, 0.f, 100.f }, { 0.f, 1.f, 0.f },
+				Candidates.Dot.data(), Candidates.Side.data(), Candidates.Distance.data());
+			benchmark::ClobberMemory();
+		}
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+
+	void BM_ProjectCandidates(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		FCandidates Candidates(Num);
+		std::vector<float> NDCX(Num), NDCY(Num), W(Num);
+
+		// A camera at the origin looking down +X, as FMatrix lays out a view followed by a perspective projection
+		const float ViewProjection[16] = {
+			0.f, 0.f, 0.f, 1.f,
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.7f, 0.f, 0.f,
+			0.f, 0.f, 10.f, 0.f };
+
+		for (auto _ : State)
+		{
+			ProjectCandidates(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, ViewProjection, NDCX.data(), NDCY.data(), W.data());
+			benchmark::ClobberMemory();
+		}
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+
+	void BM_SelectLockTarget(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		FCandidates Candidates(Num);
+
+		for (auto _ : State)
+			benchmark::DoNotOptimize(SelectLockTarget(Candidates.Dot.data(), Candidates.Priority.data(), Num));
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+
+	void BM_ScoreWithTables(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		FCandidates Candidates(Num);
+
+		FScoringTables Tables;
+		BakeScoreTable(Tables.Angle, 0.f, 1.f, [](float HalfChord) { return 1.f - HalfChord; });
+		BakeScoreTable(Tables.Distance, 0.f, 1.f, [](float Fraction) { return 1.f - Fraction * Fraction; });
+		BakeScoreTable(Tables.Threat, 0.f, 10.f, [](float Threat) { return Threat * .1f; });
+		BakeScoreTable(Tables.Recency, 0.f, 10.f, [](float Seconds) { return Seconds < 2.f ? -1.f : 0.f; });
+		Tables.AngleWeight = 1.f;
+		Tables.DistanceWeight = .5f;
+		Tables.ThreatWeight = .5f;
+		Tables.RecencyWeight = 1.f;
+
+		for (auto _ : State)
+		{
+			ScoreWithTables(Tables, Candidates.Dot.data(), Candidates.Distance.data(), Candidates.Threat.data(), Candidates.SinceTargeted.data(),
+				Candidates.Priority.data(), Num, 1500.f, Candidates.Score.data());
+			benchmark::DoNotOptimize(SelectByScore(Candidates.Dot.data(), Candidates.Score.data(), Num));
+		}
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+
+	void BM_StepRotationSprings(benchmark::State& State)
+	{
+		const int Num = (int)State.range(0);
+		std::mt19937 Random(0x5EED);
+		std::uniform_real_distribution<float> Angle(-3.f, 3.f);
+
+		// Yaw and pitch rotations chasing yaw targets, as locked pawns steering their control rotation do
+		std::vector<float> QX(Num), QY(Num), QZ(Num), QW(Num), VX(Num, 0.f), VY(Num, 0.f), VZ(Num, 0.f), TX(Num, 0.f), TY(Num, 0.f), TZ(Num), TW(Num), Frequency(Num, 10.f);
+		for (int i = 0; i < Num; i++)
+		{
+			const float Yaw = Angle(Random) * .5f, Pitch = Angle(Random) * .1f, TargetYaw = Angle(Random) * .5f;
+			QX[i] = -std::sin(Pitch) * std::sin(Yaw);
+			QY[i] = std::sin(Pitch) * std::cos(Yaw);
+			QZ[i] = std::cos(Pitch) * std::sin(Yaw);
+			QW[i] = std::cos(Pitch) * std::cos(Yaw);
+			TZ[i] = std::sin(TargetYaw);
+			TW[i] = std::cos(TargetYaw);
+		}
+
+		const FRotationSprings Springs = { QX.data(), QY.data(), QZ.data(), QW.data(), VX.data(), VY.data(), VZ.data(),
+			TX.data(), TY.data(), TZ.data(), TW.data(), Frequency.data(), Num };
+
+		for (auto _ : State)
+		{
+			StepRotationSprings(Springs, 1.f / 60.f);
+			benchmark::ClobberMemory();
+		}
+		State.SetItemsProcessed(State.iterations() * Num);
+	}
+}
+
+BENCHMARK(BM_FilterInRange)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ScoreCandidates)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ProjectCandidates)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_SelectLockTarget)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_ScoreWithTables)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_StepRotationSprings)->Arg(100)->Arg(1000)->Arg(10000);
@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace DSLockOnCore;
+
+namespace
+{
+	FTrackerConfig MakeTrackerConfig()
+	{
+		FTrackerConfig Config;
+		Config.Alpha = .5f;
+		Config.Beta = .4f;
+		Config.Gamma = .1f;
+		Config.MaxLeadDistance = 200.f;
+		Config.OvershootTolerance = 50.f;
+		return Config;
+	}
+
+	struct FQuat
+	{
+		float X, Y, Z, W;
+	};
+
+	FQuat MakeQuat(float AxisX, float AxisY, float AxisZ, float Angle)
+	{
+		const float Length = std::sqrt(AxisX * AxisX + AxisY * AxisY + AxisZ * AxisZ);
+		const float Scale = std::sin(Angle * .5f) / Length;
+		return { AxisX * Scale, AxisY * Scale, AxisZ * Scale, std::cos(Angle * .5f) };
+	}
+
+	/* Angle between two rotations in radians. 4 atan2(|A - B|, |A + B|) stays accurate near zero, where acos of the dot product doesn't */
+	float AngleBetween(const FQuat& A, const FQuat& B)
+	{
+		const float Sign = A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W < 0.f ? -1.f : 1.f;
+		const float DX = A.X - Sign * B.X, DY = A.Y - Sign * B.Y, DZ = A.Z - Sign * B.Z, DW = A.W - Sign * B.W;
+		const float SX = A.X + Sign * B.X, SY = A.Y + Sign * B.Y, SZ = A.Z + Sign * B.Z, SW = A.W + Sign * B.W;
+		return 4.f * std::atan2(std::sqrt(DX * DX + DY * DY + DZ * DZ + DW * DW), std::sqrt(SX * SX + SY * SY + SZ * SZ + SW * SW));
+	}
+
+	/* One spring and its target, laid out the way FRotationSprings expects */
+	struct FSpring
+	{
+		float QX, QY, QZ, QW, VX = 0.f, VY = 0.f, VZ = 0.f;
+		float TX, TY, TZ, TW, Frequency;
+
+		FSpring(const FQuat& Start, const FQuat& Target, float InFrequency)
+			: QX(Start.X), QY(Start.Y), QZ(Start.Z), QW(Start.W), TX(Target.X), TY(Target.Y), TZ(Target.Z), TW(Target.W), Frequency(InFrequency)
+		{
+		}
+
+		void Step(float DeltaSeconds)
+		{
+			const FRotationSprings Springs = { &QX, &QY, &QZ, &QW, &VX, &VY, &VZ, &TX, &TY, &TZ, &TW, &Frequency, 1 };
+			StepRotationSprings(Springs, DeltaSeconds);
+		}
+
+		FQuat GetRotation() const { return { QX, QY, QZ, QW }; }
+		FQuat GetTarget() const { return { TX, TY, TZ, TW }; }
+	};
+}
+
+TEST_CASE("The tracker locks on to a constant velocity", "[DSLockOnCore][Tracker]")
+{
+	const FTrackerConfig Config = MakeTrackerConfig();
+	FTargetTracker Tracker;
+	ResetTracker(Tracker, { 0.f, 0.f, 0.f });
+
+	const float DeltaSeconds = 1.f / 30.f;
+	for (int Frame = 1; Frame <= 300; Frame++)
+		UpdateTracker(Tracker, Config, { 300.f * DeltaSeconds * Frame, 0.f, 10.f }, DeltaSeconds);
+
+	CHECK(Tracker.Velocity.X == Approx(300.f).epsilon(1e-3));
+	CHECK(Tracker.Velocity.Z == Approx(0.f).margin(1e-3));
+	CHECK(Tracker.Acceleration.X == Approx(0.f).margin(.5));
+	CHECK(Tracker.Residual == Approx(0.f).margin(.01));
+
+	// A quarter second ahead of the last measurement
+	const FVec3 Predicted = PredictTarget(Tracker, Config, { 3000.f, 0.f, 10.f }, .25f);
+	CHECK(Predicted.X == Approx(3075.f).epsilon(1e-3));
+	CHECK(Predicted.Z == Approx(10.f).margin(1e-3));
+}
+
+TEST_CASE("The tracker ignores empty steps and resets to rest", "[DSLockOnCore][Tracker]")
+{
+	const FTrackerConfig Config = MakeTrackerConfig();
+	FTargetTracker Tracker;
+	ResetTracker(Tracker, { 1.f, 2.f, 3.f });
+
+	UpdateTracker(Tracker, Config, { 100.f, 100.f, 100.f }, 0.f);
+	CHECK(Tracker.Position.X == 1.f);
+	CHECK(Tracker.Velocity.X == 0.f);
+
+	const FVec3 Predicted = PredictTarget(Tracker, Config, { 1.f, 2.f, 3.f }, 1.f);
+	CHECK(Predicted.X == 1.f);
+	CHECK(Predicted.Y == 2.f);
+	CHECK(Predicted.Z == 3.f);
+}
+
+TEST_CASE("The tracker's lead is clamped and fades out on a direction change", "[DSLockOnCore][Tracker]")
+{
+	const FTrackerConfig Config = MakeTrackerConfig();
+	FTargetTracker Tracker;
+	ResetTracker(Tracker, { 0.f, 0.f, 0.f });
+	Tracker.Velocity = { 1000.f, 0.f, 0.f };
+
+	// One second at 1000 would lead by 1000, past the 200 limit
+	const FVec3 Clamped = PredictTarget(Tracker, Config, { 0.f, 0.f, 0.f }, 1.f);
+	CHECK(Clamped.X == Approx(200.f));
+
+	Tracker.Residual = 25.f;
+	CHECK(PredictTarget(Tracker, Config, { 0.f, 0.f, 0.f }, .1f).X == Approx(50.f));
+
+	Tracker.Residual = 60.f;
+	CHECK(PredictTarget(Tracker, Config, { 0.f, 0.f, 0.f }, .1f).X == 0.f);
+}
+
+TEST_CASE("A spring resting on its target stays there", "[DSLockOnCore][Springs]")
+{
+	const FQuat Target = MakeQuat(.3f, -.2f, 1.f, 1.2f);
+	FSpring Spring(Target, Target, 10.f);
+
+	for (int Step = 0; Step < 100; Step++)
+		Spring.Step(1.f / 60.f);
+
+	CHECK(AngleBetween(Spring.GetRotation(), Target) == Approx(0.f).margin(1e-6));
+	CHECK(Spring.VX == 0.f);
+}
+
+TEST_CASE("A spring settles smoothly through the small-angle limit", "[DSLockOnCore][Springs]")
+{
+	// Starts a few times the limit off target, so the steps cross from the full rotation maps to their limits
+	FSpring Spring(MakeQuat(0.f, 0.f, 1.f, 1.f + SpringSmallAngle * 4.f), MakeQuat(0.f, 0.f, 1.f, 1.f), 10.f);
+
+	float Previous = AngleBetween(Spring.GetRotation(), Spring.GetTarget());
+	for (int Step = 0; Step < 60; Step++)
+	{
+		Spring.Step(1.f / 60.f);
+
+		const float Error = AngleBetween(Spring.GetRotation(), Spring.GetTarget());
+		REQUIRE(std::isfinite(Spring.VZ));
+		REQUIRE(Error <= Previous + 1e-6f);
+		Previous = Error;
+	}
+
+	CHECK(Previous < 1e-6f);
+}
+
+TEST_CASE("A spring settles on its target without overshooting", "[DSLockOnCore][Springs]")
+{
+	FSpring Spring(MakeQuat(0.f, 0.f, 1.f, 0.f), MakeQuat(0.f, 0.f, 1.f, 2.f), 8.f);
+
+	float Previous = AngleBetween(Spring.GetRotation(), Spring.GetTarget());
+	for (int Step = 0; Step < 180; Step++)
+	{
+		Spring.Step(1.f / 60.f);
+
+		// Critically damped from rest, the error only ever shrinks
+		const float Error = AngleBetween(Spring.GetRotation(), Spring.GetTarget());
+		REQUIRE(Error <= Previous + 1e-6f);
+		Previous = Error;
+	}
+
+	CHECK(Previous < 1e-4f);
+}
+
+TEST_CASE("A spring takes the short way round", "[DSLockOnCore][Springs]")
+{
+	// The target is the same rotation as 90 degrees with its sign flipped, a quarter turn away, not three quarters
+	const FQuat Start = MakeQuat(0.f, 0.f, 1.f, 0.f);
+	const FQuat Quarter = MakeQuat(0.f, 0.f, 1.f, 1.5707963f);
+	FSpring Spring(Start, { -Quarter.X, -Quarter.Y, -Quarter.Z, -Quarter.W }, 10.f);
+
+	Spring.Step(1.f / 30.f);
+
+	// Still on the way from 0 towards 90 degrees about +Z. The result carries the target's sign, so it's flipped back first
+	const float Sign = Spring.QW < 0.f ? -1.f : 1.f;
+	const float Yaw = 2.f * std::atan2(Spring.QZ * Sign, Spring.QW * Sign);
+	CHECK(Yaw > 0.f);
+	CHECK(Yaw < 1.5707963f);
+}
+
+TEST_CASE("Spring steps don't depend on the frame rate", "[DSLockOnCore][Springs]")
+{
+	const FQuat Start = MakeQuat(.2f, .1f, 1.f, -.8f);
+	const FQuat Target = MakeQuat(-.3f, .4f, 1.f, 1.4f);
+
+	// One closed-form step over the whole second is the reference
+	FSpring Reference(Start, Target, 6.f);
+	Reference.Step(1.f);
+
+	for (const int Rate : { 30, 60, 144, 240 })
+	{
+		FSpring Spring(Start, Target, 6.f);
+		for (int Step = 0; Step < Rate; Step++)
+			Spring.Step(1.f / Rate);
+
+		INFO("Rate " << Rate);
+		CHECK(AngleBetween(Spring.GetRotation(), Reference.GetRotation()) < 1e-4f);
+		CHECK(Spring.VX == Approx(Reference.VX).margin(1e-3));
+		CHECK(Spring.VY == Approx(Reference.VY).margin(1e-3));
+		CHECK(Spring.VZ == Approx(Reference.VZ).margin(1e-3));
+	}
+}
+
+TEST_CASE("A spring trails a target turning at a constant rate by its lag", "[DSLockOnCore][Springs]")
+{
+	const float Frequency = 10.f;
+	const float TurnRate = 1.f;
+	const float DeltaSeconds = 1.f / 60.f;
+	const float Lag = GetSpringLagSeconds(Frequency);
+
+	// No lead, half the lag as the old exponential smoothing estimate gives, and the full lag
+	for (const float Lead : { 0.f, .5f * Lag, Lag })
+	{
+		FSpring Spring(MakeQuat(0.f, 0.f, 1.f, 0.f), MakeQuat(0.f, 0.f, 1.f, 0.f), Frequency);
+
+		// Three seconds is thirty time constants, long enough to settle
+		float Time = 0.f;
+		for (int Step = 0; Step < 180; Step++)
+		{
+			Time += DeltaSeconds;
+			const FQuat Target = MakeQuat(0.f, 0.f, 1.f, TurnRate * (Time + Lead));
+			Spring.TX = Target.X;
+			Spring.TY = Target.Y;
+			Spring.TZ = Target.Z;
+			Spring.TW = Target.W;
+			Spring.Step(DeltaSeconds);
+		}
+
+		// The target holds still through each step, which takes up to a step's turn off the lag
+		INFO("Lead " << Lead);
+		CHECK(AngleBetween(Spring.GetRotation(), MakeQuat(0.f, 0.f, 1.f, TurnRate * Time)) == Approx(TurnRate * (Lag - Lead)).margin(TurnRate * DeltaSeconds));
+	}
+}
+
+TEST_CASE("Springs in a batch step independently", "[DSLockOnCore][Springs]")
+{
+	const int Num = 5;
+	std::vector<FSpring> Single;
+	for (int i = 0; i < Num; i++)
+		Single.emplace_back(MakeQuat(1.f, (float)i, 0.f, .1f * i), MakeQuat(0.f, 1.f, (float)i, -.2f * i), 4.f + i);
+
+	std::vector<float> QX, QY, QZ, QW, VX(Num, 0.f), VY(Num, 0.f), VZ(Num, 0.f), TX, TY, TZ, TW, Frequency;
+	for (const FSpring& Spring : Single)
+	{
+		QX.push_back(Spring.QX); QY.push_back(Spring.QY); QZ.push_back(Spring.QZ); QW.push_back(Spring.QW);
+		TX.push_back(Spring.TX); TY.push_back(Spring.TY); TZ.push_back(Spring.TZ); TW.push_back(Spring.TW);
+		Frequency.push_back(Spring.Frequency);
+	}
+
+	const FRotationSprings Batch = { QX.data(), QY.data(), QZ.data(), QW.data(), VX.data(), VY.data(), VZ.data(),
+		TX.data(), TY.data(), TZ.data(), TW.data(), Frequency.data(), Num };
+	StepRotationSprings(Batch, .05f);
+
+	for (int i = 0; i < Num; i++)
+	{
+		Single[i].Step(.05f);
+		CHECK(QX[i] == Single[i].QX);
+		CHECK(QW[i] == Single[i].QW);
+		CHECK(VY[i] == Single[i].VY);
+	}
+}
@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace DSLockOnCore;
+
+TEST_CASE("FilterInRange keeps targets whose sphere touches the query sphere", "[DSLockOnCore][Range]")
+{
+	const float X[] = { 0.f, 100.f, 150.f, 300.f, -95.f };
+	const float Y[] = { 0.f, 0.f, 0.f, 0.f, 0.f };
+	const float Z[] = { 0.f, 0.f, 0.f, 0.f, 0.f };
+	const float Radius[] = { 0.f, 0.f, 60.f, 10.f, 0.f };
+	const int Indices[] = { 0, 1, 2, 3, 4 };
+	int Found[5];
+
+	const int NumFound = FilterInRange(X, Y, Z, Radius, Indices, 5, { 0.f, 0.f, 0.f }, 100.f, Found);
+
+	// 100 is exactly on the boundary, 150 reaches in with its radius, 300 doesn't
+	REQUIRE(NumFound == 4);
+	CHECK(Found[0] == 0);
+	CHECK(Found[1] == 1);
+	CHECK(Found[2] == 2);
+	CHECK(Found[3] == 4);
+}
+
+TEST_CASE("FilterInRange only tests the referenced targets and may filter in place", "[DSLockOnCore][Range]")
+{
+	const float X[] = { 0.f, 1000.f, 10.f, 20.f };
+	const float Y[] = { 0.f, 0.f, 0.f, 0.f };
+	const float Z[] = { 0.f, 0.f, 0.f, 0.f };
+	const float Radius[] = { 0.f, 0.f, 0.f, 0.f };
+	int Indices[] = { 3, 1, 2 };
+
+	const int NumFound = FilterInRange(X, Y, Z, Radius, Indices, 3, { 0.f, 0.f, 0.f }, 50.f, Indices);
+
+	REQUIRE(NumFound == 2);
+	CHECK(Indices[0] == 3);
+	CHECK(Indices[1] == 2);
+	CHECK(FilterInRange(X, Y, Z, Radius, Indices, 0, { 0.f, 0.f, 0.f }, 50.f, Indices) == 0);
+}
+
+TEST_CASE("ScoreCandidates measures facing, side and distance", "[DSLockOnCore][Scoring]")
+{
+	// Ahead, to the right, to the left, behind, and on the origin
+	const float X[] = { 100.f, 0.f, 0.f, -50.f, 10.f };
+	const float Y[] = { 0.f, 200.f, -300.f, 0.f, 0.f };
+	const float Z[] = { 0.f, 0.f, 0.f, 0.f, 0.f };
+	float Dot[5], Side[5], Distance[5];
+
+	ScoreCandidates(X, Y, Z, 5, { 10.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, Dot, Side, Distance);
+
+	CHECK(Dot[0] == Approx(1.f));
+	CHECK(Side[0] == Approx(0.f).margin(1e-6));
+	CHECK(Distance[0] == Approx(90.f));
+
+	CHECK(Dot[1] == Approx(-10.f / std::sqrt(100.f + 40000.f)));
+	CHECK(Side[1] > 0.f);
+	CHECK(Side[2] < 0.f);
+
+	CHECK(Dot[3] == Approx(-1.f));
+	CHECK(Distance[3] == Approx(60.f));
+
+	// A degenerate direction faces nowhere
+	CHECK(Dot[4] == 0.f);
+	CHECK(Side[4] == 0.f);
+	CHECK(Distance[4] == 0.f);
+}
+
+TEST_CASE("ProjectCandidates applies a row-major matrix to row vectors", "[DSLockOnCore][Scoring]")
+{
+	// Maps X to clip X, Y to clip Y and Z to clip W, so NDC = (X / Z, Y / Z)
+	const float ViewProjection[16] = {
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, 0.f, 1.f,
+		0.f, 0.f, 0.f, 0.f };
+	const float X[] = { 1.f, 3.f };
+	const float Y[] = { 2.f, 1.f };
+	const float Z[] = { 4.f, -2.f };
+	float NDCX[2], NDCY[2], W[2];
+
+	ProjectCandidates(X, Y, Z, 2, ViewProjection, NDCX, NDCY, W);
+
+	CHECK(NDCX[0] == Approx(.25f));
+	CHECK(NDCY[0] == Approx(.5f));
+	CHECK(W[0] == Approx(4.f));
+
+	// Behind the camera projects to the origin, marked by W
+	CHECK(NDCX[1] == 0.f);
+	CHECK(NDCY[1] == 0.f);
+	CHECK(W[1] == Approx(-2.f));
+}
+
+TEST_CASE("ScoreScreenPosition favours the screen center and culls the margin", "[DSLockOnCore][Scoring]")
+{
+	CHECK(ScoreScreenPosition(0.f, 0.f, 1.f, 0.f) == Approx(1.f));
+	CHECK(ScoreScreenPosition(1.f, 1.f, 1.f, 0.f) == Approx(0.f).margin(1e-6));
+	CHECK(ScoreScreenPosition(.2f, 0.f, 1.f, 0.f) > ScoreScreenPosition(.4f, 0.f, 1.f, 0.f));
+	CHECK(ScoreScreenPosition(0.f, 0.f, 0.f, 0.f) == -1.f);
+	CHECK(ScoreScreenPosition(.95f, 0.f, 1.f, .1f) == -1.f);
+	CHECK(ScoreScreenPosition(.85f, 0.f, 1.f, .1f) >= 0.f);
+}
+
+TEST_CASE("SelectLockTarget picks the most central candidate in front", "[DSLockOnCore][Selection]")
+{
+	const float Dot[] = { .5f, .9f, -1.f, .7f };
+	CHECK(SelectLockTarget(Dot, 4) == 1);
+	CHECK(SelectLockTarget(Dot, 0) == -1);
+
+	const float Behind[] = { -.1f, 0.f, -.9f };
+	CHECK(SelectLockTarget(Behind, 3) == -1);
+}
+
+TEST_CASE("SelectLockTarget with priorities ranks by dot plus priority", "[DSLockOnCore][Selection]")
+{
+	const float Dot[] = { .9f, .6f, -.5f };
+	const float Priority[] = { 0.f, .5f, 10.f };
+
+	// Priority lifts the second candidate past the first, but can't bring one behind the reference into play
+	CHECK(SelectLockTarget(Dot, Priority, 3) == 1);
+
+	const float Negative[] = { -1.f, -1.f, 0.f };
+	CHECK(SelectLockTarget(Dot, Negative, 3) == 0);
+
+	const float Behind[] = { -.1f, -.2f };
+	const float NoPriority[] = { 0.f, 0.f };
+	CHECK(SelectLockTarget(Behind, NoPriority, 2) == -1);
+}
+
+TEST_CASE("SelectSwitchTarget picks the most central candidate on the requested side", "[DSLockOnCore][Selection]")
+{
+	const float Dot[] = { 1.f, .8f, .9f, .5f, .95f };
+	const float Side[] = { 0.f, .3f, .2f, -.4f, -.1f };
+
+	CHECK(SelectSwitchTarget(Dot, Side, 5, 0, true) == 2);
+	CHECK(SelectSwitchTarget(Dot, Side, 5, 0, false) == 4);
+
+	// The current target is skipped even when it's on the requested side
+	CHECK(SelectSwitchTarget(Dot, Side, 5, 2, true) == 1);
+	CHECK(SelectSwitchTarget(Dot, Side, 1, 0, true) == -1);
+}
+
+TEST_CASE("LookupScore clamps to the table range and interpolates between samples", "[DSLockOnCore][Tables]")
+{
+	FScoreTable Table;
+	BakeScoreTable(Table, 0.f, 63.f, [](float Value) { return Value * 2.f; });
+
+	CHECK(LookupScore(Table, 0.f) == Approx(0.f));
+	CHECK(LookupScore(Table, 10.f) == Approx(20.f));
+	CHECK(LookupScore(Table, 10.25f) == Approx(20.5f));
+	CHECK(LookupScore(Table, 63.f) == Approx(126.f));
+	CHECK(LookupScore(Table, -5.f) == Approx(0.f));
+	CHECK(LookupScore(Table, 1000.f) == Approx(126.f));
+}
+
+TEST_CASE("LookupScore on an empty range returns the first sample", "[DSLockOnCore][Tables]")
+{
+	FScoreTable Table;
+	BakeScoreTable(Table, 5.f, 5.f, [](float) { return 3.f; });
+
+	CHECK(LookupScore(Table, 5.f) == Approx(3.f));
+	CHECK(LookupScore(Table, 100.f) == Approx(3.f));
+}
+
+TEST_CASE("ScoreWithTables sums weighted terms and skips disabled ones", "[DSLockOnCore][Tables]")
+{
+	FScoringTables Tables;
+	BakeScoreTable(Tables.Angle, 0.f, 1.f, [](float HalfChord) { return 1.f - HalfChord; });
+	BakeScoreTable(Tables.Distance, 0.f, 1.f, [](float Fraction) { return 1.f - Fraction; });
+	BakeScoreTable(Tables.Threat, 0.f, 10.f, [](float Threat) { return Threat; });
+	BakeScoreTable(Tables.Recency, 0.f, 10.f, [](float) { return 100.f; });
+	Tables.AngleWeight = 1.f;
+	Tables.DistanceWeight = 2.f;
+	Tables.ThreatWeight = .5f;
+	Tables.RecencyWeight = 0.f;
+
+	const float Dot[] = { 1.f, 0.f };
+	const float Distance[] = { 0.f, 500.f };
+	const float Threat[] = { 2.f, 8.f };
+	const float Priority[] = { .25f, 0.f };
+	float Score[2];
+
+	// A disabled term never reads its input
+	ScoreWithTables(Tables, Dot, Distance, Threat, nullptr, Priority, 2, 1000.f, Score);
+
+	// Facing: 1 + 2 * 1 + .5 * 2 + .25. At 90 degrees sin(45) indexes the angle table
+	CHECK(Score[0] == Approx(4.25f));
+	CHECK(Score[1] == Approx((1.f - std::sqrt(.5f)) + 2.f * .5f + .5f * 8.f).epsilon(1e-3));
+}
+
+TEST_CASE("SelectByScore only considers candidates in front", "[DSLockOnCore][Tables]")
+{
+	const float Dot[] = { .5f, -.5f, .1f };
+	const float Score[] = { 1.f, 10.f, 2.f };
+
+	CHECK(SelectByScore(Dot, Score, 3) == 2);
+	CHECK(SelectByScore(Dot, Score, 2) == 0);
+	CHECK(SelectByScore(Dot + 1, Score + 1, 1) == -1);
+}
+
+TEST_CASE("Range and sight breaks", "[DSLockOnCore][Selection]")
+{
+	CHECK_FALSE(IsOutOfRange(1000.f, 50.f, 900.f, 100.f));
+	CHECK(IsOutOfRange(1051.f, 50.f, 900.f, 100.f));
+	CHECK_FALSE(HasLostSight(.49f, .5f));
+	CHECK(HasLostSight(.5f, .5f));
+}
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <catch2/catch.hpp>
+
+using namespace DSLockOnCore;
+
+namespace
+{
+	FLockState MakeState(bool bLocked, bool bOutOfRange, bool bLostSight, bool bUseSoftLock, bool bSoftlockRequiresReset)
+	{
+		FLockState State;
+		State.bLocked = bLocked;
+		State.bOutOfRange = bOutOfRange;
+		State.bLostSight = bLostSight;
+		State.bUseSoftLock = bUseSoftLock;
+		State.bSoftlockRequiresReset = bSoftlockRequiresReset;
+		return State;
+	}
+
+	FGestureConfig MakeGestureConfig()
+	{
+		FGestureConfig Config;
+		Config.SwitchMouseDelta = 1.5f;
+		Config.BreakMouseDelta = 4.f;
+		Config.SwitchStickValue = .7f;
+		Config.SettleStickValue = .1f;
+		Config.MouseWindowSeconds = 1. / 60.;
+		Config.SwitchMinDelaySeconds = .5;
+		Config.MouseTurnScale = 1.f;
+		return Config;
+	}
+
+	FGestureState MakeGestureState()
+	{
+		FGestureState State;
+		State.LastSwitchTime = -1000.;
+		State.MouseWindowStart = -1000.;
+		State.bStickSettled = true;
+		return State;
+	}
+}
+
+TEST_CASE("A held lock stays until it goes out of range or sight", "[DSLockOnCore][LockState]")
+{
+	const FLockState Held = MakeState(true, false, false, false, false);
+	CHECK_FALSE(NeedsLockCandidate(Held));
+	CHECK(UpdateLockState(Held, true) == ELockAction::None);
+
+	CHECK(UpdateLockState(MakeState(true, true, false, false, false), true) == ELockAction::Break);
+	CHECK(UpdateLockState(MakeState(true, false, true, false, false), true) == ELockAction::Break);
+}
+
+TEST_CASE("Soft-lock moves a lost lock to a new candidate", "[DSLockOnCore][LockState]")
+{
+	const FLockState OutOfRange = MakeState(true, true, false, true, false);
+	CHECK(NeedsLockCandidate(OutOfRange));
+	CHECK(UpdateLockState(OutOfRange, true) == ELockAction::LockToCandidate);
+	CHECK(UpdateLockState(OutOfRange, false) == ELockAction::Break);
+
+	const FLockState LostSight = MakeState(true, false, true, true, false);
+	CHECK(UpdateLockState(LostSight, true) == ELockAction::LockToCandidate);
+}
+
+TEST_CASE("Unlocked hard-lock never acquires on its own", "[DSLockOnCore][LockState]")
+{
+	const FLockState Unlocked = MakeState(false, false, false, false, false);
+	CHECK_FALSE(NeedsLockCandidate(Unlocked));
+	CHECK(UpdateLockState(Unlocked, true) == ELockAction::None);
+}
+
+TEST_CASE("Soft-lock acquires candidates unless it was broken", "[DSLockOnCore][LockState]")
+{
+	const FLockState Idle = MakeState(false, false, false, true, false);
+	CHECK(NeedsLockCandidate(Idle));
+	CHECK(UpdateLockState(Idle, true) == ELockAction::LockToCandidate);
+
+	// A forcibly broken soft-lock waits for every candidate to leave range before it may re-acquire
+	const FLockState Broken = MakeState(false, false, false, true, true);
+	CHECK(UpdateLockState(Broken, true) == ELockAction::None);
+	CHECK(UpdateLockState(Broken, false) == ELockAction::ClearSoftlockReset);
+	CHECK(UpdateLockState(Idle, false) == ELockAction::ClearSoftlockReset);
+}
+
+TEST_CASE("Mouse gestures switch with a cooldown and break soft-lock", "[DSLockOnCore][Gestures]")
+{
+	const FGestureConfig Config = MakeGestureConfig();
+	FGestureState State = MakeGestureState();
+
+	CHECK(DetectMouseGesture(State, Config, 1., 2.f, false, false) == ELockGesture::None);
+	CHECK(DetectMouseGesture(State, Config, 1., 1.f, true, false) == ELockGesture::None);
+
+	CHECK(DetectMouseGesture(State, Config, 1., 2.f, true, false) == ELockGesture::SwitchRight);
+	CHECK(State.LastSwitchTime == 1.);
+	CHECK(State.MouseWindowStart == 1.);
+
+	// Still within the cooldown
+	CHECK(DetectMouseGesture(State, Config, 1.2, -2.f, true, false) == ELockGesture::None);
+	CHECK(DetectMouseGesture(State, Config, 1.6, -2.f, true, false) == ELockGesture::SwitchLeft);
+
+	// A harsh movement only breaks soft-lock. With hard-lock it's just a switch
+	CHECK(DetectMouseGesture(State, Config, 3., 5.f, true, true) == ELockGesture::BreakLock);
+	CHECK(DetectMouseGesture(State, Config, 4., 5.f, true, false) == ELockGesture::SwitchRight);
+}
+
+TEST_CASE("Raw mouse deltas are scaled to turn axis units", "[DSLockOnCore][Gestures]")
+{
+	FGestureConfig Config = MakeGestureConfig();
+	Config.MouseTurnScale = .07f;
+	FGestureState State = MakeGestureState();
+
+	// 20 pixels is 1.4 axis units, under the switch threshold. 30 is 2.1, over it
+	CHECK(DetectMouseGesture(State, Config, 1., 20.f, true, false) == ELockGesture::None);
+	CHECK(DetectMouseGesture(State, Config, 1., -30.f, true, false) == ELockGesture::SwitchLeft);
+	CHECK(DetectMouseGesture(State, Config, 2., 60.f, true, true) == ELockGesture::BreakLock);
+}
+
+TEST_CASE("The mouse window starts after the input a gesture used", "[DSLockOnCore][Gestures]")
+{
+	const FGestureConfig Config = MakeGestureConfig();
+	FGestureState State = MakeGestureState();
+
+	CHECK(GetMouseWindowStart(State, Config, 1.) == Approx(1. - Config.MouseWindowSeconds));
+
+	State.MouseWindowStart = 1.;
+	CHECK(GetMouseWindowStart(State, Config, 1.005) == 1.);
+}
+
+TEST_CASE("Stick switches need the stick to settle in between", "[DSLockOnCore][Gestures]")
+{
+	const FGestureConfig Config = MakeGestureConfig();
+	FGestureState State = MakeGestureState();
+
+	CHECK(DetectStickGesture(State, Config, 1., .9f, false) == ELockGesture::None);
+	CHECK(DetectStickGesture(State, Config, 1., .5f, true) == ELockGesture::None);
+
+	CHECK(DetectStickGesture(State, Config, 1., -.9f, true) == ELockGesture::SwitchLeft);
+	CHECK(DetectStickGesture(State, Config, 1.1, -.9f, true) == ELockGesture::None);
+	CHECK(DetectStickGesture(State, Config, 1.2, .4f, true) == ELockGesture::None);
+	CHECK(DetectStickGesture(State, Config, 1.3, .05f, true) == ELockGesture::None);
+	CHECK(DetectStickGesture(State, Config, 1.4, .9f, true) == ELockGesture::SwitchRight);
+}
+
+TEST_CASE("A stick switch starts the mouse switch cooldown", "[DSLockOnCore][Gestures]")
+{
+	const FGestureConfig Config = MakeGestureConfig();
+	FGestureState State = MakeGestureState();
+
+	CHECK(DetectStickGesture(State, Config, 2., .9f, true) == ELockGesture::SwitchRight);
+	CHECK(State.LastSwitchTime == 2.);
+	CHECK(DetectMouseGesture(State, Config, 2.1, 2.f, true, false) == ELockGesture::None);
+	CHECK(DetectMouseGesture(State, Config, 2.6, 2.f, true, false) == ELockGesture::SwitchRight);
+}
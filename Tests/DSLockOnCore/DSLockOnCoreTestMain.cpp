@@ -0,0 +1,4 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DSLockOnCore.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DSLockOnCore;
+
+#if DS_LOCKON_SSE
+
+namespace
+{
+	/* Candidate counts from 0 to 13 and on to a large batch, so every length of scalar tail is covered */
+	const int CandidateCounts[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 1027 };
+
+	/* Offsets from the origin the engine's GetSafeNormal treats specially: none, far below and around its tolerance, and unit */
+	const float SpecialLengths[] = { 0.f, 1.e-8f, 9.9e-5f, 1.e-4f, 1.01e-4f, 1.f };
+
+	struct FCandidates
+	{
+		std::vector<float> X, Y, Z;
+	};
+
+	/* Random candidates around Origin, with every third one placed at one of the special lengths along an axis or a diagonal */
+	FCandidates MakeCandidates(std::mt19937& Random, int Num, const FVec3& Origin)
+	{
+		std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+		std::uniform_real_distribution<float> Distance(1.f, 5000.f);
+
+		FCandidates Candidates;
+		for (int i = 0; i < Num; i++)
+		{
+			FVec3 Offset;
+			if (i % 3 == 0)
+			{
+				const float Length = SpecialLengths[(i / 3) % 6];
+				Offset = (i / 18) % 2 == 0 ? FVec3{ 0.f, Length, 0.f } : FVec3{ Length * .6f, 0.f, Length * .8f };
+			}
+			else
+			{
+				Offset = { Unit(Random), Unit(Random), Unit(Random) };
+				const float Scale = Distance(Random) / std::max(std::sqrt(Offset.X * Offset.X + Offset.Y * Offset.Y + Offset.Z * Offset.Z), 1.e-3f);
+				Offset = { Offset.X * Scale, Offset.Y * Scale, Offset.Z * Scale };
+			}
+
+			Candidates.X.push_back(Origin.X + Offset.X);
+			Candidates.Y.push_back(Origin.Y + Offset.Y);
+			Candidates.Z.push_back(Origin.Z + Offset.Z);
+		}
+		return Candidates;
+	}
+
+	/* Relative to the magnitude of the values, so long distances get the same share of slack as unit directions */
+	bool IsNearlyEqual(float A, float B)
+	{
+		return std::fabs(A - B) <= 1.e-5f * std::max({ 1.f, std::fabs(A), std::fabs(B) });
+	}
+}
+
+TEST_CASE("The 4-wide scoring kernel matches the scalar one", "[DSLockOnCore][Scoring][Vector]")
+{
+	std::mt19937 Random(0x5C0E);
+
+	// Away from the world origin the smallest offsets round to the float spacing there, which both kernels see alike
+	const FVec3 Origins[] = { { 0.f, 0.f, 0.f }, { 1024.f, -512.f, 96.f } };
+
+	for (const FVec3& Origin : Origins)
+	{
+		for (const int Num : CandidateCounts)
+		{
+			const FVec3 Reference = { .6f, -.64f, .48f };
+			const FCandidates Candidates = MakeCandidates(Random, Num, Origin);
+
+			std::vector<float> Dot(Num), Side(Num), Distance(Num), ScalarDot(Num), ScalarSide(Num), ScalarDistance(Num);
+
+			// As the engine runs it: whole groups of four, then the scalar tail
+			const int NumVector = ScoreCandidates4(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, Origin, Reference, Dot.data(), Side.data(), Distance.data());
+			REQUIRE(NumVector == Num / 4 * 4);
+			ScoreCandidates(Candidates.X.data() + NumVector, Candidates.Y.data() + NumVector, Candidates.Z.data() + NumVector, Num - NumVector, Origin, Reference,
+				Dot.data() + NumVector, Side.data() + NumVector, Distance.data() + NumVector);
+
+			ScoreCandidates(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, Origin, Reference, ScalarDot.data(), ScalarSide.data(), ScalarDistance.data());
+
+			for (int i = 0; i < Num; i++)
+			{
+				INFO("Candidate " << i << " of " << Num << " at (" << Candidates.X[i] << ", " << Candidates.Y[i] << ", " << Candidates.Z[i] << ")");
+				CHECK(IsNearlyEqual(Dot[i], ScalarDot[i]));
+				CHECK(IsNearlyEqual(Side[i], ScalarSide[i]));
+				CHECK(IsNearlyEqual(Distance[i], ScalarDistance[i]));
+			}
+		}
+	}
+}
+
+TEST_CASE("The 4-wide scoring kernel normalizes special lengths as GetSafeNormal does", "[DSLockOnCore][Scoring][Vector]")
+{
+	// On the origin, far below the tolerance, around it and unit length, along Y
+	const float X[] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+	const float Y[] = { 0.f, 1.e-8f, 9.9e-5f, 1.e-4f, 1.01e-4f, 1.f, -1.f, 2.f };
+	const float Z[] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+	float Dot[8], Side[8], Distance[8], ScalarDot[8], ScalarSide[8], ScalarDistance[8];
+
+	REQUIRE(ScoreCandidates4(X, Y, Z, 8, { 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, Dot, Side, Distance) == 8);
+	ScoreCandidates(X, Y, Z, 8, { 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, ScalarDot, ScalarSide, ScalarDistance);
+
+	for (int i = 0; i < 8; i++)
+	{
+		INFO("Candidate " << i << " at length " << Y[i]);
+
+		// Which directions are degenerate must match exactly, or selection would differ between the kernels
+		CHECK((Dot[i] == 0.f) == (ScalarDot[i] == 0.f));
+		CHECK(Dot[i] == Approx(ScalarDot[i]).margin(1e-6));
+		CHECK(Side[i] == Approx(ScalarSide[i]).margin(1e-6));
+		CHECK(Distance[i] == Approx(ScalarDistance[i]).margin(1e-6));
+	}
+
+	// Unit directions are used as they are
+	CHECK(Dot[5] == 1.f);
+	CHECK(Dot[6] == -1.f);
+	CHECK(Distance[0] == 0.f);
+}
+
+TEST_CASE("The 4-wide projection kernel matches the scalar one", "[DSLockOnCore][Scoring][Vector]")
+{
+	std::mt19937 Random(0x960C);
+
+	// A perspective looking down +X from the origin, row-major for row vectors as FMatrix is. Depth isn't used
+	const float Near = 10.f, HalfFov = .3926991f, Aspect = 16.f / 9.f;
+	const float YScale = 1.f / std::tan(HalfFov);
+	const float ViewProjection[16] = {
+		0.f, 0.f, Near, 1.f,
+		YScale / Aspect, 0.f, 0.f, 0.f,
+		0.f, YScale, 0.f, 0.f,
+		0.f, 0.f, 0.f, 0.f };
+
+	for (const int Num : CandidateCounts)
+	{
+		// Candidates surround the camera, so some are behind it, some off screen and some on the camera plane
+		const FCandidates Candidates = MakeCandidates(Random, Num, { 0.f, 0.f, 0.f });
+
+		std::vector<float> NDCX(Num), NDCY(Num), W(Num), ScalarNDCX(Num), ScalarNDCY(Num), ScalarW(Num);
+
+		const int NumVector = ProjectCandidates4(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, ViewProjection, NDCX.data(), NDCY.data(), W.data());
+		REQUIRE(NumVector == Num / 4 * 4);
+		ProjectCandidates(Candidates.X.data() + NumVector, Candidates.Y.data() + NumVector, Candidates.Z.data() + NumVector, Num - NumVector, ViewProjection,
+			NDCX.data() + NumVector, NDCY.data() + NumVector, W.data() + NumVector);
+
+		ProjectCandidates(Candidates.X.data(), Candidates.Y.data(), Candidates.Z.data(), Num, ViewProjection, ScalarNDCX.data(), ScalarNDCY.data(), ScalarW.data());
+
+		for (int i = 0; i < Num; i++)
+		{
+			INFO("Candidate " << i << " of " << Num);
+
+			// Both sum the terms in the same order and divide exactly, so culling must agree
+			CHECK((W[i] > 0.f) == (ScalarW[i] > 0.f));
+			CHECK(IsNearlyEqual(W[i], ScalarW[i]));
+			CHECK(IsNearlyEqual(NDCX[i], ScalarNDCX[i]));
+			CHECK(IsNearlyEqual(NDCY[i], ScalarNDCY[i]));
+		}
+	}
+}
+
+#endif